@@ -14,7 +14,30 @@
  *
  * For further information, please consult the following pages:
  * - \ref Framing
+ * - \ref FrameWriter
+ * - \ref FrameBuffer
+ * - \ref StaticFraming
+ * - \ref GatherFraming
+ * - \ref Descriptor
+ * - \ref Decoding
+ * - \ref Dissection
+ * - \ref Registry
+ * - \ref SampleDecoding
+ * - \ref StateMachine
+ * - \ref LegoSensors
+ * - \ref Checksum
  * - \ref Magics
+ * - \ref HeaderOnly (header-only and single header builds)
+ *
+ * Components for hosted Linux environments are kept under \c linux/, and are
+ * not included by this header:
+ * - \ref Transport
+ * - \ref FrameRing (framed messages from a producer thread to the thread writing to a tty)
+ * - \ref TimerWheel (deadlines of thousands of sensors, behind a \c timerfd)
+ * - \ref IoBatch (reads and writes of many ports in one \c io_uring submission)
+ * - \ref SensorFarm (and the \c tools/sensor_farm daemon built on it)
+ * - \ref HostEmulator (and the \c tools/ev3_host load generator built on it)
+ * - \ref linux/gather_iovec.hpp (\c writev() output of \ref GatherFraming frames)
  *
  * For information on the EV3 UART protocol, users can visit:
  * - http://ev3.fantastic.computer/doxygen/UartProtocol.html (UART
@@ -37,6 +60,9 @@
  * - LEGO Ultrasonic distance sensor
  * - LEGO Gyro sensor
  *
+ * The handshakes of \ref LegoSensors are compared against them message by
+ * message by \c test/regression/reference_bitstreams.cpp
+ *
  * More submissions for reference bitstreams are welcome.
  *
  * \warning This library currently relies heavily on GCC defined builtins
@@ -50,6 +76,16 @@
 #define EV3UARTGENERATOR_HPP_
 
 #include <framing.hpp>
+#include <frame_writer.hpp>
+#include <frame_buffer.hpp>
+#include <gather_framing.hpp>
+#include <decoding.hpp>
+#include <dissector.hpp>
+#include <sensor_registry.hpp>
+#include <sample_decoding.hpp>
+#include <sensor_descriptor.hpp>
+#include <sensor_state_machine.hpp>
+#include <lego_sensors.hpp>
 
 
 #endif /* EV3UARTGENERATOR_HPP_ */
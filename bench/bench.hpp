@@ -0,0 +1,208 @@
+/**
+ * \file bench.hpp
+ *
+ * Minimal self-contained benchmark harness used by the benchmarks
+ * under \c bench/
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#ifndef BENCH_HPP_
+#define BENCH_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Bench {
+	/**
+	 * Prevents the compiler from optimizing away the computation of \c value.
+	 */
+	template <typename T>
+	inline void do_not_optimize(const T& value) {
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+	/**
+	 * Forces the compiler to assume that all memory has been read and
+	 * written, so that stores to buffers are not optimized away.
+	 */
+	inline void clobber() {
+		asm volatile("" : : : "memory");
+	}
+
+	/**
+	 * Result of a single benchmark.
+	 */
+	struct Result {
+		std::string name; ///< Name of the benchmark
+		uint32_t param; ///< Parameter of the benchmark, usually the payload size
+		uint64_t iterations; ///< Number of operations timed in the best run
+		double ns_per_op; ///< Nanoseconds per operation, in the best run
+		double bytes_per_second; ///< Bytes produced / consumed per second, in the best run
+		std::vector<std::pair<std::string, double>> metrics; ///< Further measurements attached by the benchmark, see Suite::metric()
+	};
+
+	/**
+	 * A set of benchmarks, reported together.
+	 *
+	 * Command line options understood:
+	 * - \c --text: print a table instead of JSON
+	 * - \c --filter=SUBSTRING: only run benchmarks with names containing
+	 *   \c SUBSTRING
+	 * - \c --min-time-ms=N: minimum duration of each timed run (default 50)
+	 * - \c --runs=N: number of timed runs, of which the fastest is reported
+	 *   (default 3)
+	 */
+	class Suite {
+	public:
+		Suite(const char* name, int argc, char** argv)
+			: suite_name { name } {
+			for (int i = 1; i < argc; i++) {
+				if (std::strcmp(argv[i], "--text") == 0)
+					text = true;
+				else if (std::strncmp(argv[i], "--filter=", 9) == 0)
+					filter = argv[i] + 9;
+				else if (std::strncmp(argv[i], "--min-time-ms=", 14) == 0)
+					min_time = std::chrono::milliseconds(
+							std::atoi(argv[i] + 14));
+				else if (std::strncmp(argv[i], "--runs=", 7) == 0)
+					runs = std::atoi(argv[i] + 7);
+			}
+		}
+
+		/**
+		 * Times \c op, which performs one operation per call.
+		 *
+		 * @param name name of the benchmark
+		 * @param param parameter of the benchmark
+		 * @param bytes_per_op bytes produced / consumed by each operation
+		 * @param op operation to time
+		 */
+		template <typename Op>
+		void run(const std::string& name, uint32_t param, size_t bytes_per_op,
+				Op&& op) {
+			run_batch(name, param, bytes_per_op, 1, op);
+		}
+
+		/**
+		 * Times \c op, which performs \c ops_per_call operations per call.
+		 * Results are reported per operation.
+		 *
+		 * @param name name of the benchmark
+		 * @param param parameter of the benchmark
+		 * @param bytes_per_op bytes produced / consumed by each operation
+		 * @param ops_per_call number of operations performed by each call
+		 * to \c op
+		 * @param op operations to time
+		 */
+		template <typename Op>
+		void run_batch(const std::string& name, uint32_t param,
+				size_t bytes_per_op, uint32_t ops_per_call, Op&& op) {
+			last_ran = false;
+			if (name.find(filter) == std::string::npos)
+				return;
+			last_ran = true;
+
+			using clock = std::chrono::steady_clock;
+			Result best { name, param, 0, 0.0, 0.0, { } };
+			for (int run = 0; run < runs; run++) {
+				uint64_t iterations { 1 };
+				clock::duration elapsed { };
+				for (;;) {
+					const clock::time_point start { clock::now() };
+					for (uint64_t i = 0; i < iterations; i++)
+						op();
+					elapsed = clock::now() - start;
+					if (elapsed >= min_time)
+						break;
+					iterations *= 2;
+				}
+
+				const double ns { std::chrono::duration<double, std::nano>(
+						elapsed).count() / (iterations * ops_per_call) };
+				if ((best.iterations == 0) || (ns < best.ns_per_op)) {
+					best.iterations = iterations * ops_per_call;
+					best.ns_per_op = ns;
+					best.bytes_per_second = (bytes_per_op * 1e9) / ns;
+				}
+			}
+			results.push_back(best);
+		}
+
+		/**
+		 * Attaches a measurement to the result of the last benchmark run,
+		 * such as a number of system calls per operation. Does nothing if
+		 * the last benchmark was filtered out.
+		 *
+		 * @param name name of the measurement
+		 * @param value value of the measurement
+		 */
+		void metric(const std::string& name, double value) {
+			if (last_ran)
+				results.back().metrics.emplace_back(name, value);
+		}
+
+		/**
+		 * Prints all results to \c stdout.
+		 *
+		 * The JSON output is stable: benchmarks are always reported in
+		 * the order they were run, with the same keys in the same order.
+		 * Benchmarks with metrics have an additional \c metrics object.
+		 *
+		 * @return exit code for \c main()
+		 */
+		int report() const {
+			if (text) {
+				std::printf("%-32s %6s %14s %14s\n", "benchmark", "param",
+						"ns/op", "MB/s");
+				for (const Result& r : results) {
+					std::printf("%-32s %6u %14.3f %14.3f", r.name.c_str(),
+							r.param, r.ns_per_op, r.bytes_per_second / 1e6);
+					for (const std::pair<std::string, double>& m : r.metrics)
+						std::printf("  %s=%.3f", m.first.c_str(), m.second);
+					std::printf("\n");
+				}
+				return 0;
+			}
+
+			std::printf("{\n  \"suite\": \"%s\",\n  \"schema\": 1,\n"
+					"  \"benchmarks\": [", suite_name);
+			for (size_t i = 0; i < results.size(); i++) {
+				const Result& r { results[i] };
+				std::printf("%s\n    { \"name\": \"%s\", \"param\": %u, "
+						"\"iterations\": %llu, \"ns_per_op\": %.3f, "
+						"\"bytes_per_second\": %.0f",
+						(i == 0) ? "" : ",", r.name.c_str(), r.param,
+						static_cast<unsigned long long>(r.iterations),
+						r.ns_per_op, r.bytes_per_second);
+				for (size_t m = 0; m < r.metrics.size(); m++)
+					std::printf("%s\"%s\": %.3f", (m == 0) ? ", \"metrics\": { "
+							: ", ", r.metrics[m].first.c_str(),
+							r.metrics[m].second);
+				std::printf("%s }", r.metrics.empty() ? "" : " }");
+			}
+			std::printf("\n  ]\n}\n");
+			return 0;
+		}
+
+	private:
+		const char* suite_name;
+		bool text { false };
+		std::string filter;
+		std::chrono::steady_clock::duration min_time {
+			std::chrono::milliseconds(50) };
+		int runs { 3 };
+		bool last_ran { false };
+		std::vector<Result> results;
+	};
+}
+
+#endif /* BENCH_HPP_ */
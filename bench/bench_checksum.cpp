@@ -0,0 +1,58 @@
+/**
+ * \file bench_checksum.cpp
+ *
+ * Micro-benchmark comparing the throughput of the checksum kernels in
+ * \ref checksum.hpp, on buffers from 1 KiB to 64 MiB.
+ *
+ * Prints results as JSON (or as a table with \c --text), see \ref bench.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include "bench.hpp"
+#include <checksum.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	struct Kernel {
+		const char* name;
+		uint8_t (*reduce)(const uint8_t*, size_t);
+	};
+
+	const Kernel kernels[] {
+		{ "xor_reduce_scalar", Checksum::xor_reduce_scalar },
+		{ "xor_reduce_words", Checksum::xor_reduce_words },
+#if defined(__SSE2__)
+		{ "xor_reduce_sse2", Checksum::xor_reduce_sse2 },
+#endif
+#if defined(__AVX2__)
+		{ "xor_reduce_avx2", Checksum::xor_reduce_avx2 },
+#endif
+#if defined(__ARM_NEON)
+		{ "xor_reduce_neon", Checksum::xor_reduce_neon },
+#endif
+		{ "xor_reduce", Checksum::xor_reduce },
+	};
+}
+
+int main(int argc, char** argv) {
+	Bench::Suite suite { "checksum", argc, argv };
+
+	for (size_t size = 0x400; size <= 0x4000000; size *= 4) {
+		std::vector<uint8_t> buf(size);
+		for (size_t i = 0; i < size; i++)
+			buf[i] = static_cast<uint8_t>(i * 0x9d);
+
+		for (const Kernel& kernel : kernels) {
+			suite.run(kernel.name, size, size, [&] {
+				Bench::do_not_optimize(kernel.reduce(buf.data(), buf.size()));
+			});
+		}
+	}
+	return suite.report();
+}
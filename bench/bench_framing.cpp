@@ -0,0 +1,233 @@
+/**
+ * \file bench_framing.cpp
+ *
+ * Benchmarks for every framing function in \ref framing.hpp, as well as
+ * for framing complete initialization handshakes.
+ *
+ * Prints results as JSON (or as a table with \c --text), see \ref bench.hpp
+ *
+ * The suite name records how payload lengths are computed, so that builds
+ * with different \c EV3UARTGENERATOR_LENGTH_LUT and
+ * \c EV3UARTGENERATOR_SOFT_CLZ settings can be compared.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include "bench.hpp"
+#include <framing.hpp>
+#include <sensor_descriptor.hpp>
+#include <lego_sensors.hpp>
+#include <gather_framing.hpp>
+#include <magics.hpp>
+#include <array>
+#include <numeric>
+#include <string>
+
+namespace {
+	using namespace EV3UartGenerator;
+	using Magics::INFO_DTYPE;
+	using Magics::INFO_SPAN;
+
+	constexpr uint16_t BATCH { 0x40 };
+
+#if EV3UARTGENERATOR_LENGTH_LUT
+	constexpr const char* LENGTHS { "lut" };
+#else
+	constexpr const char* LENGTHS { "clz" };
+#endif
+#if EV3UARTGENERATOR_SOFT_CLZ
+	constexpr const char* CLZ { "-soft" };
+#else
+	constexpr const char* CLZ { "" };
+#endif
+
+	/**
+	 * Names of every length in [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 */
+	std::array<std::string, Framing::PAYLOAD_SENSOR_TO_EV3_MAX + 1> names() {
+		std::array<std::string, Framing::PAYLOAD_SENSOR_TO_EV3_MAX + 1> n { };
+		for (uint8_t len = 0; len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; len++)
+			n[len] = std::string(len, 'A');
+		return n;
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::string name { std::string("framing/") + LENGTHS + CLZ };
+	Bench::Suite suite { name.c_str(), argc, argv };
+	std::array<uint8_t, Framing::BUFFER_MIN * BATCH> buffer { };
+	std::array<uint8_t, Framing::PAYLOAD_SENSOR_TO_EV3_MAX * BATCH> payload { };
+	std::iota(payload.begin(), payload.end(), 0);
+	uint8_t* const dest { buffer.data() };
+	const auto strings = names();
+	int8_t sz { 0 };
+
+	// Fixed size messages
+	sz = Framing::frame_sys_message(dest, Magics::SYS::ACK);
+	suite.run("frame_sys_message", 0, sz, [&] {
+		Bench::do_not_optimize(Framing::frame_sys_message(dest,
+				Magics::SYS::ACK));
+		Bench::clobber();
+	});
+	sz = Framing::frame_cmd_type_message(dest, 0x1d);
+	suite.run("frame_cmd_type_message", 1, sz, [&] {
+		Bench::do_not_optimize(Framing::frame_cmd_type_message(dest, 0x1d));
+		Bench::clobber();
+	});
+	sz = Framing::frame_cmd_modes_message(dest, 5, 2);
+	suite.run("frame_cmd_modes_message", 2, sz, [&] {
+		Bench::do_not_optimize(Framing::frame_cmd_modes_message(dest, 5, 2));
+		Bench::clobber();
+	});
+	sz = Framing::frame_cmd_speed_message(dest, 57600);
+	suite.run("frame_cmd_speed_message", 4, sz, [&] {
+		Bench::do_not_optimize(Framing::frame_cmd_speed_message(dest, 57600));
+		Bench::clobber();
+	});
+	sz = Framing::frame_cmd_select_message(dest, 3);
+	suite.run("frame_cmd_select_message", 1, sz, [&] {
+		Bench::do_not_optimize(Framing::frame_cmd_select_message(dest, 3));
+		Bench::clobber();
+	});
+	sz = Framing::frame_info_message_span(dest, 4, INFO_SPAN::SI, 0, 1020.1875);
+	suite.run("frame_info_message_span", 8, sz, [&] {
+		Bench::do_not_optimize(Framing::frame_info_message_span(dest, 4,
+				INFO_SPAN::SI, 0, 1020.1875));
+		Bench::clobber();
+	});
+	sz = Framing::frame_info_message_format(dest, 4, 3, INFO_DTYPE::S16, 4, 0);
+	suite.run("frame_info_message_format", 4, sz, [&] {
+		Bench::do_not_optimize(Framing::frame_info_message_format(dest, 4, 3,
+				INFO_DTYPE::S16, 4, 0));
+		Bench::clobber();
+	});
+
+	// Variable size messages, across all payload sizes
+	for (uint8_t len = Framing::PAYLOAD_MIN;
+			len <= Framing::PAYLOAD_EV3_TO_SENSOR_MAX; len++) {
+		sz = Framing::frame_cmd_write_message(dest, payload.data(), len);
+		suite.run("frame_cmd_write_message", len, sz, [&] {
+			Bench::do_not_optimize(Framing::frame_cmd_write_message(dest,
+					payload.data(), len));
+			Bench::clobber();
+		});
+	}
+	for (uint8_t len = Framing::PAYLOAD_MIN;
+			len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; len++) {
+		const char* name { strings[len].c_str() };
+		sz = Framing::frame_info_message_name(dest, 2, name);
+		suite.run("frame_info_message_name", len, sz, [&] {
+			Bench::do_not_optimize(Framing::frame_info_message_name(dest, 2,
+					name));
+			Bench::clobber();
+		});
+	}
+	for (uint8_t len = Framing::PAYLOAD_MIN; len <= Framing::SYMBOL_MAX;
+			len++) {
+		const char* symbol { strings[len].c_str() };
+		sz = Framing::frame_info_message_symbol(dest, 2, symbol);
+		suite.run("frame_info_message_symbol", len, sz, [&] {
+			Bench::do_not_optimize(Framing::frame_info_message_symbol(dest, 2,
+					symbol));
+			Bench::clobber();
+		});
+	}
+	for (uint8_t len = Framing::PAYLOAD_MIN;
+			len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; len++) {
+		sz = Framing::frame_data_message(dest, 1, payload.data(), len);
+		suite.run("frame_data_message", len, sz, [&] {
+			Bench::do_not_optimize(Framing::frame_data_message(dest, 1,
+					payload.data(), len));
+			Bench::clobber();
+		});
+	}
+	for (uint8_t len = Framing::PAYLOAD_MIN;
+			len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; len++) {
+		// Reported per message, for comparison with frame_data_message
+		const int32_t total { Framing::frame_data_messages(dest, 1,
+				payload.data(), len, BATCH) };
+		suite.run_batch("frame_data_messages", len, total / BATCH, BATCH, [&] {
+			Bench::do_not_optimize(Framing::frame_data_messages(dest, 1,
+					payload.data(), len, BATCH));
+			Bench::clobber();
+		});
+	}
+
+	for (uint8_t len = Framing::PAYLOAD_MIN;
+			len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; len++) {
+		// Payload is referenced in place, compare with frame_data_message
+		GatherFraming::GatherFrame frame;
+		sz = GatherFraming::gather_data_message(frame, 1, payload.data(), len);
+		suite.run("gather_data_message", len, sz, [&] {
+			Bench::do_not_optimize(GatherFraming::gather_data_message(frame, 1,
+					payload.data(), len));
+			Bench::clobber();
+		});
+	}
+
+	{
+		// Samples are packed from native integers, compare with
+		// frame_data_message of the same number of bytes
+		std::array<int16_t, Framing::PAYLOAD_SENSOR_TO_EV3_MAX / 2> samples { };
+		std::iota(samples.begin(), samples.end(), 0);
+		for (uint8_t count = 1; count <= samples.size(); count *= 2) {
+			sz = Framing::frame_data_samples(dest, 1, samples.data(), count,
+					Magics::INFO_DTYPE::S16);
+			suite.run("frame_data_samples/s16", count * 2, sz, [&] {
+				Bench::do_not_optimize(Framing::frame_data_samples(dest, 1,
+						samples.data(), count, Magics::INFO_DTYPE::S16));
+				Bench::clobber();
+			});
+		}
+	}
+
+	// Helpers, across all payload lengths at once
+	std::array<uint8_t, Framing::PAYLOAD_SENSOR_TO_EV3_MAX> lengths { };
+	std::iota(lengths.begin(), lengths.end(), Framing::PAYLOAD_MIN);
+	suite.run_batch("length_code", 0, 0, lengths.size(), [&] {
+		Bench::clobber();
+		uint8_t acc { 0 };
+		for (const uint8_t len : lengths)
+			acc ^= Framing::length_code(len);
+		Bench::do_not_optimize(acc);
+	});
+	suite.run_batch("padding_length", 0, 0, lengths.size(), [&] {
+		Bench::clobber();
+		uint8_t acc { 0 };
+		for (const uint8_t len : lengths)
+			acc ^= Framing::padding_length(len);
+		Bench::do_not_optimize(acc);
+	});
+
+	// Helpers
+	for (uint8_t len = Framing::PAYLOAD_MIN;
+			len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; len++) {
+		suite.run("checksum", len, len, [&] {
+			Bench::do_not_optimize(Framing::checksum(payload.data(), len));
+		});
+	}
+	for (uint8_t len = Framing::PAYLOAD_MIN;
+			len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; len++) {
+		const uint8_t padding { Framing::insert_padding(dest, len) };
+		suite.run("insert_padding", len, padding, [&] {
+			Bench::do_not_optimize(Framing::insert_padding(dest, len));
+			Bench::clobber();
+		});
+	}
+
+	// Complete handshakes
+	const Descriptor::SensorDescriptor& color_sensor { LegoSensors::COLOR };
+	const int16_t handshake_size { Descriptor::handshake_size(color_sensor) };
+	suite.run("frame_handshake/color", color_sensor.modes, handshake_size, [&] {
+		Bench::do_not_optimize(Descriptor::frame_handshake(dest, buffer.size(),
+				color_sensor));
+		Bench::clobber();
+	});
+	suite.run("handshake_size/color", color_sensor.modes, 0, [&] {
+		Bench::do_not_optimize(Descriptor::handshake_size(color_sensor));
+	});
+
+	return suite.report();
+}
@@ -0,0 +1,200 @@
+/**
+ * \file bench_io_batch.cpp
+ *
+ * Benchmark of the output of a sensor farm tick: one \c DATA message written
+ * to every port, with a \c write() per port, or as an \ref IoBatch (with
+ * plain system calls, and with \c io_uring where available). Ports are
+ * pseudo-terminals, drained by a second thread standing in for the EV3s.
+ *
+ * Times are reported per sensor, along with the metrics:
+ * - \c syscalls_per_sensor and \c syscalls_per_second: system calls made by
+ *   the writing thread
+ * - \c cpu_ns_per_sensor: CPU time of the process, less the thread
+ *   draining the ptys - including the worker threads of the \c io_uring
+ * - \c dropped_per_sensor: writes which failed with \c EAGAIN, because the
+ *   drain thread fell behind
+ *
+ * Prints results as JSON (or as a table with \c --text), see \ref bench.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include "bench.hpp"
+#include <linux/io_batch.hpp>
+#include <framing.hpp>
+#include <magics.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	constexpr size_t PORT_COUNTS[] { 0x10, 0x80 };
+
+	uint64_t cpu_ns(int who) {
+		struct rusage usage;
+		getrusage(who, &usage);
+		return (((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL)
+				+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+	}
+
+	/**
+	 * Raw, non-blocking pseudo-terminals, with the master sides read by a
+	 * thread until destroyed.
+	 */
+	class Ports {
+	public:
+		explicit Ports(size_t count)
+			: drain_cpu { 0 }, epoll { epoll_create1(EPOLL_CLOEXEC) },
+			  stop { false } {
+			for (size_t i = 0; i < count; i++) {
+				const int master { posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK) };
+				grantpt(master);
+				unlockpt(master);
+				const int slave { open(ptsname(master),
+						O_RDWR | O_NOCTTY | O_NONBLOCK) };
+				struct termios tio;
+				tcgetattr(slave, &tio);
+				cfmakeraw(&tio);
+				tcsetattr(slave, TCSANOW, &tio);
+
+				struct epoll_event event { };
+				event.events = EPOLLIN;
+				event.data.fd = master;
+				epoll_ctl(epoll, EPOLL_CTL_ADD, master, &event);
+				masters.push_back(master);
+				slaves.push_back(slave);
+			}
+			drain = std::thread { [this] { run(); } };
+		}
+
+		~Ports() {
+			stop = true;
+			drain.join();
+			for (size_t i = 0; i < slaves.size(); i++) {
+				close(slaves[i]);
+				close(masters[i]);
+			}
+			close(epoll);
+		}
+
+		std::vector<int> slaves;
+		std::atomic<uint64_t> drain_cpu; ///< CPU time of the drain thread, in ns
+
+	private:
+		void run() {
+			struct epoll_event events[0x40];
+			uint8_t buf[0x1000];
+			while (!stop) {
+				const int count { epoll_wait(epoll, events, 0x40, 10) };
+				for (int i = 0; i < count; i++) {
+					while (read(events[i].data.fd, buf, sizeof(buf)) > 0)
+						;
+				}
+				drain_cpu = cpu_ns(RUSAGE_THREAD);
+			}
+		}
+
+		std::vector<int> masters;
+		int epoll;
+		std::atomic<bool> stop;
+		std::thread drain;
+	};
+
+	/**
+	 * Times a tick, and attaches the metrics of the writing thread.
+	 *
+	 * @param tick writes the message to every port, and returns the number
+	 * of writes which failed with \c EAGAIN
+	 * @param syscalls returns the number of system calls made so far
+	 */
+	template <typename Tick, typename Syscalls>
+	void run_tick(Bench::Suite& suite, const std::string& name,
+			Ports& ports, uint8_t len, Tick&& tick, Syscalls&& syscalls) {
+		const uint32_t sensors { static_cast<uint32_t>(ports.slaves.size()) };
+		uint64_t ticks { 0 };
+		uint64_t dropped { 0 };
+		const uint64_t calls_before { syscalls() };
+		const uint64_t cpu_before { cpu_ns(RUSAGE_SELF) };
+		const uint64_t drain_before { ports.drain_cpu };
+		const std::chrono::steady_clock::time_point start {
+			std::chrono::steady_clock::now() };
+
+		suite.run_batch(name, sensors, len, sensors, [&] {
+			dropped += tick();
+			ticks++;
+		});
+
+		const double elapsed { std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start).count() };
+		const double cpu { static_cast<double>((cpu_ns(RUSAGE_SELF) - cpu_before)
+				- (ports.drain_cpu - drain_before)) };
+		const double calls { static_cast<double>(syscalls() - calls_before) };
+		const double ops { static_cast<double>(ticks * sensors) };
+		if (ops == 0)
+			return; // Filtered out
+		suite.metric("syscalls_per_sensor", calls / ops);
+		suite.metric("syscalls_per_second", calls / elapsed);
+		suite.metric("cpu_ns_per_sensor", cpu / ops);
+		suite.metric("dropped_per_sensor", dropped / ops);
+	}
+}
+
+int main(int argc, char** argv) {
+	Bench::Suite suite { "io_batch", argc, argv };
+
+	// RGB-RAW reading of a color sensor
+	const int16_t samples[] { 0x123, 0x234, 0x345 };
+	uint8_t message[Framing::BUFFER_MIN];
+	const uint8_t len { static_cast<uint8_t>(Framing::frame_data_samples(
+			message, 4, samples, 3, Magics::INFO_DTYPE::S16)) };
+
+	for (const size_t count : PORT_COUNTS) {
+		Ports ports { count };
+		const std::string suffix { "/" + std::to_string(count) };
+
+		uint64_t direct_calls { 0 };
+		run_tick(suite, "write/direct" + suffix, ports, len, [&] {
+			uint32_t dropped { 0 };
+			for (const int fd : ports.slaves) {
+				dropped += (write(fd, message, len) < 0) && (errno == EAGAIN);
+				direct_calls++;
+			}
+			return dropped;
+		}, [&] { return direct_calls; });
+
+		for (const Linux::IoBackend preferred : { Linux::IoBackend::SYSCALLS,
+				Linux::IoBackend::URING }) {
+			Linux::IoBatch batch { preferred };
+			if (batch.backend() != preferred) {
+				std::fprintf(stderr, "io_uring is unavailable, skipped\n");
+				continue;
+			}
+			const char* const name { (preferred == Linux::IoBackend::URING)
+					? "write/io_uring" : "write/batch_syscalls" };
+			run_tick(suite, name + suffix, ports, len, [&] {
+				for (const int fd : ports.slaves)
+					batch.write(fd, message, len);
+				uint32_t dropped { 0 };
+				if (batch.submit() == 0) {
+					for (size_t i = 0; i < batch.size(); i++)
+						dropped += batch.result(i) == -EAGAIN;
+				}
+				return dropped;
+			}, [&] { return batch.syscalls(); });
+		}
+	}
+	return suite.report();
+}
@@ -0,0 +1,99 @@
+/**
+ * \file bench_sample_decoding.cpp
+ *
+ * Micro-benchmark comparing the sample decoding kernels in
+ * \ref sample_decoding.hpp, on batches of 64 DATA messages (one per port of
+ * a fully populated host), for every data type and a range of element
+ * counts. Times are reported per message.
+ *
+ * Prints results as JSON (or as a table with \c --text), see \ref bench.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include "bench.hpp"
+#include <sample_decoding.hpp>
+#include <framing.hpp>
+#include <magics.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+	using namespace EV3UartGenerator;
+	using Magics::INFO_DTYPE;
+
+	constexpr uint16_t BATCH { 0x40 };
+
+	template <typename T>
+	struct Kernel {
+		const char* name;
+		int8_t (*decode)(const Decoding::Frame*, size_t,
+				const Registry::ModeInfo&, T*, size_t);
+	};
+
+	template <typename T>
+	std::vector<Kernel<T>> kernels() {
+		return {
+			{ "scalar", SampleDecoding::decode_columns_scalar<T> },
+#if defined(__SSE2__)
+			{ "sse2", SampleDecoding::decode_columns_sse2<T> },
+#endif
+#if defined(EV3UARTGENERATOR_SAMPLES_NEON)
+			{ "neon", SampleDecoding::decode_columns_neon<T> },
+#endif
+		};
+	}
+
+	/**
+	 * Frames a batch of DATA messages with \c elems samples each, and times
+	 * every kernel decoding them into sample arrays of type \c T.
+	 */
+	template <typename T>
+	void run(Bench::Suite& suite, const char* label, INFO_DTYPE data_type,
+			uint8_t sample_size, uint8_t elems) {
+		const uint8_t payload_size { static_cast<uint8_t>(elems * sample_size) };
+		std::vector<uint8_t> samples(BATCH * payload_size);
+		for (size_t i = 0; i < samples.size(); i++)
+			samples[i] = static_cast<uint8_t>(i * 0x9d);
+		std::vector<uint8_t> stream(BATCH * Framing::BUFFER_MIN);
+		const int32_t size { Framing::frame_data_messages(stream.data(), 0,
+				samples.data(), payload_size, BATCH) };
+		if (size < 0)
+			return;
+
+		// All messages of the batch have the same size
+		const uint8_t message_size { static_cast<uint8_t>(size / BATCH) };
+		std::vector<Decoding::Frame> frames;
+		for (uint16_t m = 0; m < BATCH; m++)
+			frames.push_back(Decoding::Frame { stream.data()
+				+ (m * message_size), message_size });
+
+		const Registry::ModeInfo info { elems, data_type, sample_size,
+			payload_size };
+		std::vector<T> columns(elems * BATCH);
+		for (const Kernel<T>& kernel : kernels<T>()) {
+			suite.run_batch(std::string(kernel.name) + "/" + label, elems,
+					payload_size, BATCH, [&] {
+						Bench::do_not_optimize(kernel.decode(frames.data(),
+								frames.size(), info, columns.data(), BATCH));
+						Bench::clobber();
+					});
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	Bench::Suite suite { "sample_decoding", argc, argv };
+
+	for (uint8_t elems : { 1, 2, 3, 4, 8 }) {
+		run<int16_t>(suite, "S8/int16", INFO_DTYPE::S8, 1, elems);
+		run<int16_t>(suite, "S16/int16", INFO_DTYPE::S16, 2, elems);
+		run<int32_t>(suite, "S16/int32", INFO_DTYPE::S16, 2, elems);
+		run<int32_t>(suite, "S32/int32", INFO_DTYPE::S32, 4, elems);
+		run<float>(suite, "S16/float", INFO_DTYPE::S16, 2, elems);
+		run<float>(suite, "F32/float", INFO_DTYPE::F32, 4, elems);
+	}
+	return suite.report();
+}
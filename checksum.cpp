@@ -0,0 +1,16 @@
+/**
+ * \file checksum.cpp
+ *
+ * Compiles the definitions in \ref checksum_impl.hpp, unless the library is
+ * header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <checksum.hpp>
+
+#if !EV3UARTGENERATOR_HEADER_ONLY
+#include <checksum_impl.hpp>
+#endif
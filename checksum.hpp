@@ -0,0 +1,136 @@
+/**
+ * \file checksum.hpp
+ *
+ * XOR reduction kernels used to calculate checksums over buffers of
+ * arbitrary length.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page Checksum
+ *
+ * The checksum of every UART protocol message is the XOR of all bytes of
+ * the message, XOR'd with \c 0xff. The library contains several kernels that
+ * calculate the XOR of all bytes in a buffer:
+ *
+ * Kernel | Availability
+ * ------ | ------------
+ * \ref EV3UartGenerator::Checksum::xor_reduce_scalar() "scalar" | Always
+ * \ref EV3UartGenerator::Checksum::xor_reduce_words() "words" | Always, processes one machine word at a time
+ * \ref EV3UartGenerator::Checksum::xor_reduce_sse2() "sse2" | When compiling with \c __SSE2__ defined
+ * \ref EV3UartGenerator::Checksum::xor_reduce_avx2() "avx2" | When compiling with \c __AVX2__ defined
+ * \ref EV3UartGenerator::Checksum::xor_reduce_neon() "neon" | When compiling with \c __ARM_NEON defined
+ *
+ * \ref EV3UartGenerator::Checksum::xor_reduce() uses the widest kernel
+ * available, selected at compile time. The scalar kernel is always used on
+ * AVR (Arduino) targets, or when \c EV3UARTGENERATOR_SCALAR_CHECKSUM is
+ * defined.
+ *
+ * \ref EV3UartGenerator::Framing::checksum() is implemented on top of
+ * \ref EV3UartGenerator::Checksum::xor_reduce(). For validating large
+ * buffers, such as captured bitstreams, \c xor_reduce() can be called
+ * directly, as it is not limited to 255 bytes.
+ *
+ * The kernels are declared in the file \ref checksum.hpp
+ */
+
+#ifndef CHECKSUM_HPP_
+#define CHECKSUM_HPP_
+
+#include <header_only.hpp>
+#include <stdint.h> // We can't include <cstdint> if we want to compile under Arduino
+#include <stddef.h>
+
+#if !defined(EV3UARTGENERATOR_SCALAR_CHECKSUM) && defined(__AVR__)
+#define EV3UARTGENERATOR_SCALAR_CHECKSUM
+#endif
+
+namespace EV3UartGenerator {
+namespace Checksum {
+	namespace Detail {
+		/**
+		 * Folds all bytes of a word into a single byte, by XOR.
+		 */
+		inline uint8_t fold(size_t word) {
+			for (uint8_t shift = (sizeof(word) * 4); shift >= 8; shift /= 2)
+				word ^= (word >> shift);
+			return static_cast<uint8_t>(word);
+		}
+	}
+
+	/**
+	 * Calculates the XOR of all bytes in a buffer, one byte at a time.
+	 *
+	 * @param buf source buffer
+	 * @param len length of the source buffer
+	 * @return XOR of \c len bytes in the source buffer
+	 */
+	uint8_t xor_reduce_scalar(const uint8_t* buf, size_t len);
+
+	/**
+	 * Calculates the XOR of all bytes in a buffer, one machine word at a time.
+	 *
+	 * @param buf source buffer, with no alignment requirements
+	 * @param len length of the source buffer
+	 * @return XOR of \c len bytes in the source buffer
+	 */
+	uint8_t xor_reduce_words(const uint8_t* buf, size_t len);
+
+#if defined(__SSE2__)
+	/**
+	 * Calculates the XOR of all bytes in a buffer, using SSE2 instructions.
+	 *
+	 * @param buf source buffer, with no alignment requirements
+	 * @param len length of the source buffer
+	 * @return XOR of \c len bytes in the source buffer
+	 */
+	uint8_t xor_reduce_sse2(const uint8_t* buf, size_t len);
+#endif
+
+#if defined(__AVX2__)
+	/**
+	 * Calculates the XOR of all bytes in a buffer, using AVX2 instructions.
+	 *
+	 * @param buf source buffer, with no alignment requirements
+	 * @param len length of the source buffer
+	 * @return XOR of \c len bytes in the source buffer
+	 */
+	uint8_t xor_reduce_avx2(const uint8_t* buf, size_t len);
+#endif
+
+#if defined(__ARM_NEON)
+	/**
+	 * Calculates the XOR of all bytes in a buffer, using NEON instructions.
+	 *
+	 * @param buf source buffer, with no alignment requirements
+	 * @param len length of the source buffer
+	 * @return XOR of \c len bytes in the source buffer
+	 */
+	uint8_t xor_reduce_neon(const uint8_t* buf, size_t len);
+#endif
+
+	/**
+	 * Calculates the XOR of all bytes in a buffer, using the widest kernel
+	 * available on the target.
+	 *
+	 * @param buf source buffer
+	 * @param len length of the source buffer
+	 * @return XOR of \c len bytes in the source buffer
+	 */
+	uint8_t xor_reduce(const uint8_t* buf, size_t len);
+
+	/**
+	 * @return name of the kernel used by xor_reduce()
+	 */
+	const char* kernel();
+}
+}
+
+#if EV3UARTGENERATOR_HEADER_ONLY
+#include <checksum_impl.hpp>
+#endif
+
+#endif /* CHECKSUM_HPP_ */
@@ -0,0 +1,191 @@
+/**
+ * \file checksum_impl.hpp
+ *
+ * Function definitions for functions in \ref checksum.hpp
+ *
+ * Compiled in \c checksum.cpp, or included by \ref checksum.hpp when the library
+ * is header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#ifndef CHECKSUM_IMPL_HPP_
+#define CHECKSUM_IMPL_HPP_
+
+#include <checksum.hpp>
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace EV3UartGenerator {
+namespace Checksum {
+	namespace Detail {
+		constexpr size_t VECTOR_MIN { 0x40 }; // Shorter buffers, such as single messages, are reduced faster one word at a time
+	}
+
+	EV3UARTGENERATOR_INLINE
+	uint8_t xor_reduce_scalar(const uint8_t* buf, size_t len) {
+		uint8_t acc { 0x00 };
+		for (size_t i = 0; i < len; i++)
+			acc ^= buf[i];
+		return acc;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	uint8_t xor_reduce_words(const uint8_t* buf, size_t len) {
+		size_t acc[4] { };
+		while (len >= sizeof(acc)) { // Independent accumulators for ILP
+			size_t words[4];
+			memcpy(reinterpret_cast<void*>(words),
+					reinterpret_cast<const void*>(buf), sizeof(words));
+			acc[0] ^= words[0];
+			acc[1] ^= words[1];
+			acc[2] ^= words[2];
+			acc[3] ^= words[3];
+			buf += sizeof(words);
+			len -= sizeof(words);
+		}
+		while (len >= sizeof(size_t)) {
+			size_t word;
+			memcpy(reinterpret_cast<void*>(&word),
+					reinterpret_cast<const void*>(buf), sizeof(word));
+			acc[0] ^= word;
+			buf += sizeof(word);
+			len -= sizeof(word);
+		}
+		return (Detail::fold(acc[0] ^ acc[1] ^ acc[2] ^ acc[3])
+				^ xor_reduce_scalar(buf, len));
+	}
+
+#if defined(__SSE2__)
+	EV3UARTGENERATOR_INLINE
+	uint8_t xor_reduce_sse2(const uint8_t* buf, size_t len) {
+		__m128i acc0 { _mm_setzero_si128() };
+		__m128i acc1 { _mm_setzero_si128() };
+		__m128i acc2 { _mm_setzero_si128() };
+		__m128i acc3 { _mm_setzero_si128() };
+		const __m128i* src { reinterpret_cast<const __m128i*>(buf) };
+		while (len >= 0x40) {
+			acc0 = _mm_xor_si128(acc0, _mm_loadu_si128(src + 0));
+			acc1 = _mm_xor_si128(acc1, _mm_loadu_si128(src + 1));
+			acc2 = _mm_xor_si128(acc2, _mm_loadu_si128(src + 2));
+			acc3 = _mm_xor_si128(acc3, _mm_loadu_si128(src + 3));
+			src += 4;
+			len -= 0x40;
+		}
+		while (len >= 0x10) {
+			acc0 = _mm_xor_si128(acc0, _mm_loadu_si128(src++));
+			len -= 0x10;
+		}
+		acc0 = _mm_xor_si128(_mm_xor_si128(acc0, acc1),
+				_mm_xor_si128(acc2, acc3));
+
+		uint8_t bytes[0x10];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), acc0);
+		return (xor_reduce_words(bytes, sizeof(bytes))
+				^ xor_reduce_words(reinterpret_cast<const uint8_t*>(src), len));
+	}
+#endif
+
+#if defined(__AVX2__)
+	EV3UARTGENERATOR_INLINE
+	uint8_t xor_reduce_avx2(const uint8_t* buf, size_t len) {
+		__m256i acc0 { _mm256_setzero_si256() };
+		__m256i acc1 { _mm256_setzero_si256() };
+		__m256i acc2 { _mm256_setzero_si256() };
+		__m256i acc3 { _mm256_setzero_si256() };
+		const __m256i* src { reinterpret_cast<const __m256i*>(buf) };
+		while (len >= 0x80) {
+			acc0 = _mm256_xor_si256(acc0, _mm256_loadu_si256(src + 0));
+			acc1 = _mm256_xor_si256(acc1, _mm256_loadu_si256(src + 1));
+			acc2 = _mm256_xor_si256(acc2, _mm256_loadu_si256(src + 2));
+			acc3 = _mm256_xor_si256(acc3, _mm256_loadu_si256(src + 3));
+			src += 4;
+			len -= 0x80;
+		}
+		while (len >= 0x20) {
+			acc0 = _mm256_xor_si256(acc0, _mm256_loadu_si256(src++));
+			len -= 0x20;
+		}
+		acc0 = _mm256_xor_si256(_mm256_xor_si256(acc0, acc1),
+				_mm256_xor_si256(acc2, acc3));
+
+		uint8_t bytes[0x20];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(bytes), acc0);
+		return (xor_reduce_words(bytes, sizeof(bytes))
+				^ xor_reduce_words(reinterpret_cast<const uint8_t*>(src), len));
+	}
+#endif
+
+#if defined(__ARM_NEON)
+	EV3UARTGENERATOR_INLINE
+	uint8_t xor_reduce_neon(const uint8_t* buf, size_t len) {
+		uint8x16_t acc0 { vdupq_n_u8(0) };
+		uint8x16_t acc1 { vdupq_n_u8(0) };
+		uint8x16_t acc2 { vdupq_n_u8(0) };
+		uint8x16_t acc3 { vdupq_n_u8(0) };
+		while (len >= 0x40) {
+			acc0 = veorq_u8(acc0, vld1q_u8(buf + 0x00));
+			acc1 = veorq_u8(acc1, vld1q_u8(buf + 0x10));
+			acc2 = veorq_u8(acc2, vld1q_u8(buf + 0x20));
+			acc3 = veorq_u8(acc3, vld1q_u8(buf + 0x30));
+			buf += 0x40;
+			len -= 0x40;
+		}
+		while (len >= 0x10) {
+			acc0 = veorq_u8(acc0, vld1q_u8(buf));
+			buf += 0x10;
+			len -= 0x10;
+		}
+		acc0 = veorq_u8(veorq_u8(acc0, acc1), veorq_u8(acc2, acc3));
+
+		uint8_t bytes[0x10];
+		vst1q_u8(bytes, acc0);
+		return (xor_reduce_words(bytes, sizeof(bytes))
+				^ xor_reduce_words(buf, len));
+	}
+#endif
+
+	EV3UARTGENERATOR_INLINE
+	uint8_t xor_reduce(const uint8_t* buf, size_t len) {
+#if defined(EV3UARTGENERATOR_SCALAR_CHECKSUM)
+		return xor_reduce_scalar(buf, len);
+#elif defined(__AVX2__)
+		return (len < Detail::VECTOR_MIN) ? xor_reduce_words(buf, len)
+				: xor_reduce_avx2(buf, len);
+#elif defined(__SSE2__)
+		return (len < Detail::VECTOR_MIN) ? xor_reduce_words(buf, len)
+				: xor_reduce_sse2(buf, len);
+#elif defined(__ARM_NEON)
+		return (len < Detail::VECTOR_MIN) ? xor_reduce_words(buf, len)
+				: xor_reduce_neon(buf, len);
+#else
+		return xor_reduce_words(buf, len);
+#endif
+	}
+
+	EV3UARTGENERATOR_INLINE
+	const char* kernel() {
+#if defined(EV3UARTGENERATOR_SCALAR_CHECKSUM)
+		return "scalar";
+#elif defined(__AVX2__)
+		return "avx2";
+#elif defined(__SSE2__)
+		return "sse2";
+#elif defined(__ARM_NEON)
+		return "neon";
+#else
+		return "words";
+#endif
+	}
+}
+}
+
+#endif /* CHECKSUM_IMPL_HPP_ */
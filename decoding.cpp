@@ -0,0 +1,151 @@
+/**
+ * \file decoding.cpp
+ *
+ * Function definitions for functions in \ref decoding.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <decoding.hpp>
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+namespace EV3UartGenerator {
+namespace Decoding {
+	uint8_t frame_size(const uint8_t type) {
+		const uint8_t len { Framing::payload_length(type) };
+		if (len > Framing::PAYLOAD_SENSOR_TO_EV3_MAX)
+			return 0x00; // Length code out of range
+
+		switch (type & MESSAGE_BASE_MASK) {
+		case static_cast<uint8_t>(Magics::SYS::SYS_BASE):
+			switch (static_cast<Magics::SYS>(type)) {
+			case Magics::SYS::SYNC:
+			case Magics::SYS::NACK:
+			case Magics::SYS::ACK:
+			case Magics::SYS::ESC:
+				return 0x01;
+			default:
+				return 0x00;
+			}
+		case static_cast<uint8_t>(Magics::CMD::CMD_BASE):
+			if ((type & MESSAGE_LOW_MASK)
+					> static_cast<uint8_t>(Magics::CMD::WRITE))
+				return 0x00;
+			return (0x02 + len);
+		case static_cast<uint8_t>(Magics::INFO::INFO_BASE):
+			return (0x03 + len); // Special case for INFO messages - INFO type byte after type byte
+		default:
+			return (0x02 + len);
+		}
+	}
+
+	FrameDecoder::FrameDecoder() {
+		reset();
+	}
+
+	void FrameDecoder::feed(const uint8_t* data, const size_t len) {
+		chunk = data;
+		chunk_len = len;
+	}
+
+	bool FrameDecoder::next(Frame& frame) {
+		if (partial_consumed != 0) {
+			// Release the message returned from the partial buffer previously
+			memmove(reinterpret_cast<void*>(partial),
+					reinterpret_cast<const void*>(partial + partial_consumed),
+					partial_len);
+			partial_consumed = 0;
+		}
+
+		if ((partial_len != 0) && next_partial(frame))
+			return true;
+
+		while (chunk_len != 0) {
+			const uint8_t size { frame_size(*chunk) };
+			if (size == 0) {
+				discarded_count++; // Not the start of a message - resynchronize
+				chunk++;
+				chunk_len--;
+			} else if (size > chunk_len) {
+				memcpy(reinterpret_cast<void*>(partial),
+						reinterpret_cast<const void*>(chunk), chunk_len);
+				partial_len = chunk_len;
+				chunk_len = 0;
+			} else if ((size != 0x01) &&
+					(Framing::checksum(chunk, size - 1) != chunk[size - 1])) {
+				checksum_error_count++;
+				discarded_count++;
+				chunk++;
+				chunk_len--;
+			} else {
+				frame.data = chunk;
+				frame.size = size;
+				chunk += size;
+				chunk_len -= size;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool FrameDecoder::next_partial(Frame& frame) {
+		while (partial_len != 0) {
+			const uint8_t size { frame_size(partial[0]) };
+			if (size == 0) {
+				discarded_count++; // Not the start of a message - resynchronize
+				drop_partial();
+				continue;
+			}
+
+			uint8_t taken { 0 };
+			if (size > partial_len) {
+				const uint8_t wanted { static_cast<uint8_t>(size - partial_len) };
+				taken = (wanted < chunk_len) ? wanted : chunk_len;
+				memcpy(reinterpret_cast<void*>(partial + partial_len),
+						reinterpret_cast<const void*>(chunk), taken);
+				if (taken != wanted) {
+					partial_len += taken;
+					chunk += taken;
+					chunk_len -= taken;
+					return false; // Chunk exhausted, message still incomplete
+				}
+			}
+
+			if ((size == 0x01) ||
+					(Framing::checksum(partial, size - 1) == partial[size - 1])) {
+				frame.data = partial;
+				frame.size = size;
+				partial_len = (partial_len + taken) - size;
+				partial_consumed = size;
+				chunk += taken;
+				chunk_len -= taken;
+				return true;
+			}
+
+			// Bad checksum - drop the first byte, and rescan the remaining
+			// bytes, which may still contain the start of a valid message.
+			// Bytes copied from the chunk are left in the chunk.
+			checksum_error_count++;
+			discarded_count++;
+			drop_partial();
+		}
+		return false;
+	}
+
+	void FrameDecoder::drop_partial() {
+		memmove(reinterpret_cast<void*>(partial),
+				reinterpret_cast<const void*>(partial + 1), --partial_len);
+	}
+
+	void FrameDecoder::reset() {
+		chunk = nullptr;
+		chunk_len = 0;
+		partial_len = 0;
+		partial_consumed = 0;
+		discarded_count = 0;
+		checksum_error_count = 0;
+	}
+}
+}
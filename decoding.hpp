@@ -0,0 +1,223 @@
+/**
+ * \file decoding.hpp
+ *
+ * Functions and classes that help to split streams of bytes received
+ * over the UART into individual messages.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page Decoding
+ *
+ * The library includes a streaming decoder that can be used to consume
+ * UART protocol messages, such as the messages sent from the EV3 to a sensor
+ * (\c CMD \c SELECT, \c CMD \c WRITE, \c SYS \c NACK keepalives), or the
+ * messages sent from a sensor to the EV3.
+ *
+ * Bytes are handed to the decoder in chunks of arbitrary size. Each complete
+ * message found in the chunk is returned as a \ref
+ * EV3UartGenerator::Decoding::Frame, which points directly into the chunk
+ * provided by the user - message bytes are not copied, and no memory is
+ * allocated.
+ *
+ * The only exception is a message that straddles two chunks: its bytes are
+ * collected in a small buffer (\ref EV3UartGenerator::Framing::BUFFER_MIN
+ * bytes) inside the decoder, and the returned \c Frame points into that
+ * buffer instead.
+ *
+ * Messages with invalid type bytes or checksums are discarded one byte at a
+ * time, until the decoder is synchronized to the start of a valid message
+ * again.
+ *
+ * Message lengths and checksums are computed with the same functions that
+ * are used to frame messages, declared in the file \ref framing.hpp
+ *
+ * The decoder is declared in the file \ref decoding.hpp
+ */
+
+#ifndef DECODING_HPP_
+#define DECODING_HPP_
+
+#include <framing.hpp>
+#include <magics.hpp>
+#include <stddef.h> // We can't include <cstddef> if we want to compile under Arduino
+
+namespace EV3UartGenerator {
+namespace Decoding {
+	constexpr uint8_t MESSAGE_BASE_MASK { 0xc0 }; ///< Bits of the message type byte that identify the message as a SYS, CMD, INFO or DATA message.
+	constexpr uint8_t MESSAGE_LOW_MASK { 0x07 }; ///< Bits of the message type byte that contain the command (CMD messages) or the mode index (INFO and DATA messages).
+
+	/**
+	 * Calculates the size of a message, given its message type byte.
+	 *
+	 * @param type message type byte
+	 * @return size of the whole message in bytes, including the
+	 * message type byte, INFO type byte, padding and checksum.
+	 * @retval 0 if \c type does not identify a valid message.
+	 */
+	uint8_t frame_size(const uint8_t type);
+
+	/**
+	 * View of a single message, pointing into memory that is not owned
+	 * by the view.
+	 */
+	struct Frame {
+		const uint8_t* data; ///< Pointer to the message type byte of the message
+		uint8_t size; ///< Size of the whole message, including checksum
+
+		/**
+		 * @return message type byte of the message
+		 */
+		uint8_t type() const {
+			return data[0];
+		}
+
+		/**
+		 * @return base magic value of the message, one of
+		 * \c SYS_BASE, \c CMD_BASE, \c INFO_BASE or \c DATA_BASE
+		 */
+		uint8_t base() const {
+			return (data[0] & MESSAGE_BASE_MASK);
+		}
+
+		/**
+		 * @return \c true if the message is a SYS message of type \c sys_type
+		 */
+		bool is(Magics::SYS sys_type) const {
+			return (data[0] == (static_cast<uint8_t>(Magics::SYS::SYS_BASE)
+					| static_cast<uint8_t>(sys_type)));
+		}
+
+		/**
+		 * @return \c true if the message is a CMD message of type \c cmd_type
+		 */
+		bool is(Magics::CMD cmd_type) const {
+			return (base() == static_cast<uint8_t>(Magics::CMD::CMD_BASE))
+					&& ((data[0] & MESSAGE_LOW_MASK)
+							== static_cast<uint8_t>(cmd_type));
+		}
+
+		/**
+		 * @return \c true if the message is an INFO message
+		 */
+		bool is_info() const {
+			return (base() == static_cast<uint8_t>(Magics::INFO::INFO_BASE));
+		}
+
+		/**
+		 * @return \c true if the message is a DATA message
+		 */
+		bool is_data() const {
+			return (base() == static_cast<uint8_t>(Magics::DATA::DATA_BASE));
+		}
+
+		/**
+		 * @return mode index [0, 7] for INFO and DATA messages
+		 */
+		uint8_t mode() const {
+			return (data[0] & MESSAGE_LOW_MASK);
+		}
+
+		/**
+		 * @return INFO type byte following the message type byte, for
+		 * INFO messages.
+		 */
+		uint8_t info_type() const {
+			return data[1];
+		}
+
+		/**
+		 * @return pointer to the first byte of the payload of the message
+		 */
+		const uint8_t* payload() const {
+			return data + (is_info() ? 0x02 : 0x01);
+		}
+
+		/**
+		 * @return length of the payload of the message, including padding.
+		 * @retval 0 for SYS messages, which contain no payload.
+		 */
+		uint8_t payload_size() const {
+			return (size > 0x01) ? Framing::payload_length(data[0]) : 0x00;
+		}
+	};
+
+	/**
+	 * Streaming decoder, splitting chunks of bytes into messages.
+	 *
+	 * Typical use:
+	 * \code
+	 * decoder.feed(chunk, chunk_len);
+	 * Decoding::Frame frame;
+	 * while (decoder.next(frame)) {
+	 *     // Use frame before the next call to next() / feed()
+	 * }
+	 * \endcode
+	 */
+	class FrameDecoder {
+	public:
+		FrameDecoder();
+
+		/**
+		 * Provides the next chunk of bytes to the decoder.
+		 *
+		 * Any bytes remaining in the previous chunk that have not yet been
+		 * returned by next() are discarded.
+		 *
+		 * @param data chunk of bytes, which must remain valid until
+		 * next() returns \c false
+		 * @param len length of the chunk
+		 */
+		void feed(const uint8_t* data, const size_t len);
+
+		/**
+		 * Decodes the next message from the current chunk.
+		 *
+		 * @param frame view to populate with the next message. The view
+		 * remains valid until the next call to next() or feed().
+		 * @retval true if a complete message was decoded into \c frame
+		 * @retval false if the current chunk has been exhausted. Any
+		 * partial message at the end of the chunk is retained, and is
+		 * completed with bytes from the next chunk.
+		 */
+		bool next(Frame& frame);
+
+		/**
+		 * Discards all state, including partial messages.
+		 */
+		void reset();
+
+		/**
+		 * @return number of bytes discarded because they did not
+		 * belong to any valid message
+		 */
+		uint32_t discarded() const {
+			return discarded_count;
+		}
+
+		/**
+		 * @return number of messages discarded due to invalid checksums
+		 */
+		uint32_t checksum_errors() const {
+			return checksum_error_count;
+		}
+
+	private:
+		bool next_partial(Frame& frame);
+		void drop_partial();
+
+		const uint8_t* chunk;
+		size_t chunk_len;
+		uint8_t partial[Framing::BUFFER_MIN];
+		uint8_t partial_len;
+		uint8_t partial_consumed;
+		uint32_t discarded_count;
+		uint32_t checksum_error_count;
+	};
+}
+}
+
+#endif /* DECODING_HPP_ */
@@ -0,0 +1,264 @@
+/**
+ * \file dissector.cpp
+ *
+ * Function definitions for functions in \ref dissector.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <dissector.hpp>
+#include <simple_endian.hpp>
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+namespace EV3UartGenerator {
+namespace Dissection {
+	namespace {
+		constexpr uint8_t INFO_NAME { 0x00 };
+		constexpr uint8_t INFO_SYMBOL { 0x04 };
+		constexpr uint8_t INFO_FORMAT { 0x80 };
+		constexpr uint8_t SPAN_SIZE { 0x08 }; ///< Two single precision floats
+		constexpr uint8_t FORMAT_SIZE { 0x04 }; ///< Elements, data type, width and decimals
+
+		void flag(Message& message, const Issue issue) {
+			message.issues |= static_cast<uint8_t>(issue);
+		}
+
+		/**
+		 * Checks that the payload holds at least \c needed bytes, and that
+		 * the bytes after them are zero.
+		 *
+		 * @return \c false if the payload is too short to be interpreted
+		 */
+		bool check_payload(Message& message, const uint16_t needed) {
+			const uint8_t size { message.frame.payload_size() };
+			if (size < needed) {
+				flag(message, Issue::LENGTH);
+				return false;
+			}
+			const uint8_t* const payload { message.frame.payload() };
+			for (uint16_t i = needed; i < size; i++) {
+				if (payload[i] != 0x00) {
+					flag(message, Issue::PADDING);
+					break;
+				}
+			}
+			return true;
+		}
+
+		/**
+		 * Copies a null terminated, or padded, string out of the payload.
+		 */
+		void read_text(Message& message) {
+			const uint8_t size { message.frame.payload_size() };
+			const uint8_t* const payload { message.frame.payload() };
+			uint8_t len { 0 };
+			while ((len < size) && (payload[len] != 0x00))
+				len++;
+			memcpy(message.text, payload, len);
+			message.text[len] = '\0';
+			check_payload(message, len);
+		}
+	}
+
+	int32_t Message::integer_sample(const uint8_t index) const {
+		const uint8_t* const sample { frame.payload()
+				+ (index * data_type_size(data_type)) };
+		switch (data_type) {
+		case Magics::INFO_DTYPE::S8:
+			return static_cast<int8_t>(sample[0]);
+		case Magics::INFO_DTYPE::S16:
+			return static_cast<int16_t>(SimpleEndian::load_le16(sample));
+		case Magics::INFO_DTYPE::S32:
+			return static_cast<int32_t>(SimpleEndian::load_le32(sample));
+		default:
+			return 0;
+		}
+	}
+
+	float Message::float_sample(const uint8_t index) const {
+		return SimpleEndian::load_le_f32(frame.payload()
+				+ (index * data_type_size(data_type)));
+	}
+
+	const char* data_type_name(const Magics::INFO_DTYPE data_type) {
+		switch (data_type) {
+		case Magics::INFO_DTYPE::S8:
+			return "DATA8";
+		case Magics::INFO_DTYPE::S16:
+			return "DATA16";
+		case Magics::INFO_DTYPE::S32:
+			return "DATA32";
+		case Magics::INFO_DTYPE::F32:
+			return "DATAF";
+		default:
+			return "?";
+		}
+	}
+
+	uint8_t data_type_size(const Magics::INFO_DTYPE data_type) {
+		switch (data_type) {
+		case Magics::INFO_DTYPE::S8:
+			return 1;
+		case Magics::INFO_DTYPE::S16:
+			return 2;
+		case Magics::INFO_DTYPE::S32:
+		case Magics::INFO_DTYPE::F32:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	Dissector::Dissector() {
+		reset();
+	}
+
+	void Dissector::reset() {
+		formats_seen = 0;
+		memset(elems, 0, sizeof(elems));
+		memset(data_types, 0, sizeof(data_types));
+	}
+
+	void Dissector::dissect(const Decoding::Frame& frame, Message& message) {
+		memset(&message, 0, sizeof(message));
+		message.frame = frame;
+		message.kind = "?";
+
+		switch (frame.base()) {
+		case static_cast<uint8_t>(Magics::SYS::SYS_BASE):
+			dissect_sys(message);
+			break;
+		case static_cast<uint8_t>(Magics::CMD::CMD_BASE):
+			dissect_cmd(message);
+			break;
+		case static_cast<uint8_t>(Magics::INFO::INFO_BASE):
+			dissect_info(message);
+			break;
+		default:
+			dissect_data(message);
+			break;
+		}
+	}
+
+	void Dissector::dissect_sys(Message& message) const {
+		switch (static_cast<Magics::SYS>(message.frame.type())) {
+		case Magics::SYS::SYNC:
+			message.kind = "SYS SYNC";
+			break;
+		case Magics::SYS::NACK:
+			message.kind = "SYS NACK";
+			break;
+		case Magics::SYS::ACK:
+			message.kind = "SYS ACK";
+			break;
+		case Magics::SYS::ESC:
+			message.kind = "SYS ESC";
+			break;
+		default:
+			flag(message, Issue::VALUE);
+			break;
+		}
+	}
+
+	void Dissector::dissect_cmd(Message& message) const {
+		const uint8_t* const payload { message.frame.payload() };
+		switch (static_cast<Magics::CMD>(message.frame.mode())) {
+		case Magics::CMD::TYPE:
+			message.kind = "CMD TYPE";
+			if (check_payload(message, 1))
+				message.value = payload[0];
+			break;
+		case Magics::CMD::MODES:
+			// The number of visible modes is optional, and defaults to all
+			message.kind = "CMD MODES";
+			if (message.frame.payload_size() == 1) {
+				message.value = message.views = payload[0];
+			} else if (check_payload(message, 2)) {
+				message.value = payload[0];
+				message.views = payload[1];
+			}
+			break;
+		case Magics::CMD::SPEED:
+			message.kind = "CMD SPEED";
+			if (check_payload(message, 4))
+				message.value = SimpleEndian::load_le32(payload);
+			break;
+		case Magics::CMD::SELECT:
+			message.kind = "CMD SELECT";
+			if (check_payload(message, 1))
+				message.mode = payload[0];
+			break;
+		case Magics::CMD::WRITE:
+			message.kind = "CMD WRITE";
+			break;
+		default:
+			flag(message, Issue::VALUE);
+			break;
+		}
+	}
+
+	void Dissector::dissect_info(Message& message) {
+		const uint8_t* const payload { message.frame.payload() };
+		const uint8_t mode { message.frame.mode() };
+		message.mode = mode;
+		switch (message.frame.info_type()) {
+		case INFO_NAME:
+			message.kind = "INFO NAME";
+			read_text(message);
+			break;
+		case static_cast<uint8_t>(Magics::INFO_SPAN::RAW):
+		case static_cast<uint8_t>(Magics::INFO_SPAN::PCT):
+		case static_cast<uint8_t>(Magics::INFO_SPAN::SI): {
+			static const char* const SPANS[] { "INFO SPAN-RAW", "INFO SPAN-PCT",
+				"INFO SPAN-SI" };
+			message.kind = SPANS[message.frame.info_type() - 1];
+			if (check_payload(message, SPAN_SIZE)) {
+				message.lower = SimpleEndian::load_le_f32(payload);
+				message.upper = SimpleEndian::load_le_f32(payload + 4);
+			}
+			break;
+		}
+		case INFO_SYMBOL:
+			message.kind = "INFO SYMBOL";
+			read_text(message);
+			break;
+		case INFO_FORMAT:
+			message.kind = "INFO FORMAT";
+			if (!check_payload(message, FORMAT_SIZE))
+				break;
+			message.elems = payload[0];
+			message.data_type = static_cast<Magics::INFO_DTYPE>(payload[1]);
+			message.width = payload[2];
+			message.decimals = payload[3];
+			if (data_type_size(message.data_type) == 0) {
+				flag(message, Issue::VALUE);
+				break;
+			}
+			formats_seen |= (0x01 << mode);
+			elems[mode] = message.elems;
+			data_types[mode] = message.data_type;
+			break;
+		default:
+			message.kind = "INFO";
+			flag(message, Issue::VALUE);
+			break;
+		}
+	}
+
+	void Dissector::dissect_data(Message& message) const {
+		const uint8_t mode { message.frame.mode() };
+		message.kind = "DATA";
+		message.mode = mode;
+		if (!(formats_seen & (0x01 << mode))) {
+			flag(message, Issue::NO_FORMAT);
+			return;
+		}
+		message.data_type = data_types[mode];
+		if (check_payload(message, elems[mode]
+				* data_type_size(data_types[mode])))
+			message.elems = elems[mode];
+	}
+}
+}
@@ -0,0 +1,157 @@
+/**
+ * \file dissector.hpp
+ *
+ * Interprets decoded messages field by field, for inspecting captures of
+ * UART protocol communications.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page Dissection
+ *
+ * \ref Decoding splits a stream of bytes into messages, and discards
+ * messages with invalid checksums. \ref
+ * EV3UartGenerator::Dissection::Dissector takes each of those messages, and
+ * interprets its contents, using the enumerations in \ref Magics, into a
+ * \ref EV3UartGenerator::Dissection::Message:
+ * - \c CMD \c TYPE, \c MODES, \c SPEED and \c SELECT values
+ * - \c INFO \c NAME and \c SYMBOL strings, \c SPAN bounds and \c FORMAT
+ *   fields
+ * - \c DATA samples, interpreted with the \c INFO \c FORMAT message last
+ *   seen for the same mode
+ *
+ * Payloads that do not match the message are reported as
+ * \ref EV3UartGenerator::Dissection::Issue flags, instead of being
+ * rejected: payloads of the wrong length, non-zero padding, and unknown
+ * values.
+ *
+ * \code
+ * Decoding::Frame frame;
+ * Dissection::Message message;
+ * while (decoder.next(frame)) {
+ *     dissector.dissect(frame, message);
+ *     printf("%s mode %u\n", message.kind, message.mode);
+ * }
+ * \endcode
+ *
+ * The \c ev3_dissect tool in \c tools/ prints captures in this form.
+ *
+ * The dissector is declared in the file \ref dissector.hpp
+ */
+
+#ifndef DISSECTOR_HPP_
+#define DISSECTOR_HPP_
+
+#include <decoding.hpp>
+#include <framing.hpp>
+#include <magics.hpp>
+#include <stdint.h> // We can't include <cstdint> if we want to compile under Arduino
+
+namespace EV3UartGenerator {
+namespace Dissection {
+	constexpr uint8_t MODES_MAX { 0x08 }; ///< Number of modes addressable by INFO and DATA messages
+
+	/**
+	 * Problems found in a message, as flags in Message::issues.
+	 */
+	enum class Issue : uint8_t {
+		LENGTH = 0x01, ///< Payload is too short, or too long, for the message
+		PADDING = 0x02, ///< Padding bytes after the contents of the payload are not zero
+		VALUE = 0x04, ///< Unknown CMD, INFO type or data type value
+		NO_FORMAT = 0x08, ///< DATA message for a mode with no INFO FORMAT message seen so far
+	};
+
+	/**
+	 * Contents of a single message.
+	 *
+	 * Only the members listed for the kind of message are set.
+	 */
+	struct Message {
+		Decoding::Frame frame; ///< Message the contents are taken from
+		const char* kind; ///< Kind of message, e.g. \c "SYS ACK", \c "CMD SPEED", \c "INFO SPAN-RAW" or \c "DATA"
+		uint8_t mode; ///< Mode, for INFO, DATA and CMD SELECT messages
+		uint8_t issues; ///< Issue flags, OR'd together
+		uint32_t value; ///< Type (CMD TYPE), number of modes (CMD MODES) or baudrate (CMD SPEED)
+		uint8_t views; ///< Number of modes visible in the user interface (CMD MODES)
+		float lower; ///< Lower bound (INFO SPAN)
+		float upper; ///< Upper bound (INFO SPAN)
+		char text[Framing::PAYLOAD_SENSOR_TO_EV3_MAX + 1]; ///< Null terminated name (INFO NAME) or symbol (INFO SYMBOL)
+		uint8_t elems; ///< Number of samples (INFO FORMAT, DATA)
+		Magics::INFO_DTYPE data_type; ///< Data type of the samples (INFO FORMAT, DATA)
+		uint8_t width; ///< Number of digits to display (INFO FORMAT)
+		uint8_t decimals; ///< Number of decimals to display (INFO FORMAT)
+
+		/**
+		 * @return \c true if \c issue was found in the message
+		 */
+		bool has(const Issue issue) const {
+			return (issues & static_cast<uint8_t>(issue)) != 0;
+		}
+
+		/**
+		 * Reads a sample of a DATA message with an integer data type.
+		 *
+		 * @param index sample index, in [0, elems)
+		 */
+		int32_t integer_sample(const uint8_t index) const;
+
+		/**
+		 * Reads a sample of a DATA message with the F32 data type.
+		 *
+		 * @param index sample index, in [0, elems)
+		 */
+		float float_sample(const uint8_t index) const;
+	};
+
+	/**
+	 * @return name of a data type as used by the EV3, e.g. \c "DATA16"
+	 * @retval "?" for unknown data types
+	 */
+	const char* data_type_name(const Magics::INFO_DTYPE data_type);
+
+	/**
+	 * @return size of a single sample of a data type, in bytes
+	 * @retval 0 for unknown data types
+	 */
+	uint8_t data_type_size(const Magics::INFO_DTYPE data_type);
+
+	/**
+	 * Interprets a stream of messages, remembering the data format of every
+	 * mode from its INFO FORMAT message, to interpret DATA messages.
+	 */
+	class Dissector {
+	public:
+		Dissector();
+
+		/**
+		 * Interprets a message.
+		 *
+		 * @param frame message with a valid length and checksum, as returned
+		 * by Decoding::FrameDecoder
+		 * @param message receives the contents of the message, which refer
+		 * to the bytes of \c frame
+		 */
+		void dissect(const Decoding::Frame& frame, Message& message);
+
+		/**
+		 * Forgets the data formats of all modes.
+		 */
+		void reset();
+
+	private:
+		void dissect_sys(Message& message) const;
+		void dissect_cmd(Message& message) const;
+		void dissect_info(Message& message);
+		void dissect_data(Message& message) const;
+
+		uint8_t formats_seen; ///< Modes with a known data format, one bit each
+		uint8_t elems[MODES_MAX];
+		Magics::INFO_DTYPE data_types[MODES_MAX];
+	};
+}
+}
+
+#endif /* DISSECTOR_HPP_ */
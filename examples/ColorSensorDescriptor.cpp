@@ -0,0 +1,46 @@
+/**
+ * \file ColorSensorDescriptor.cpp
+ *
+ * Describes the EV3 color sensor, and populates a buffer with data equivalent
+ * to that sent by the sensor upon initialization.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <sensor_descriptor.hpp>
+#include <magics.hpp>
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+int main() {
+	using namespace EV3UartGenerator::Descriptor;
+	using EV3UartGenerator::Magics::INFO_DTYPE;
+
+	constexpr SpanDescriptor NO_SPAN { false, 0, 0 };
+	const ModeDescriptor modes[] {
+		{ "COL-REFLECT", { true, 0, 100 }, NO_SPAN, { true, 0, 100 }, "pct",
+				1, INFO_DTYPE::S8, 3, 0 },
+		{ "COL-AMBIENT", { true, 0, 100 }, NO_SPAN, { true, 0, 100 }, "pct",
+				1, INFO_DTYPE::S8, 3, 0 },
+		{ "COL-COLOR", { true, 0, 8 }, NO_SPAN, { true, 0, 8 }, "col",
+				1, INFO_DTYPE::S8, 2, 0 },
+		{ "REF-RAW", { true, 0, 1020.188 }, NO_SPAN, { true, 0, 1020.188 },
+				nullptr, 2, INFO_DTYPE::S16, 4, 0 },
+		{ "RGB-RAW", { true, 0, 1020.188 }, NO_SPAN, { true, 0, 1020.188 },
+				nullptr, 3, INFO_DTYPE::S16, 4, 0 },
+		{ "COL-CAL", { true, 0, 65535 }, NO_SPAN, { true, 0, 65535 },
+				nullptr, 4, INFO_DTYPE::S16, 5, 0 },
+	};
+	const SensorDescriptor color_sensor { 0x1d, 6, 3, 57600, modes };
+
+	const int16_t size { handshake_size(color_sensor) };
+	if (size < 0)
+		return 1;
+
+	std::vector<uint8_t> buffer(size);
+	std::cout << frame_handshake(buffer.data(), buffer.size(), color_sensor)
+			<< std::endl;
+}
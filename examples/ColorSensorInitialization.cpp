@@ -10,76 +10,81 @@
  */
 
 #include <framing.hpp>
+#include <frame_buffer.hpp>
 #include <magics.hpp>
 #include <iostream>
-#include <cstdio>
-#include <cstring>
 #include <cstdint>
 
-int main(int argc, char** argv) {
-	using namespace std;
-	using namespace EV3UartGenerator::Framing;
-	using namespace EV3UartGenerator::Magics;
-	uint8_t buffer[1024];
+using namespace EV3UartGenerator::Framing;
+using namespace EV3UartGenerator::Magics;
 
-	memset(reinterpret_cast<void*>(buffer), 0, 1024);
-	uint32_t sz_tally = 0;
+namespace {
+	/**
+	 * Size of the INFO messages of a mode: NAME, two SPANs, an optional
+	 * SYMBOL and FORMAT.
+	 */
+	constexpr int16_t mode_size(uint8_t name_length, uint8_t symbol_length) {
+		return frame_size_info_message_name(name_length)
+				+ (2 * frame_size_info_message_span())
+				+ (symbol_length ? frame_size_info_message_symbol(symbol_length) : 0)
+				+ frame_size_info_message_format();
+	}
 
-	sz_tally += frame_cmd_type_message(buffer, 0x1d);
-	sz_tally += frame_cmd_modes_message(buffer + sz_tally, 0x05, 0x02);
-	sz_tally += frame_cmd_speed_message(buffer + sz_tally, 57600);
+	constexpr int16_t HANDSHAKE_SIZE { frame_size_cmd_type_message()
+			+ frame_size_cmd_modes_message()
+			+ frame_size_cmd_speed_message()
+			+ mode_size(7, 0)		// COL-CAL
+			+ mode_size(7, 0)		// RGB-RAW
+			+ mode_size(7, 0)		// REF-RAW
+			+ mode_size(9, 3)		// COL-COLOR, col
+			+ mode_size(11, 3)		// COL-AMBIENT, pct
+			+ mode_size(11, 3)		// COL-REFLECT, pct
+			+ frame_size_sys_message() };
+}
+
+int main() {
+	uint8_t storage[HANDSHAKE_SIZE];
+	FrameBuffer buffer { storage, sizeof(storage) };
+
+	buffer.append_cmd_type_message(0x1d);
+	buffer.append_cmd_modes_message(0x05, 0x02);
+	buffer.append_cmd_speed_message(57600);
 
-	sz_tally += frame_info_message_name(buffer + sz_tally, 5, "COL-CAL");
-	sz_tally += frame_info_message_span(buffer + sz_tally, 5, INFO_SPAN::RAW, 0,
-			65535);
-	sz_tally += frame_info_message_span(buffer + sz_tally, 5, INFO_SPAN::SI, 0,
-				65535);
-	sz_tally += frame_info_message_format(buffer + sz_tally, 5, 4,
-			INFO_DTYPE::S16, 5, 0);
+	buffer.append_info_message_name(5, "COL-CAL");
+	buffer.append_info_message_span(5, INFO_SPAN::RAW, 0, 65535);
+	buffer.append_info_message_span(5, INFO_SPAN::SI, 0, 65535);
+	buffer.append_info_message_format(5, 4, INFO_DTYPE::S16, 5, 0);
 
-	sz_tally += frame_info_message_name(buffer + sz_tally, 4, "RGB-RAW");
-	sz_tally += frame_info_message_span(buffer + sz_tally, 4, INFO_SPAN::RAW, 0,
-			1020.188);
-	sz_tally += frame_info_message_span(buffer + sz_tally, 4, INFO_SPAN::SI, 0,
-			1020.188);
-	sz_tally += frame_info_message_format(buffer + sz_tally, 4, 3,
-			INFO_DTYPE::S16, 4, 0);
+	buffer.append_info_message_name(4, "RGB-RAW");
+	buffer.append_info_message_span(4, INFO_SPAN::RAW, 0, 1020.188);
+	buffer.append_info_message_span(4, INFO_SPAN::SI, 0, 1020.188);
+	buffer.append_info_message_format(4, 3, INFO_DTYPE::S16, 4, 0);
 
-	sz_tally += frame_info_message_name(buffer + sz_tally, 3, "REF-RAW");
-	sz_tally += frame_info_message_span(buffer + sz_tally, 3, INFO_SPAN::RAW, 0,
-			1020.188);
-	sz_tally += frame_info_message_span(buffer + sz_tally, 3, INFO_SPAN::SI, 0,
-			1020.188);
-	sz_tally += frame_info_message_format(buffer + sz_tally, 3, 2,
-			INFO_DTYPE::S16, 4, 0);
+	buffer.append_info_message_name(3, "REF-RAW");
+	buffer.append_info_message_span(3, INFO_SPAN::RAW, 0, 1020.188);
+	buffer.append_info_message_span(3, INFO_SPAN::SI, 0, 1020.188);
+	buffer.append_info_message_format(3, 2, INFO_DTYPE::S16, 4, 0);
 
-	sz_tally += frame_info_message_name(buffer + sz_tally, 2, "COL-COLOR");
-	sz_tally += frame_info_message_span(buffer + sz_tally, 2, INFO_SPAN::RAW, 0,
-			8);
-	sz_tally += frame_info_message_span(buffer + sz_tally, 2, INFO_SPAN::SI, 0,
-			8);
-	sz_tally += frame_info_message_symbol(buffer + sz_tally, 2, "col");
-	sz_tally += frame_info_message_format(buffer + sz_tally, 2, 1,
-			INFO_DTYPE::S8, 2, 0);
+	buffer.append_info_message_name(2, "COL-COLOR");
+	buffer.append_info_message_span(2, INFO_SPAN::RAW, 0, 8);
+	buffer.append_info_message_span(2, INFO_SPAN::SI, 0, 8);
+	buffer.append_info_message_symbol(2, "col");
+	buffer.append_info_message_format(2, 1, INFO_DTYPE::S8, 2, 0);
 
-	sz_tally += frame_info_message_name(buffer + sz_tally, 1, "COL-AMBIENT");
-	sz_tally += frame_info_message_span(buffer + sz_tally, 1, INFO_SPAN::RAW, 0,
-			100);
-	sz_tally += frame_info_message_span(buffer + sz_tally, 1, INFO_SPAN::SI, 0,
-				100);
-	sz_tally += frame_info_message_symbol(buffer + sz_tally, 1, "pct");
-	sz_tally += frame_info_message_format(buffer + sz_tally, 1, 1,
-			INFO_DTYPE::S8, 3, 0);
+	buffer.append_info_message_name(1, "COL-AMBIENT");
+	buffer.append_info_message_span(1, INFO_SPAN::RAW, 0, 100);
+	buffer.append_info_message_span(1, INFO_SPAN::SI, 0, 100);
+	buffer.append_info_message_symbol(1, "pct");
+	buffer.append_info_message_format(1, 1, INFO_DTYPE::S8, 3, 0);
 
-	sz_tally += frame_info_message_name(buffer + sz_tally, 0, "COL-REFLECT");
-	sz_tally += frame_info_message_span(buffer + sz_tally, 0, INFO_SPAN::RAW, 0,
-			100);
-	sz_tally += frame_info_message_span(buffer + sz_tally, 0, INFO_SPAN::SI, 0,
-				100);
-	sz_tally += frame_info_message_symbol(buffer + sz_tally, 0, "pct");
-	sz_tally += frame_info_message_format(buffer + sz_tally, 0, 1,
-			INFO_DTYPE::S8, 3, 0);
+	buffer.append_info_message_name(0, "COL-REFLECT");
+	buffer.append_info_message_span(0, INFO_SPAN::RAW, 0, 100);
+	buffer.append_info_message_span(0, INFO_SPAN::SI, 0, 100);
+	buffer.append_info_message_symbol(0, "pct");
+	buffer.append_info_message_format(0, 1, INFO_DTYPE::S8, 3, 0);
 
-	sz_tally += frame_sys_message(buffer + sz_tally, SYS::ACK);
-	std::cout << sz_tally << std::endl;
+	// The handshake fills the buffer exactly, any miscount fails here
+	if (!buffer.append_sys_message(SYS::ACK) || (buffer.remaining() != 0))
+		return 1;
+	std::cout << buffer.size() << std::endl;
 }
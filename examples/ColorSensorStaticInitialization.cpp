@@ -0,0 +1,67 @@
+/**
+ * \file ColorSensorStaticInitialization.cpp
+ *
+ * Generates, at compile time, a buffer with data equivalent to that sent by a
+ * EV3 color sensor upon initialization.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <static_framing.hpp>
+#include <magics.hpp>
+#include <iostream>
+#include <cstdint>
+
+namespace {
+	using namespace EV3UartGenerator;
+	using namespace EV3UartGenerator::StaticFraming;
+	using EV3UartGenerator::Magics::INFO_SPAN;
+	using EV3UartGenerator::Magics::INFO_DTYPE;
+
+	// Evaluated entirely at compile time - can be placed in flash
+	constexpr auto handshake_bytes = handshake(
+		cmd_type(0x1d),
+		cmd_modes(0x05, 0x02),
+		cmd_speed(57600),
+
+		info_name(5, "COL-CAL"),
+		info_span(5, INFO_SPAN::RAW, 0, 65535),
+		info_span(5, INFO_SPAN::SI, 0, 65535),
+		info_format(5, 4, INFO_DTYPE::S16, 5, 0),
+
+		info_name(4, "RGB-RAW"),
+		info_span(4, INFO_SPAN::RAW, 0, 1020.188),
+		info_span(4, INFO_SPAN::SI, 0, 1020.188),
+		info_format(4, 3, INFO_DTYPE::S16, 4, 0),
+
+		info_name(3, "REF-RAW"),
+		info_span(3, INFO_SPAN::RAW, 0, 1020.188),
+		info_span(3, INFO_SPAN::SI, 0, 1020.188),
+		info_format(3, 2, INFO_DTYPE::S16, 4, 0),
+
+		info_name(2, "COL-COLOR"),
+		info_span(2, INFO_SPAN::RAW, 0, 8),
+		info_span(2, INFO_SPAN::SI, 0, 8),
+		info_symbol(2, "col"),
+		info_format(2, 1, INFO_DTYPE::S8, 2, 0),
+
+		info_name(1, "COL-AMBIENT"),
+		info_span(1, INFO_SPAN::RAW, 0, 100),
+		info_span(1, INFO_SPAN::SI, 0, 100),
+		info_symbol(1, "pct"),
+		info_format(1, 1, INFO_DTYPE::S8, 3, 0),
+
+		info_name(0, "COL-REFLECT"),
+		info_span(0, INFO_SPAN::RAW, 0, 100),
+		info_span(0, INFO_SPAN::SI, 0, 100),
+		info_symbol(0, "pct"),
+		info_format(0, 1, INFO_DTYPE::S8, 3, 0),
+
+		sys(Magics::SYS::ACK));
+}
+
+int main() {
+	std::cout << handshake_bytes.size() << std::endl;
+}
@@ -0,0 +1,16 @@
+/**
+ * \file frame_buffer.cpp
+ *
+ * Compiles the definitions in \ref frame_buffer_impl.hpp, unless the library is
+ * header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <frame_buffer.hpp>
+
+#if !EV3UARTGENERATOR_HEADER_ONLY
+#include <frame_buffer_impl.hpp>
+#endif
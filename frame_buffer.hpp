@@ -0,0 +1,206 @@
+/**
+ * \file frame_buffer.hpp
+ *
+ * Bounds checked buffer that messages are appended to, one after another.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page FrameBuffer
+ *
+ * The functions in \ref Framing write into unchecked destination pointers,
+ * and rely on the caller providing at least BUFFER_MIN bytes for every
+ * message. When many messages are framed back to back, the caller also has
+ * to advance the destination after every message.
+ *
+ * \ref EV3UartGenerator::Framing::FrameBuffer wraps a destination buffer
+ * and its capacity instead:
+ * - messages are appended after the messages already in the buffer
+ * - every append checks the exact size of the message (see the
+ *   \c frame_size_* functions in \ref framing.hpp) against the remaining
+ *   capacity first, and writes nothing if the message does not fit or is
+ *   invalid
+ * - every append returns a \ref EV3UartGenerator::Framing::FrameResult,
+ *   holding either the number of bytes written or the reason for failing
+ *
+ * \code
+ * uint8_t storage[0x40];
+ * Framing::FrameBuffer buffer { storage, sizeof(storage) };
+ * buffer.append_cmd_type_message(0x1d);
+ * buffer.append_cmd_modes_message(5, 2);
+ * if (!buffer.append_cmd_speed_message(57600))
+ *     ... // Out of space
+ * send(buffer.data(), buffer.size());
+ * \endcode
+ *
+ * The buffer is declared in the file \ref frame_buffer.hpp
+ */
+
+#ifndef FRAME_BUFFER_HPP_
+#define FRAME_BUFFER_HPP_
+
+#include <header_only.hpp>
+#include <framing.hpp>
+#include <magics.hpp>
+#include <stdint.h> // We can't include <cstdint> if we want to compile under Arduino
+#include <stddef.h> // We can't include <cstddef> if we want to compile under Arduino
+
+namespace EV3UartGenerator {
+namespace Framing {
+	/**
+	 * Reasons for an append to a FrameBuffer to fail.
+	 */
+	enum class FrameError : uint8_t {
+		NONE, ///< Message was appended
+		INVALID, ///< Message contents are out of range, as for the corresponding framing function
+		NO_SPACE, ///< Message does not fit into the remaining capacity
+	};
+
+	/**
+	 * Outcome of appending to a FrameBuffer.
+	 */
+	struct FrameResult {
+		uint16_t size; ///< Number of bytes appended, 0 on error
+		FrameError error; ///< Reason for failing, or FrameError::NONE
+
+		/**
+		 * @return whether the message was appended
+		 */
+		explicit operator bool() const {
+			return error == FrameError::NONE;
+		}
+	};
+
+	/**
+	 * Destination buffer of known capacity, that messages are appended to.
+	 *
+	 * The buffer does not own its storage.
+	 */
+	class FrameBuffer {
+	public:
+		/**
+		 * @param storage destination storage
+		 * @param capacity size of the destination storage, in bytes
+		 */
+		FrameBuffer(uint8_t* storage, size_t capacity)
+			: storage { storage }, used { 0 }, total { capacity } {
+		}
+
+		/**
+		 * @return first byte of the buffer
+		 */
+		const uint8_t* data() const {
+			return storage;
+		}
+
+		/**
+		 * @return number of bytes appended so far
+		 */
+		size_t size() const {
+			return used;
+		}
+
+		/**
+		 * @return size of the storage
+		 */
+		size_t capacity() const {
+			return total;
+		}
+
+		/**
+		 * @return number of bytes that can still be appended
+		 */
+		size_t remaining() const {
+			return total - used;
+		}
+
+		/**
+		 * Discards all messages, so that the storage can be reused.
+		 */
+		void clear() {
+			used = 0;
+		}
+
+		/**
+		 * Reserves space for bytes framed outside of the buffer, such as a
+		 * whole handshake, and marks them as appended.
+		 *
+		 * @param len number of bytes to reserve
+		 * @return start of the reserved space, or \c nullptr if \c len
+		 * bytes do not fit
+		 */
+		uint8_t* reserve(size_t len);
+
+		/// Appends a message, see frame_sys_message()
+		FrameResult append_sys_message(Magics::SYS sys_type);
+		/// Appends a message, see frame_cmd_type_message()
+		FrameResult append_cmd_type_message(const uint8_t type);
+		/// Appends a message, see frame_cmd_modes_message()
+		FrameResult append_cmd_modes_message(const uint8_t modes,
+				const uint8_t modes_available);
+		/// Appends a message, see frame_cmd_speed_message()
+		FrameResult append_cmd_speed_message(const uint32_t speed);
+		/// Appends a message, see frame_cmd_select_message()
+		FrameResult append_cmd_select_message(const uint8_t mode);
+		/// Appends a message, see frame_cmd_write_message()
+		FrameResult append_cmd_write_message(const uint8_t* data,
+				const uint8_t len);
+		/// Appends a message, see frame_info_message_name()
+		FrameResult append_info_message_name(const uint8_t mode,
+				const char* name);
+		/// Appends a message, see frame_info_message_span()
+		FrameResult append_info_message_span(const uint8_t mode,
+				Magics::INFO_SPAN span_type, const float lower,
+				const float upper);
+		/// Appends a message, see frame_info_message_symbol()
+		FrameResult append_info_message_symbol(const uint8_t mode,
+				const char* symbol);
+		/// Appends a message, see frame_info_message_format()
+		FrameResult append_info_message_format(const uint8_t mode,
+				const uint8_t elems, Magics::INFO_DTYPE data_type,
+				const uint8_t width, const uint8_t decimals);
+		/// Appends a message, see frame_data_message()
+		FrameResult append_data_message(const uint8_t mode,
+				const uint8_t* data, const uint8_t len);
+
+		/**
+		 * Appends a message, see frame_data_samples().
+		 */
+		template <typename T>
+		FrameResult append_data_samples(const uint8_t mode, const T* samples,
+				const uint8_t count, Magics::INFO_DTYPE data_type) {
+			const FrameResult fits { check(frame_size_data_message(
+					(count <= PAYLOAD_SENSOR_TO_EV3_MAX)
+					? static_cast<uint8_t>(count * sizeof(T)) : 0)) };
+			if (!fits)
+				return fits;
+			return advance(frame_data_samples(storage + used, mode, samples,
+					count, data_type));
+		}
+
+	private:
+		/**
+		 * @param needed exact size of the next message, or -1 if invalid
+		 */
+		FrameResult check(const int16_t needed) const;
+
+		/**
+		 * @param written return value of a framing function
+		 */
+		FrameResult advance(const int16_t written);
+
+		uint8_t* const storage;
+		size_t used;
+		const size_t total;
+	};
+}
+}
+
+#if EV3UARTGENERATOR_HEADER_ONLY
+#include <frame_buffer_impl.hpp>
+#endif
+
+#endif /* FRAME_BUFFER_HPP_ */
@@ -0,0 +1,150 @@
+/**
+ * \file frame_buffer_impl.hpp
+ *
+ * Function definitions for functions in \ref frame_buffer.hpp
+ *
+ * Compiled in \c frame_buffer.cpp, or included by \ref frame_buffer.hpp when the library
+ * is header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#ifndef FRAME_BUFFER_IMPL_HPP_
+#define FRAME_BUFFER_IMPL_HPP_
+
+#include <frame_buffer.hpp>
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+namespace EV3UartGenerator {
+namespace Framing {
+	namespace Detail {
+		/**
+		 * Length of a string, or 0 for \c nullptr or strings that are too
+		 * long for any payload, so that sizing fails.
+		 */
+		inline uint8_t string_length(const char* str) {
+			const size_t len { (str != nullptr) ? strlen(str) : 0 };
+			return (len <= PAYLOAD_SENSOR_TO_EV3_MAX) ? static_cast<uint8_t>(len)
+					: 0;
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	uint8_t* FrameBuffer::reserve(size_t len) {
+		if (len > remaining())
+			return nullptr;
+		uint8_t* const start { storage + used };
+		used += len;
+		return start;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::check(const int16_t needed) const {
+		if (needed < 0)
+			return FrameResult { 0, FrameError::INVALID };
+		if (static_cast<size_t>(needed) > remaining())
+			return FrameResult { 0, FrameError::NO_SPACE };
+		return FrameResult { 0, FrameError::NONE };
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::advance(const int16_t written) {
+		if (written < 0)
+			return FrameResult { 0, FrameError::INVALID };
+		used += written;
+		return FrameResult { static_cast<uint16_t>(written), FrameError::NONE };
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_sys_message(Magics::SYS sys_type) {
+		const FrameResult fits { check(frame_size_sys_message()) };
+		return fits ? advance(frame_sys_message(storage + used, sys_type))
+				: fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_cmd_type_message(const uint8_t type) {
+		const FrameResult fits { check(frame_size_cmd_type_message()) };
+		return fits ? advance(frame_cmd_type_message(storage + used, type))
+				: fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_cmd_modes_message(const uint8_t modes,
+			const uint8_t modes_available) {
+		const FrameResult fits { check(frame_size_cmd_modes_message()) };
+		return fits ? advance(frame_cmd_modes_message(storage + used, modes,
+				modes_available)) : fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_cmd_speed_message(const uint32_t speed) {
+		const FrameResult fits { check(frame_size_cmd_speed_message()) };
+		return fits ? advance(frame_cmd_speed_message(storage + used, speed))
+				: fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_cmd_select_message(const uint8_t mode) {
+		const FrameResult fits { check(frame_size_cmd_select_message()) };
+		return fits ? advance(frame_cmd_select_message(storage + used, mode))
+				: fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_cmd_write_message(const uint8_t* data,
+			const uint8_t len) {
+		const FrameResult fits { check(frame_size_cmd_write_message(len)) };
+		return fits ? advance(frame_cmd_write_message(storage + used, data,
+				len)) : fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_info_message_name(const uint8_t mode,
+			const char* name) {
+		const FrameResult fits { check(frame_size_info_message_name(
+				Detail::string_length(name))) };
+		return fits ? advance(frame_info_message_name(storage + used, mode,
+				name)) : fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_info_message_span(const uint8_t mode,
+			Magics::INFO_SPAN span_type, const float lower,
+			const float upper) {
+		const FrameResult fits { check(frame_size_info_message_span()) };
+		return fits ? advance(frame_info_message_span(storage + used, mode,
+				span_type, lower, upper)) : fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_info_message_symbol(const uint8_t mode,
+			const char* symbol) {
+		const FrameResult fits { check(frame_size_info_message_symbol(
+				Detail::string_length(symbol))) };
+		return fits ? advance(frame_info_message_symbol(storage + used, mode,
+				symbol)) : fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_info_message_format(const uint8_t mode,
+			const uint8_t elems, Magics::INFO_DTYPE data_type,
+			const uint8_t width, const uint8_t decimals) {
+		const FrameResult fits { check(frame_size_info_message_format()) };
+		return fits ? advance(frame_info_message_format(storage + used, mode,
+				elems, data_type, width, decimals)) : fits;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	FrameResult FrameBuffer::append_data_message(const uint8_t mode,
+			const uint8_t* data, const uint8_t len) {
+		const FrameResult fits { check(frame_size_data_message(len)) };
+		return fits ? advance(frame_data_message(storage + used, mode, data,
+				len)) : fits;
+	}
+}
+}
+
+#endif /* FRAME_BUFFER_IMPL_HPP_ */
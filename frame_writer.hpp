@@ -0,0 +1,176 @@
+/**
+ * \file frame_writer.hpp
+ *
+ * Single pass message writer, which accumulates the checksum of a message
+ * while its bytes are written.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page FrameWriter
+ *
+ * Every message ends with a checksum over all of its preceding bytes.
+ * Instead of writing a message and then reading it back to calculate the
+ * checksum, \ref EV3UartGenerator::Framing::FrameWriter XORs every byte into
+ * an accumulator as it is written - payloads are copied and reduced one
+ * machine word at a time - and appends the checksum when the message is
+ * finished:
+ *
+ * \code
+ * Framing::FrameWriter writer { dest };
+ * writer.put(type_byte);
+ * writer.put(payload, len);
+ * writer.pad(Framing::padding_length(len));
+ * const int8_t size { writer.finish() };
+ * \endcode
+ *
+ * All framing functions in \ref Framing are built on it, and new messages
+ * should be too. Padding bytes are zero, and so do not change the checksum.
+ *
+ * The writer is declared in the file \ref frame_writer.hpp
+ */
+
+#ifndef FRAME_WRITER_HPP_
+#define FRAME_WRITER_HPP_
+
+#include <checksum.hpp>
+#include <simple_endian.hpp>
+#include <stdint.h> // We can't include <cstdint> if we want to compile under Arduino
+#include <stddef.h> // We can't include <cstddef> if we want to compile under Arduino
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+namespace EV3UartGenerator {
+namespace Framing {
+	/**
+	 * Writes a message into a buffer, accumulating its checksum on the way.
+	 *
+	 * The writer does not check the capacity of the buffer - callers size
+	 * their messages beforehand, as with every other framing function.
+	 */
+	class FrameWriter {
+	public:
+		/**
+		 * @param dest destination buffer, receiving the first byte of the
+		 * message
+		 */
+		explicit FrameWriter(uint8_t* dest)
+			: start { dest }, pos { dest }, acc { 0xff } {
+		}
+
+		/**
+		 * Writes a single byte.
+		 */
+		void put(const uint8_t byte) {
+			*(pos++) = byte;
+			acc ^= byte;
+		}
+
+		/**
+		 * Copies bytes into the message, one machine word at a time.
+		 *
+		 * @param data source bytes, with no alignment requirements
+		 * @param len number of bytes to copy
+		 */
+		void put(const uint8_t* data, size_t len) {
+			while (len >= sizeof(size_t)) {
+				size_t word;
+				memcpy(&word, data, sizeof(word));
+				memcpy(pos, &word, sizeof(word));
+				acc ^= word;
+				data += sizeof(word);
+				pos += sizeof(word);
+				len -= sizeof(word);
+			}
+			while (len-- > 0)
+				put(*(data++));
+		}
+
+		/**
+		 * Writes a 32-bit value as 4 little-endian bytes.
+		 */
+		void put_le32(const uint32_t value) {
+			uint8_t bytes[sizeof(value)];
+			SimpleEndian::store_le32(bytes, value);
+			put(bytes, sizeof(bytes));
+		}
+
+		/**
+		 * Writes a single precision float as 4 little-endian bytes.
+		 */
+		void put_le_f32(const float value) {
+			uint8_t bytes[sizeof(value)];
+			SimpleEndian::store_le_f32(bytes, value);
+			put(bytes, sizeof(bytes));
+		}
+
+		/**
+		 * Writes an array of samples as little-endian bytes. See
+		 * SimpleEndian::store_le().
+		 */
+		template <typename T>
+		void put_le(const T* samples, const uint8_t count) {
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+			put(reinterpret_cast<const uint8_t*>(samples), count * sizeof(T));
+#else
+			SimpleEndian::store_le(pos, samples, count);
+			accumulate(count * sizeof(T));
+#endif
+		}
+
+		/**
+		 * Writes zero bytes, which do not change the checksum.
+		 *
+		 * @param count number of bytes to write
+		 */
+		void pad(const uint8_t count) {
+			memset(pos, 0x00, count);
+			pos += count;
+		}
+
+		/**
+		 * Appends the checksum, completing the message.
+		 *
+		 * @return length of the message, including the checksum
+		 */
+		int8_t finish() {
+			*(pos++) = Checksum::Detail::fold(acc);
+			return static_cast<int8_t>(pos - start);
+		}
+
+		/**
+		 * @return number of bytes written so far
+		 */
+		size_t size() const {
+			return static_cast<size_t>(pos - start);
+		}
+
+	private:
+		/**
+		 * Moves past bytes already stored at the current position, such as
+		 * byte-swapped samples, reducing them one machine word at a time.
+		 *
+		 * @param len number of bytes
+		 */
+		void accumulate(size_t len) {
+			while (len >= sizeof(size_t)) {
+				size_t word;
+				memcpy(&word, pos, sizeof(word));
+				acc ^= word;
+				pos += sizeof(word);
+				len -= sizeof(word);
+			}
+			while (len-- > 0)
+				acc ^= *(pos++);
+		}
+
+		uint8_t* const start;
+		uint8_t* pos;
+		size_t acc; ///< XOR of all bytes written, spread over the bytes of a word, seeded with 0xff
+	};
+}
+}
+
+#endif /* FRAME_WRITER_HPP_ */
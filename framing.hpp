@@ -20,6 +20,9 @@
  * the size of the message, include checksums and padding, and populate
  * user-provided buffers with the message bytes to be delivered to the EV3.
  *
+ * Every framing function writes its message in a single pass, with a
+ * \ref EV3UartGenerator::Framing::FrameWriter (see \ref FrameWriter).
+ *
  * The functions that are used to frame messages for transmission to the EV3
  * are declared in the file \ref framing.hpp
  *
@@ -31,8 +34,30 @@
 #ifndef FRAMING_HPP_
 #define FRAMING_HPP_
 
+#include <header_only.hpp>
 #include <magics.hpp>
 
+/**
+ * \def EV3UARTGENERATOR_SOFT_CLZ
+ * Set to 1 to count leading zeros without \c __builtin_clz, for compilers
+ * lacking the builtin. Also used to benchmark targets on which the builtin
+ * is a software routine.
+ *
+ * \def EV3UARTGENERATOR_LENGTH_LUT
+ * Set to 1 (default) to compute log2(), length_code(), padded_length() and
+ * padding_length() with lookup tables, or to 0 to compute them from a count
+ * of leading zeros. The tables (99 bytes) are faster on x86 as well as on
+ * targets without a count leading zeros instruction, such as AVR, where
+ * \c __builtin_clz is a library call - see \c bench/bench_framing.cpp
+ */
+#ifndef EV3UARTGENERATOR_SOFT_CLZ
+#define EV3UARTGENERATOR_SOFT_CLZ 0
+#endif
+
+#ifndef EV3UARTGENERATOR_LENGTH_LUT
+#define EV3UARTGENERATOR_LENGTH_LUT 1
+#endif
+
 namespace EV3UartGenerator {
 namespace Framing {
 	constexpr uint8_t BUFFER_MIN { 0x23 }; ///< Minimum size of the buffer (in bytes) that the user has to provide to each of the framing functions, to avoid any chance of a buffer overflow.
@@ -233,6 +258,79 @@ namespace Framing {
 			const uint8_t* data,
 			const uint8_t len);
 
+	/**
+	 * Frame an EV3 data message from an array of native samples, packed
+	 * little-endian as advertised in the INFO FORMAT message of the mode.
+	 *
+	 * One overload exists for each data type: \c int8_t for S8, \c int16_t
+	 * for S16, \c int32_t for S32 and \c float for F32.
+	 *
+	 * @param dest destination buffer
+	 * @param mode mode index [0, 7]
+	 * @param samples samples to be sent
+	 * @param count number of samples, which must match the number of data
+	 * elements in the INFO FORMAT message of the mode. The packed samples
+	 * must fit into PAYLOAD_SENSOR_TO_EV3_MAX bytes (see
+	 * frame_info_message_format())
+	 * @param data_type type of data elements, from the INFO FORMAT message
+	 * of the mode
+	 * @return length of framed message (written to the buffer), if positive.
+	 * @retval -1 on error (\c data_type does not match the type of samples,
+	 * or \c count out of range)
+	 *
+	 * @note Only the three least significant mode number bits are
+	 * considered. No out-of-range values will be passed to the EV3.
+	 */
+	int8_t frame_data_samples(uint8_t* dest, const uint8_t mode,
+			const int8_t* samples, const uint8_t count,
+			Magics::INFO_DTYPE data_type);
+
+	/**
+	 * \copydoc frame_data_samples(uint8_t*, const uint8_t, const int8_t*, const uint8_t, Magics::INFO_DTYPE)
+	 */
+	int8_t frame_data_samples(uint8_t* dest, const uint8_t mode,
+			const int16_t* samples, const uint8_t count,
+			Magics::INFO_DTYPE data_type);
+
+	/**
+	 * \copydoc frame_data_samples(uint8_t*, const uint8_t, const int8_t*, const uint8_t, Magics::INFO_DTYPE)
+	 */
+	int8_t frame_data_samples(uint8_t* dest, const uint8_t mode,
+			const int32_t* samples, const uint8_t count,
+			Magics::INFO_DTYPE data_type);
+
+	/**
+	 * \copydoc frame_data_samples(uint8_t*, const uint8_t, const int8_t*, const uint8_t, Magics::INFO_DTYPE)
+	 */
+	int8_t frame_data_samples(uint8_t* dest, const uint8_t mode,
+			const float* samples, const uint8_t count,
+			Magics::INFO_DTYPE data_type);
+
+	/**
+	 * Frame a batch of EV3 data messages, all for the same mode of the
+	 * sensor, back-to-back in the destination buffer.
+	 *
+	 * The message type byte, padding and message size are computed once
+	 * for the whole batch. The resulting bytes are identical to those
+	 * produced by calling frame_data_message() \c count times.
+	 *
+	 * @param dest destination buffer, with space for at least
+	 * <tt>count * (0x02 + payload_length(length_code(len)))</tt> bytes
+	 * @param mode mode index [0, 7]
+	 * @param data \c count samples of \c len bytes each, stored contiguously
+	 * @param len length of each sample, with length in range
+	 * [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 * @param count number of samples to frame
+	 * @return total length of framed messages (written to the buffer),
+	 * if non-negative.
+	 * @retval -1 on error (length overrun)
+	 *
+	 * @note Only the three least significant mode number bits are
+	 * considered. No out-of-range values will be passed to the EV3.
+	 */
+	int32_t frame_data_messages(uint8_t* dest, const uint8_t mode,
+			const uint8_t* data, const uint8_t len, const uint16_t count);
+
 	/**
 	 * Calculates the checksum for an EV3 data message.
 	 *
@@ -240,9 +338,91 @@ namespace Framing {
 	 * @param len length of data message in the source buffer
 	 * @return checksum of \c len bytes of data in the
 	 * source buffer
+	 *
+	 * @note The XOR reduction is performed by Checksum::xor_reduce(), which
+	 * can also be used directly for buffers longer than 255 bytes.
 	 */
 	uint8_t checksum(const uint8_t* buf, const uint8_t len);
 
+	namespace Detail {
+		/**
+		 * Counts leading zero bits of a 32 bit value, without relying on
+		 * compiler builtins or hardware instructions.
+		 *
+		 * @warning undefined for \c val of 0.
+		 */
+		constexpr uint8_t soft_clz(uint32_t val, uint8_t count = 0) {
+			return (val & 0x80000000) ? count : soft_clz(val << 1, count + 1);
+		}
+
+		/**
+		 * Integer log_2 of \c val rounded up, computed by searching for the
+		 * smallest power of two not less than \c val.
+		 */
+		constexpr uint8_t search_log2(uint8_t val, uint8_t bits = 0) {
+			return ((0x01u << bits) >= val) ? bits : search_log2(val, bits + 1);
+		}
+
+		/**
+		 * Expands \c entry for every payload length in
+		 * [0, PAYLOAD_SENSOR_TO_EV3_MAX], to build the length lookup tables.
+		 */
+#define EV3UARTGENERATOR_LENGTHS(entry) \
+	entry(0x01), entry(0x01), entry(0x02), entry(0x03), entry(0x04), \
+	entry(0x05), entry(0x06), entry(0x07), entry(0x08), entry(0x09), \
+	entry(0x0a), entry(0x0b), entry(0x0c), entry(0x0d), entry(0x0e), \
+	entry(0x0f), entry(0x10), entry(0x11), entry(0x12), entry(0x13), \
+	entry(0x14), entry(0x15), entry(0x16), entry(0x17), entry(0x18), \
+	entry(0x19), entry(0x1a), entry(0x1b), entry(0x1c), entry(0x1d), \
+	entry(0x1e), entry(0x1f), entry(0x20)
+
+		/**
+		 * Lookup tables indexed by payload length
+		 * [0, PAYLOAD_SENSOR_TO_EV3_MAX], generated at compile time.
+		 *
+		 * Entries for length 0 are those of length 1.
+		 *
+		 * Defined as static members of a class template, so that they can be
+		 * used from constexpr functions and still be defined in a header.
+		 */
+		template <typename T = void>
+		struct LengthTables {
+			static constexpr uint8_t log2[PAYLOAD_SENSOR_TO_EV3_MAX + 1] {
+#define EV3UARTGENERATOR_ENTRY(len) search_log2(len)
+				EV3UARTGENERATOR_LENGTHS(EV3UARTGENERATOR_ENTRY) };
+#undef EV3UARTGENERATOR_ENTRY
+			static constexpr uint8_t padded[PAYLOAD_SENSOR_TO_EV3_MAX + 1] {
+#define EV3UARTGENERATOR_ENTRY(len) (0x01 << search_log2(len))
+				EV3UARTGENERATOR_LENGTHS(EV3UARTGENERATOR_ENTRY) };
+#undef EV3UARTGENERATOR_ENTRY
+			static constexpr uint8_t padding[PAYLOAD_SENSOR_TO_EV3_MAX + 1] {
+#define EV3UARTGENERATOR_ENTRY(len) ((0x01 << search_log2(len)) - len)
+				EV3UARTGENERATOR_LENGTHS(EV3UARTGENERATOR_ENTRY) };
+#undef EV3UARTGENERATOR_ENTRY
+		};
+#undef EV3UARTGENERATOR_LENGTHS
+
+		template <typename T>
+		constexpr uint8_t LengthTables<T>::log2[];
+		template <typename T>
+		constexpr uint8_t LengthTables<T>::padded[];
+		template <typename T>
+		constexpr uint8_t LengthTables<T>::padding[];
+
+		/**
+		 * Counts leading zero bits of a 32 bit value.
+		 *
+		 * @warning undefined for \c val of 0.
+		 */
+		constexpr uint8_t clz(uint32_t val) {
+#if EV3UARTGENERATOR_SOFT_CLZ
+			return soft_clz(val);
+#else
+			return __builtin_clz(val);
+#endif
+		}
+	}
+
 	/**
 	 * Calculates the integer log_2 of a particular unsigned
 	 * integer value, rounded up.
@@ -254,8 +434,14 @@ namespace Framing {
 	 * @warning undefined for \c val of 0.
 	 */
 	constexpr uint8_t log2(uint8_t val) {
-		return (0x1f - __builtin_clz(val)) +
-				(val - (0x01 << (0x1f -__builtin_clz(val))) != 0 ? 1 : 0);
+#if EV3UARTGENERATOR_LENGTH_LUT
+		return (val <= PAYLOAD_SENSOR_TO_EV3_MAX)
+				? Detail::LengthTables<>::log2[val]
+				: Detail::search_log2(val);
+#else
+		return (0x1f - Detail::clz(val)) +
+				(val - (0x01 << (0x1f - Detail::clz(val))) != 0 ? 1 : 0);
+#endif
 	}
 
 	/**
@@ -271,6 +457,125 @@ namespace Framing {
 		return log2(len) << 0x03;
 	}
 
+	/**
+	 * Calculates the length of a payload after padding, which is the
+	 * smallest power of two not less than its length.
+	 *
+	 * @param len length of the payload
+	 * [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 * @return length of the payload after padding
+	 */
+	constexpr uint8_t padded_length(uint8_t len) {
+#if EV3UARTGENERATOR_LENGTH_LUT
+		return Detail::LengthTables<>::padded[len];
+#else
+		return 0x01 << log2(len);
+#endif
+	}
+
+	/**
+	 * Calculates the number of padding bytes following a payload.
+	 *
+	 * @param len length of the payload
+	 * [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 * @return number of padding bytes following the payload
+	 */
+	constexpr uint8_t padding_length(uint8_t len) {
+#if EV3UARTGENERATOR_LENGTH_LUT
+		return Detail::LengthTables<>::padding[len];
+#else
+		return (0x01 << log2(len)) - len;
+#endif
+	}
+
+	/**
+	 * Calculates the length of the payload contained in a message, from the
+	 * length code OR'd into its message type byte.
+	 *
+	 * This is the inverse of length_code(), such that
+	 * <tt>payload_length(length_code(len))</tt> gives the length of
+	 * \c len bytes of payload, after padding.
+	 *
+	 * @param type message type byte, or a value returned by length_code()
+	 * @return length of the (padded) payload contained in the message
+	 *
+	 * @note Only the length code bits [3, 5] of \c type are considered.
+	 */
+	constexpr uint8_t payload_length(uint8_t type) {
+		return 0x01 << ((type >> 0x03) & 0x07);
+	}
+
+	/**
+	 * \name Message sizes
+	 *
+	 * Exact sizes of messages, in bytes, including the message type byte,
+	 * padding and checksum, for sizing buffers before framing into them.
+	 * Sizes of variable length messages are -1 if the payload length is
+	 * out of range, as the corresponding framing function would fail.
+	 */
+	///@{
+	constexpr int8_t frame_size_sys_message() {
+		return 0x01;
+	}
+
+	constexpr int8_t frame_size_cmd_type_message() {
+		return 0x03;
+	}
+
+	constexpr int8_t frame_size_cmd_modes_message() {
+		return 0x04;
+	}
+
+	constexpr int8_t frame_size_cmd_speed_message() {
+		return 0x06;
+	}
+
+	constexpr int8_t frame_size_cmd_select_message() {
+		return 0x03;
+	}
+
+	/**
+	 * @param len payload length [PAYLOAD_MIN, PAYLOAD_EV3_TO_SENSOR_MAX]
+	 */
+	constexpr int8_t frame_size_cmd_write_message(uint8_t len) {
+		return ((len < PAYLOAD_MIN) || (len > PAYLOAD_EV3_TO_SENSOR_MAX))
+				? -1 : (0x02 + padded_length(len));
+	}
+
+	/**
+	 * @param len name length [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 */
+	constexpr int8_t frame_size_info_message_name(uint8_t len) {
+		return ((len < PAYLOAD_MIN) || (len > PAYLOAD_SENSOR_TO_EV3_MAX))
+				? -1 : (0x03 + padded_length(len));
+	}
+
+	constexpr int8_t frame_size_info_message_span() {
+		return 0x0b;
+	}
+
+	/**
+	 * @param len symbol length [PAYLOAD_MIN, SYMBOL_MAX]. Symbols are
+	 * always padded to SYMBOL_MAX bytes.
+	 */
+	constexpr int8_t frame_size_info_message_symbol(uint8_t len) {
+		return ((len < PAYLOAD_MIN) || (len > SYMBOL_MAX))
+				? -1 : (0x03 + SYMBOL_MAX);
+	}
+
+	constexpr int8_t frame_size_info_message_format() {
+		return 0x07;
+	}
+
+	/**
+	 * @param len payload length [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 */
+	constexpr int8_t frame_size_data_message(uint8_t len) {
+		return ((len < PAYLOAD_MIN) || (len > PAYLOAD_SENSOR_TO_EV3_MAX))
+				? -1 : (0x02 + padded_length(len));
+	}
+	///@}
+
 	/**
 	 * Inserts padding bytes at the end of a payload segment, so that
 	 * the size of the payload segment is a non-negative power of two.
@@ -285,4 +590,8 @@ namespace Framing {
 }
 }
 
+#if EV3UARTGENERATOR_HEADER_ONLY
+#include <framing_impl.hpp>
+#endif
+
 #endif /* FRAMING_HPP_ */
@@ -0,0 +1,273 @@
+/**
+ * \file framing_impl.hpp
+ *
+ * Function definitions for functions in \ref framing.hpp
+ *
+ * Compiled in \c framing.cpp, or included by \ref framing.hpp when the library
+ * is header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#ifndef FRAMING_IMPL_HPP_
+#define FRAMING_IMPL_HPP_
+
+#include <framing.hpp>
+#include <frame_writer.hpp>
+#include <checksum.hpp>
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+namespace EV3UartGenerator {
+namespace Framing {
+	namespace Detail {
+		/**
+		 * Frames a DATA message from samples of type \c T, which are
+		 * described by \c expected in INFO FORMAT messages.
+		 */
+		template <typename T>
+		int8_t frame_samples(uint8_t* dest, const uint8_t mode,
+				const T* samples, const uint8_t count,
+				Magics::INFO_DTYPE data_type, Magics::INFO_DTYPE expected) {
+			if ((data_type != expected) || (count < PAYLOAD_MIN)
+					|| (count > (PAYLOAD_SENSOR_TO_EV3_MAX / sizeof(T))))
+				return -1;
+
+			const uint8_t len { static_cast<uint8_t>(count * sizeof(T)) };
+			FrameWriter writer { dest };
+			writer.put(static_cast<uint8_t>(Magics::DATA::DATA_BASE)
+					| (0x07 & mode)
+					| length_code(len));
+			writer.put_le(samples, count);
+			writer.pad(padding_length(len));
+			return writer.finish();
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_sys_message(uint8_t* dest, Magics::SYS sys_type) {
+		*dest = (static_cast<uint8_t>(sys_type)
+				| static_cast<uint8_t>(Magics::SYS::SYS_BASE));
+		return 0x01;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_cmd_type_message(uint8_t* dest, const uint8_t type) {
+		FrameWriter writer { dest };
+		writer.put(static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+				| static_cast<uint8_t>(Magics::CMD::TYPE)
+				| length_code(0x01));
+		writer.put(type);
+		return writer.finish();
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_cmd_modes_message(uint8_t* dest, const uint8_t modes,
+			const uint8_t modes_available) {
+		FrameWriter writer { dest };
+		writer.put(static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+				| static_cast<uint8_t>(Magics::CMD::MODES)
+				| length_code(0x02));
+		writer.put(0x07 & modes);				// Mask out unused bits
+		writer.put(0x07 & modes_available);	// Mask out unused bits
+		return writer.finish();
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_cmd_speed_message(uint8_t* dest, const uint32_t speed) {
+		FrameWriter writer { dest };
+		writer.put(static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+				| static_cast<uint8_t>(Magics::CMD::SPEED)
+				| length_code(sizeof(speed)));
+		writer.put_le32(speed);
+		return writer.finish();
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_cmd_select_message(uint8_t* dest, const uint8_t mode) {
+		FrameWriter writer { dest };
+		writer.put(static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+				| static_cast<uint8_t>(Magics::CMD::SELECT)
+				| length_code(sizeof(mode)));
+		writer.put(0x07 & mode); 				// Mask out unused bits
+		return writer.finish();
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_cmd_write_message(uint8_t* dest, const uint8_t* data,
+			const uint8_t len) {
+		if ((len < PAYLOAD_MIN) || (len > PAYLOAD_EV3_TO_SENSOR_MAX)) {
+			return -1; // Payload size doesn't fall into limits
+		} else {
+			FrameWriter writer { dest };
+			writer.put(static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+					| static_cast<uint8_t>(Magics::CMD::WRITE)
+					| length_code(len));
+			writer.put(data, len);
+			writer.pad(padding_length(len));
+			return writer.finish();
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_info_message_name(uint8_t* dest, const uint8_t mode,
+			const char* name) {
+		const size_t name_length { name != nullptr ? strlen(name) : 0 };
+		if ((name_length < PAYLOAD_MIN) ||
+				(name_length > PAYLOAD_SENSOR_TO_EV3_MAX)) {
+			return -1; // Name length doesn't fall into limits
+		} else {
+			FrameWriter writer { dest };
+			writer.put(static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+					| (0x07 & mode)
+					| length_code(name_length));
+			writer.put(0x00); // Special case for INFO messages - INFO type byte after type byte
+			writer.put(reinterpret_cast<const uint8_t*>(name), name_length);
+			writer.pad(padding_length(name_length));
+			return writer.finish();
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_info_message_span(uint8_t* dest, const uint8_t mode,
+			Magics::INFO_SPAN span_type, const float lower, const float upper) {
+		FrameWriter writer { dest };
+		writer.put(static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+				| (0x07 & mode)
+				| length_code(sizeof(lower) + sizeof(upper)));
+		writer.put(static_cast<uint8_t>(span_type)); // Special case for INFO messages - INFO type byte after type byte
+		writer.put_le_f32(lower);
+		writer.put_le_f32(upper);
+		return writer.finish();
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_info_message_symbol(uint8_t* dest, const uint8_t mode,
+			const char* symbol) {
+		const size_t symbol_length { symbol != nullptr ? strlen(symbol) : 0 };
+		if ((symbol_length < PAYLOAD_MIN) ||
+				(symbol_length > SYMBOL_MAX)) {
+			return -1; // Name length doesn't fall into limits
+		} else {
+			FrameWriter writer { dest };
+			writer.put(static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+					| (0x07 & mode)
+					| length_code(SYMBOL_MAX)); // Symbols are always padded to 8
+			writer.put(0x04); // Special case for INFO messages - INFO type byte after type byte
+			writer.put(reinterpret_cast<const uint8_t*>(symbol), symbol_length);
+			writer.pad(static_cast<uint8_t>(SYMBOL_MAX - symbol_length));
+			return writer.finish();
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_info_message_format(uint8_t* dest, const uint8_t mode,
+				const uint8_t elems,
+				Magics::INFO_DTYPE data_type, const uint8_t width,
+				const uint8_t decimals) {
+		FrameWriter writer { dest };
+		writer.put(static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+				| (0x07 & mode)
+				| length_code(0x04));
+		writer.put(0x80); // Special case for INFO messages - INFO type byte after type byte
+		writer.put(0x3f & elems);
+		writer.put(0x03 & static_cast<uint8_t>(data_type));
+		writer.put(0x0f & width);
+		writer.put(0x0f & decimals);
+		return writer.finish();
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_data_message(uint8_t* dest, const uint8_t mode,
+			const uint8_t* data, const uint8_t len) {
+		if ((len < PAYLOAD_MIN) || (len > PAYLOAD_SENSOR_TO_EV3_MAX)) {
+			return -1;
+		} else {
+			FrameWriter writer { dest };
+			writer.put(static_cast<uint8_t>(Magics::DATA::DATA_BASE)
+					| (0x07 & mode)
+					| length_code(len));
+			writer.put(data, len);
+			writer.pad(padding_length(len));
+			return writer.finish();
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_data_samples(uint8_t* dest, const uint8_t mode,
+			const int8_t* samples, const uint8_t count,
+			Magics::INFO_DTYPE data_type) {
+		return Detail::frame_samples(dest, mode, samples, count, data_type,
+				Magics::INFO_DTYPE::S8);
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_data_samples(uint8_t* dest, const uint8_t mode,
+			const int16_t* samples, const uint8_t count,
+			Magics::INFO_DTYPE data_type) {
+		return Detail::frame_samples(dest, mode, samples, count, data_type,
+				Magics::INFO_DTYPE::S16);
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_data_samples(uint8_t* dest, const uint8_t mode,
+			const int32_t* samples, const uint8_t count,
+			Magics::INFO_DTYPE data_type) {
+		return Detail::frame_samples(dest, mode, samples, count, data_type,
+				Magics::INFO_DTYPE::S32);
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t frame_data_samples(uint8_t* dest, const uint8_t mode,
+			const float* samples, const uint8_t count,
+			Magics::INFO_DTYPE data_type) {
+		static_assert(sizeof(float) == 0x04, "F32 requires 32 bit floats");
+		return Detail::frame_samples(dest, mode, samples, count, data_type,
+				Magics::INFO_DTYPE::F32);
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int32_t frame_data_messages(uint8_t* dest, const uint8_t mode,
+			const uint8_t* data, const uint8_t len, const uint16_t count) {
+		if ((len < PAYLOAD_MIN) || (len > PAYLOAD_SENSOR_TO_EV3_MAX)) {
+			return -1;
+		} else {
+			const uint8_t type { static_cast<uint8_t>(
+				static_cast<uint8_t>(Magics::DATA::DATA_BASE)
+				| (0x07 & mode)
+				| length_code(len)) };
+			const uint8_t padding { static_cast<uint8_t>(
+				payload_length(type) - len) };
+			const uint8_t* const orig_dest { dest };
+
+			for (uint16_t i = 0; i < count; i++) {
+				FrameWriter writer { dest };
+				writer.put(type);
+				writer.put(data, len);
+				writer.pad(padding);
+				dest += writer.finish();
+				data += len;
+			}
+			return static_cast<int32_t>(dest - orig_dest);
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	uint8_t checksum(const uint8_t* buf, const uint8_t len) {
+		return (0xff ^ Checksum::xor_reduce(buf, len));
+	}
+
+	EV3UARTGENERATOR_INLINE
+	uint8_t insert_padding(uint8_t* dest, uint8_t len) {
+		const uint8_t padding { padding_length(len) };
+		for (uint8_t i = 0; i < padding; i++) {
+			*(dest++) = 0x00;
+		}
+		return padding;
+	}
+
+}
+}
+
+#endif /* FRAMING_IMPL_HPP_ */
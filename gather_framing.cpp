@@ -0,0 +1,16 @@
+/**
+ * \file gather_framing.cpp
+ *
+ * Compiles the definitions in \ref gather_framing_impl.hpp, unless the library is
+ * header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <gather_framing.hpp>
+
+#if !EV3UARTGENERATOR_HEADER_ONLY
+#include <gather_framing_impl.hpp>
+#endif
@@ -0,0 +1,130 @@
+/**
+ * \file gather_framing.hpp
+ *
+ * Functions that frame messages around payloads in place, without copying
+ * them, for scatter-gather output.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page GatherFraming
+ *
+ * The functions in \ref Framing copy payloads into the destination buffer.
+ * For large payloads handed to scatter-gather output (such as \c writev()
+ * on Linux, or DMA descriptor chains on microcontrollers), the functions in
+ * this page frame messages without touching the payload at all:
+ * - the message type byte (and INFO type byte) is written to a small head
+ *   segment
+ * - padding and the checksum are written to a small tail segment
+ * - the payload is referenced in place, and its checksum is computed
+ *   directly from the caller's memory with Checksum::xor_reduce()
+ *
+ * The three segments of a \ref EV3UartGenerator::GatherFraming::GatherFrame,
+ * transmitted in order, are byte-for-byte identical to the message framed by
+ * the corresponding function in \ref Framing.
+ *
+ * \warning The payload is not copied - it must stay valid and unchanged until
+ * the frame has been transmitted.
+ *
+ * On Linux, frames are turned into \c iovec arrays by the functions in
+ * \ref linux/gather_iovec.hpp
+ *
+ * The functions are declared in the file \ref gather_framing.hpp
+ */
+
+#ifndef GATHER_FRAMING_HPP_
+#define GATHER_FRAMING_HPP_
+
+#include <header_only.hpp>
+#include <framing.hpp>
+
+namespace EV3UartGenerator {
+namespace GatherFraming {
+	constexpr uint8_t HEAD_MAX { 0x02 }; ///< Maximum size of the head segment: type byte, and INFO type byte
+	constexpr uint8_t TAIL_MAX { 0x10 }; ///< Maximum size of the tail segment: up to 15 bytes of padding, and the checksum
+
+	/**
+	 * A message, split into segments to be transmitted in order.
+	 */
+	struct GatherFrame {
+		uint8_t head[HEAD_MAX]; ///< Type byte, and INFO type byte for INFO messages
+		uint8_t head_len; ///< Number of bytes used in \c head
+		const uint8_t* payload; ///< Payload, referenced in place
+		uint8_t payload_len; ///< Length of the payload
+		uint8_t tail[TAIL_MAX]; ///< Padding, followed by the checksum
+		uint8_t tail_len; ///< Number of bytes used in \c tail
+
+		/**
+		 * @return total length of the message
+		 */
+		uint8_t size() const {
+			return head_len + payload_len + tail_len;
+		}
+	};
+
+	/**
+	 * Frame an EV3 command message, containing data to be written to the
+	 * sensor, around the data in place.
+	 *
+	 * @param frame destination frame
+	 * @param data data to be sent to the sensor
+	 * @param len length of data [PAYLOAD_MIN, PAYLOAD_EV3_TO_SENSOR_MAX]
+	 * @return length of framed message, if positive.
+	 * @retval -1 on error (data length out of range). \c frame is unchanged.
+	 */
+	int8_t gather_cmd_write_message(GatherFrame& frame, const uint8_t* data,
+			const uint8_t len);
+
+	/**
+	 * Frame an EV3 information message, containing the name of a sensor mode,
+	 * around the name in place.
+	 *
+	 * @param frame destination frame
+	 * @param mode sensor mode index [0, 7]
+	 * @param name null-terminated name, with length in range
+	 * [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 * @return length of framed message, if positive.
+	 * @retval -1 on error (name length out of range). \c frame is unchanged.
+	 *
+	 * @note Only the three least significant mode number bits are
+	 * considered. No out-of-range values will be passed to the EV3.
+	 */
+	int8_t gather_info_message_name(GatherFrame& frame, const uint8_t mode,
+			const char* name);
+
+	/**
+	 * Frame an EV3 data message around the data in place.
+	 *
+	 * @param frame destination frame
+	 * @param mode sensor mode index [0, 7]
+	 * @param data data to be sent to the EV3
+	 * @param len length of data [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 * @return length of framed message, if positive.
+	 * @retval -1 on error (data length out of range). \c frame is unchanged.
+	 *
+	 * @note Only the three least significant mode number bits are
+	 * considered. No out-of-range values will be passed to the EV3.
+	 */
+	int8_t gather_data_message(GatherFrame& frame, const uint8_t mode,
+			const uint8_t* data, const uint8_t len);
+
+	/**
+	 * Copies the segments of a frame into a contiguous buffer, for transports
+	 * without scatter-gather support.
+	 *
+	 * @param dest destination buffer, of at least \c frame.size() bytes
+	 * @param frame source frame
+	 * @return length of the message (written to the buffer)
+	 */
+	uint8_t flatten(uint8_t* dest, const GatherFrame& frame);
+}
+}
+
+#if EV3UARTGENERATOR_HEADER_ONLY
+#include <gather_framing_impl.hpp>
+#endif
+
+#endif /* GATHER_FRAMING_HPP_ */
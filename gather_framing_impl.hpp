@@ -0,0 +1,97 @@
+/**
+ * \file gather_framing_impl.hpp
+ *
+ * Function definitions for functions in \ref gather_framing.hpp
+ *
+ * Compiled in \c gather_framing.cpp, or included by \ref gather_framing.hpp when the library
+ * is header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#ifndef GATHER_FRAMING_IMPL_HPP_
+#define GATHER_FRAMING_IMPL_HPP_
+
+#include <gather_framing.hpp>
+#include <checksum.hpp>
+#include <string.h> // We can't include <cstring> if we want to compile under Arduino
+
+namespace EV3UartGenerator {
+namespace GatherFraming {
+	namespace Detail {
+		/**
+		 * Fills in the payload and tail segments of a frame, whose head
+		 * segment is already in place.
+		 */
+		inline int8_t gather(GatherFrame& frame, const uint8_t* data,
+				const uint8_t len) {
+			const uint8_t padding { Framing::padding_length(len) };
+			uint8_t sum { static_cast<uint8_t>(0xff
+					^ Checksum::xor_reduce(data, len)) };
+			for (uint8_t i = 0; i < frame.head_len; i++)
+				sum ^= frame.head[i];
+			frame.payload = data;
+			frame.payload_len = len;
+			memset(frame.tail, 0x00, padding); // Padding does not change the checksum
+			frame.tail[padding] = sum;
+			frame.tail_len = padding + 0x01;
+			return static_cast<int8_t>(frame.size());
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t gather_cmd_write_message(GatherFrame& frame, const uint8_t* data,
+			const uint8_t len) {
+		if ((len < Framing::PAYLOAD_MIN)
+				|| (len > Framing::PAYLOAD_EV3_TO_SENSOR_MAX))
+			return -1;
+		frame.head[0] = (static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+				| static_cast<uint8_t>(Magics::CMD::WRITE)
+				| Framing::length_code(len));
+		frame.head_len = 0x01;
+		return Detail::gather(frame, data, len);
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t gather_info_message_name(GatherFrame& frame, const uint8_t mode,
+			const char* name) {
+		const size_t name_length { name != nullptr ? strlen(name) : 0 };
+		if ((name_length < Framing::PAYLOAD_MIN)
+				|| (name_length > Framing::PAYLOAD_SENSOR_TO_EV3_MAX))
+			return -1;
+		frame.head[0] = (static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+				| (0x07 & mode)
+				| Framing::length_code(name_length));
+		frame.head[1] = 0x00; // INFO type byte for names
+		frame.head_len = 0x02;
+		return Detail::gather(frame, reinterpret_cast<const uint8_t*>(name),
+				static_cast<uint8_t>(name_length));
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int8_t gather_data_message(GatherFrame& frame, const uint8_t mode,
+			const uint8_t* data, const uint8_t len) {
+		if ((len < Framing::PAYLOAD_MIN)
+				|| (len > Framing::PAYLOAD_SENSOR_TO_EV3_MAX))
+			return -1;
+		frame.head[0] = (static_cast<uint8_t>(Magics::DATA::DATA_BASE)
+				| (0x07 & mode)
+				| Framing::length_code(len));
+		frame.head_len = 0x01;
+		return Detail::gather(frame, data, len);
+	}
+
+	EV3UARTGENERATOR_INLINE
+	uint8_t flatten(uint8_t* dest, const GatherFrame& frame) {
+		memcpy(dest, frame.head, frame.head_len);
+		memcpy(dest + frame.head_len, frame.payload, frame.payload_len);
+		memcpy(dest + frame.head_len + frame.payload_len, frame.tail,
+				frame.tail_len);
+		return frame.size();
+	}
+}
+}
+
+#endif /* GATHER_FRAMING_IMPL_HPP_ */
@@ -0,0 +1,50 @@
+/**
+ * \file header_only.hpp
+ *
+ * Selection between the compiled library and the header-only library.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page HeaderOnly
+ *
+ * By default, the functions of the library are defined out of line, in the
+ * \c .cpp files next to their headers. Calls from user code can then only
+ * be inlined with link time optimization.
+ *
+ * When \c EV3UARTGENERATOR_HEADER_ONLY is defined to 1 for the whole build,
+ * the headers of \ref Checksum, \ref Framing, \ref FrameBuffer,
+ * \ref GatherFraming and \ref Descriptor include their definitions
+ * (\c *_impl.hpp) as inline functions, and the \c .cpp files compile to
+ * nothing. The compiler can then fold constant arguments, such as message
+ * types and mode numbers, into the stores that frame a message.
+ *
+ * \c tools/amalgamate.py concatenates those headers into a single
+ * self-contained header, which is header-only by construction, and can be
+ * dropped into an Arduino sketch or any other project on its own.
+ *
+ * \note The macro must have the same value in every translation unit, as
+ * the same functions are otherwise defined both inline and out of line.
+ */
+
+#ifndef HEADER_ONLY_HPP_
+#define HEADER_ONLY_HPP_
+
+#ifndef EV3UARTGENERATOR_HEADER_ONLY
+#define EV3UARTGENERATOR_HEADER_ONLY 0
+#endif
+
+/**
+ * Marks definitions in \c *_impl.hpp files, which are inline when the
+ * library is header-only.
+ */
+#if EV3UARTGENERATOR_HEADER_ONLY
+#define EV3UARTGENERATOR_INLINE inline
+#else
+#define EV3UARTGENERATOR_INLINE
+#endif
+
+#endif /* HEADER_ONLY_HPP_ */
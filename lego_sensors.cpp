@@ -0,0 +1,89 @@
+/**
+ * \file lego_sensors.cpp
+ *
+ * Definitions of the sensor descriptions in \ref lego_sensors.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <lego_sensors.hpp>
+#include <string.h> // We can't include <cstring> if we want to compile under Arduino
+
+namespace EV3UartGenerator {
+namespace LegoSensors {
+	namespace {
+		using Descriptor::ModeDescriptor;
+		using Descriptor::SpanDescriptor;
+		using Magics::INFO_DTYPE;
+
+		constexpr SpanDescriptor NO_SPAN { false, 0, 0 };
+
+		// Upper bound of 1020.1875 (0x447f0c00) matches the bitstream exactly
+		const ModeDescriptor color_modes[] {
+			{ "COL-REFLECT", { true, 0, 100 }, NO_SPAN, { true, 0, 100 },
+					"pct", 1, INFO_DTYPE::S8, 3, 0 },
+			{ "COL-AMBIENT", { true, 0, 100 }, NO_SPAN, { true, 0, 100 },
+					"pct", 1, INFO_DTYPE::S8, 3, 0 },
+			{ "COL-COLOR", { true, 0, 8 }, NO_SPAN, { true, 0, 8 },
+					"col", 1, INFO_DTYPE::S8, 2, 0 },
+			{ "REF-RAW", { true, 0, 1020.1875 }, NO_SPAN,
+					{ true, 0, 1020.1875 }, nullptr, 2, INFO_DTYPE::S16, 4, 0 },
+			{ "RGB-RAW", { true, 0, 1020.1875 }, NO_SPAN,
+					{ true, 0, 1020.1875 }, nullptr, 3, INFO_DTYPE::S16, 4, 0 },
+			{ "COL-CAL", { true, 0, 65535 }, NO_SPAN, { true, 0, 65535 },
+					nullptr, 4, INFO_DTYPE::S16, 5, 0 },
+		};
+
+		const ModeDescriptor ultrasonic_modes[] {
+			{ "US-DIST-CM", { true, 0, 2550 }, NO_SPAN, { true, 0, 255 },
+					"cm", 1, INFO_DTYPE::S16, 5, 1 },
+			{ "US-DIST-IN", { true, 0, 1000 }, NO_SPAN, { true, 0, 100 },
+					"inch", 1, INFO_DTYPE::S16, 5, 1 },
+			{ "US-LISTEN", { true, 0, 1 }, NO_SPAN, { true, 0, 1 },
+					nullptr, 1, INFO_DTYPE::S8, 1, 0 },
+			{ "US-SI-CM", { true, 0, 2550 }, NO_SPAN, { true, 0, 255 },
+					"cm", 1, INFO_DTYPE::S16, 5, 1 },
+			{ "US-SI-IN", { true, 0, 1000 }, NO_SPAN, { true, 0, 100 },
+					"inch", 1, INFO_DTYPE::S16, 5, 1 },
+			{ "US-DC-CM", { true, 0, 2550 }, NO_SPAN, { true, 0, 255 },
+					"cm", 1, INFO_DTYPE::S16, 5, 1 },
+			{ "US-DC-IN", { true, 0, 1000 }, NO_SPAN, { true, 0, 100 },
+					"inch", 1, INFO_DTYPE::S16, 5, 1 },
+		};
+
+		const ModeDescriptor gyro_modes[] {
+			{ "GYRO-ANG", { true, -180, 180 }, NO_SPAN, { true, -180, 180 },
+					"deg", 1, INFO_DTYPE::S16, 4, 0 },
+			{ "GYRO-RATE", { true, -500, 500 }, NO_SPAN, { true, -500, 500 },
+					"d/s", 1, INFO_DTYPE::S16, 3, 0 },
+			{ "GYRO-FAS", { true, -2000, 2000 }, NO_SPAN,
+					{ true, -2000, 2000 }, nullptr, 1, INFO_DTYPE::S16, 4, 0 },
+			{ "GYRO-G&A", { true, -180, 180 }, NO_SPAN, { true, -180, 180 },
+					nullptr, 2, INFO_DTYPE::S16, 5, 0 },
+			{ "GYRO-CAL", { true, -32768, 32767 }, NO_SPAN,
+					{ true, -32768, 32767 }, nullptr, 4, INFO_DTYPE::S16, 5, 0 },
+			{ "TILT-RATE", { true, -500, 500 }, NO_SPAN, { true, -500, 500 },
+					"d/s", 1, INFO_DTYPE::S16, 3, 0 },
+			{ "TILT-ANG", { true, -180, 180 }, NO_SPAN, { true, -180, 180 },
+					"deg", 1, INFO_DTYPE::S16, 3, 0 },
+		};
+	}
+
+	const Descriptor::SensorDescriptor COLOR { 29, 6, 3, 57600, color_modes };
+	const Descriptor::SensorDescriptor ULTRASONIC { 30, 7, 3, 57600,
+		ultrasonic_modes };
+	const Descriptor::SensorDescriptor GYRO { 32, 7, 2, 57600, gyro_modes };
+
+	const Descriptor::SensorDescriptor* find(const char* name) {
+		if (strcmp(name, "color") == 0)
+			return &COLOR;
+		if (strcmp(name, "ultrasonic") == 0)
+			return &ULTRASONIC;
+		if (strcmp(name, "gyro") == 0)
+			return &GYRO;
+		return nullptr;
+	}
+}
+}
@@ -0,0 +1,51 @@
+/**
+ * \file lego_sensors.hpp
+ *
+ * Descriptions of the LEGO sensors in the LEGO education base set, as
+ * presented to the EV3 during initialization.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page LegoSensors
+ *
+ * Ready made descriptions of the following LEGO sensors, which frame to
+ * handshakes identical to the reference bitstreams found under
+ * \c doc/reference_bitstreams/ :
+ * - \ref EV3UartGenerator::LegoSensors::COLOR (LEGO Color sensor)
+ * - \ref EV3UartGenerator::LegoSensors::ULTRASONIC (LEGO Ultrasonic distance
+ *   sensor)
+ * - \ref EV3UartGenerator::LegoSensors::GYRO (LEGO Gyro sensor)
+ *
+ * They are useful for emulating the sensors, and as examples of sensor
+ * descriptions. See \ref Descriptor for more details.
+ *
+ * The descriptions are declared in the file \ref lego_sensors.hpp
+ */
+
+#ifndef LEGO_SENSORS_HPP_
+#define LEGO_SENSORS_HPP_
+
+#include <sensor_descriptor.hpp>
+
+namespace EV3UartGenerator {
+namespace LegoSensors {
+	extern const Descriptor::SensorDescriptor COLOR; ///< LEGO Color sensor (type 29)
+	extern const Descriptor::SensorDescriptor ULTRASONIC; ///< LEGO Ultrasonic distance sensor (type 30)
+	extern const Descriptor::SensorDescriptor GYRO; ///< LEGO Gyro sensor (type 32)
+
+	/**
+	 * Looks up a sensor description by name.
+	 *
+	 * @param name one of \c "color", \c "ultrasonic" or \c "gyro"
+	 * @return sensor description
+	 * @retval nullptr if there is no sensor with that name
+	 */
+	const Descriptor::SensorDescriptor* find(const char* name);
+}
+}
+
+#endif /* LEGO_SENSORS_HPP_ */
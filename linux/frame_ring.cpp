@@ -0,0 +1,64 @@
+/**
+ * \file frame_ring.cpp
+ *
+ * Function definitions for functions in \ref linux/frame_ring.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/frame_ring.hpp>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	namespace {
+		size_t round_capacity(size_t capacity) {
+			size_t rounded { Framing::BUFFER_MIN };
+			rounded |= (rounded >> 1);
+			rounded |= (rounded >> 2);
+			rounded |= (rounded >> 4);
+			rounded++; // Smallest power of two holding BUFFER_MIN bytes
+			while (rounded < capacity)
+				rounded *= 2;
+			return rounded;
+		}
+	}
+
+	FrameRing::FrameRing(size_t capacity)
+		: mask { round_capacity(capacity) - 1 },
+			// Spare bytes for messages crossing the end, see commit()
+			storage { new uint8_t[mask + 1 + Framing::BUFFER_MIN] },
+			head { 0 }, cached_tail { 0 }, tail { 0 } {
+	}
+
+	int FrameRing::peek(struct iovec (&iov)[RING_IOVECS]) const {
+		const size_t position { tail.load(std::memory_order_relaxed) };
+		const size_t queued { head.load(std::memory_order_acquire) - position };
+		if (queued == 0)
+			return 0;
+
+		const size_t offset { position & mask };
+		const size_t first { ((offset + queued) > capacity())
+				? (capacity() - offset) : queued };
+		iov[0].iov_base = storage.get() + offset;
+		iov[0].iov_len = first;
+		if (first == queued)
+			return 1;
+		iov[1].iov_base = storage.get();
+		iov[1].iov_len = queued - first;
+		return 2;
+	}
+
+	ssize_t FrameRing::drain(Transport& transport) {
+		struct iovec iov[RING_IOVECS];
+		const int segments { peek(iov) };
+		if (segments == 0)
+			return 0;
+		size_t written;
+		const ssize_t result { transport.writev(iov, segments, &written) };
+		consume(written); // Even on error, so that a retry does not repeat bytes
+		return result;
+	}
+}
+}
@@ -0,0 +1,200 @@
+/**
+ * \file frame_ring.hpp
+ *
+ * Lock-free queue of framed messages, from a producer thread to the thread
+ * writing to a tty.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page FrameRing
+ *
+ * \ref EV3UartGenerator::Linux::FrameRing hands framed messages from one
+ * producer thread (e.g. a simulation producing samples) to one consumer
+ * thread (writing to a tty with a \ref Transport):
+ * - messages are stored back to back in a single byte ring, so that all
+ *   queued messages are written with a single \c writev() of at most two
+ *   segments
+ * - the producer frames messages in place: reserve() returns space for
+ *   BUFFER_MIN bytes, which any of the functions in \ref Framing can write
+ *   to, and commit() publishes the message. A message which crosses the end
+ *   of the ring is written into spare bytes past the end, and copied to the
+ *   start by commit(), so the framing functions never see the wrap
+ * - neither side blocks, locks or allocates: reserve() fails when the ring
+ *   is full, and the producer decides whether to drop or to retry the
+ *   message
+ * - the position written by the producer and the position written by the
+ *   consumer are kept on separate cache lines, and the producer only reads
+ *   the position of the consumer when its cached copy says that the ring is
+ *   full
+ *
+ * \code
+ * // Producer thread
+ * uint8_t* const dest { ring.reserve() };
+ * if (dest != nullptr) {
+ *     const int8_t size { Framing::frame_data_samples(dest, 0, samples, 3,
+ *             Magics::INFO_DTYPE::S16) };
+ *     if (size > 0)
+ *         ring.commit(size);
+ * }
+ *
+ * // Consumer thread
+ * if (ring.drain(transport) < 0)
+ *     ... // Write error
+ * \endcode
+ *
+ * The ring is declared in the file \ref linux/frame_ring.hpp
+ */
+
+#ifndef LINUX_FRAME_RING_HPP_
+#define LINUX_FRAME_RING_HPP_
+
+#include <linux/transport.hpp>
+#include <framing.hpp>
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	constexpr size_t CACHE_LINE { 0x40 }; ///< Size of a cache line, which the positions of the producer and consumer do not share
+	constexpr int RING_IOVECS { 0x02 }; ///< Maximum number of \c iovec segments describing the contents of a FrameRing
+
+	/**
+	 * Bounded single-producer, single-consumer queue of framed messages.
+	 *
+	 * Producer functions - reserve(), commit() and push() - may only be
+	 * called from one thread at a time, and consumer functions - peek(),
+	 * consume() and drain() - from one other thread at a time.
+	 */
+	class FrameRing {
+	public:
+		/**
+		 * Allocates the ring.
+		 *
+		 * @param capacity capacity in bytes, rounded up to a power of two
+		 * of at least BUFFER_MIN bytes
+		 */
+		explicit FrameRing(size_t capacity);
+		FrameRing(const FrameRing&) = delete;
+		FrameRing& operator=(const FrameRing&) = delete;
+
+		/**
+		 * @return capacity in bytes
+		 */
+		size_t capacity() const {
+			return mask + 1;
+		}
+
+		/**
+		 * @return number of queued bytes, which may already be out of date
+		 * when called from a thread other than the consumer
+		 */
+		size_t size() const {
+			return head.load(std::memory_order_acquire)
+					- tail.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * Reserves space for the next message (producer).
+		 *
+		 * @return destination for a message of up to BUFFER_MIN bytes, valid
+		 * until commit()
+		 * @retval nullptr if less than BUFFER_MIN bytes are free
+		 */
+		uint8_t* reserve() {
+			const size_t position { head.load(std::memory_order_relaxed) };
+			if ((capacity() - (position - cached_tail)) < Framing::BUFFER_MIN) {
+				cached_tail = tail.load(std::memory_order_acquire);
+				if ((capacity() - (position - cached_tail)) < Framing::BUFFER_MIN)
+					return nullptr;
+			}
+			return storage.get() + (position & mask);
+		}
+
+		/**
+		 * Queues the message written to the space returned by reserve()
+		 * (producer).
+		 *
+		 * @param size size of the message, at most BUFFER_MIN bytes
+		 */
+		void commit(uint8_t size) {
+			const size_t position { head.load(std::memory_order_relaxed) };
+			const size_t offset { position & mask };
+			if ((offset + size) > capacity()) // Wrap the spare bytes around
+				memcpy(storage.get(), storage.get() + capacity(),
+						(offset + size) - capacity());
+			head.store(position + size, std::memory_order_release);
+		}
+
+		/**
+		 * Queues a copy of a framed message (producer).
+		 *
+		 * @param message framed message
+		 * @param size size of the message, at most BUFFER_MIN bytes
+		 * @return whether the message was queued, \c false if the ring is
+		 * full
+		 */
+		bool push(const uint8_t* message, uint8_t size) {
+			uint8_t* const dest { reserve() };
+			if (dest == nullptr)
+				return false;
+			memcpy(dest, message, size);
+			commit(size);
+			return true;
+		}
+
+		/**
+		 * Describes all queued bytes (consumer).
+		 *
+		 * @param iov destination, receiving the queued bytes in order
+		 * @return number of segments written, 0 if the ring is empty
+		 */
+		int peek(struct iovec (&iov)[RING_IOVECS]) const;
+
+		/**
+		 * Removes bytes described by peek() from the ring (consumer).
+		 *
+		 * @param len number of bytes, at most the total length returned by
+		 * peek()
+		 */
+		void consume(size_t len) {
+			tail.store(tail.load(std::memory_order_relaxed) + len,
+					std::memory_order_release);
+		}
+
+		/**
+		 * Writes all queued bytes to a transport with a single \c writev()
+		 * (retried on partial writes), and removes them from the ring
+		 * (consumer).
+		 *
+		 * @param transport destination transport
+		 * @return number of bytes written, 0 if the ring is empty
+		 * @retval -1 on error (bytes written before the error are removed
+		 * from the ring, the others stay queued)
+		 */
+		ssize_t drain(Transport& transport);
+
+	private:
+		// Read by both threads, never written after construction
+		const size_t mask;
+		const std::unique_ptr<uint8_t[]> storage;
+
+		// Written by the producer
+		alignas(CACHE_LINE) std::atomic<size_t> head;
+		size_t cached_tail; ///< Last value of tail read by the producer
+
+		// Written by the consumer
+		alignas(CACHE_LINE) std::atomic<size_t> tail;
+	};
+}
+}
+
+#endif /* LINUX_FRAME_RING_HPP_ */
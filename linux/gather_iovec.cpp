@@ -0,0 +1,47 @@
+/**
+ * \file gather_iovec.cpp
+ *
+ * Function definitions for functions in \ref linux/gather_iovec.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/gather_iovec.hpp>
+#include <limits.h>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	int to_iovec(const GatherFraming::GatherFrame& frame, struct iovec* iov) {
+		iov[0].iov_base = const_cast<uint8_t*>(frame.head);
+		iov[0].iov_len = frame.head_len;
+		iov[1].iov_base = const_cast<uint8_t*>(frame.payload);
+		iov[1].iov_len = frame.payload_len;
+		iov[2].iov_base = const_cast<uint8_t*>(frame.tail);
+		iov[2].iov_len = frame.tail_len;
+		return FRAME_IOVECS;
+	}
+
+	ssize_t write_frames(Transport& transport,
+			const GatherFraming::GatherFrame* frames, size_t count) {
+		constexpr size_t FRAMES_PER_CALL { IOV_MAX / FRAME_IOVECS };
+		struct iovec iov[FRAMES_PER_CALL * FRAME_IOVECS];
+		ssize_t total { 0 };
+		while (count > 0) {
+			const size_t batch { (count < FRAMES_PER_CALL) ? count
+					: FRAMES_PER_CALL };
+			int segments { 0 };
+			for (size_t i = 0; i < batch; i++)
+				segments += to_iovec(frames[i], iov + segments);
+			const ssize_t written { transport.writev(iov, segments) };
+			if (written < 0)
+				return -1;
+			total += written;
+			frames += batch;
+			count -= batch;
+		}
+		return total;
+	}
+}
+}
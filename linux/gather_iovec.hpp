@@ -0,0 +1,49 @@
+/**
+ * \file gather_iovec.hpp
+ *
+ * Scatter-gather output of frames from \ref gather_framing.hpp, with
+ * \c writev().
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#ifndef LINUX_GATHER_IOVEC_HPP_
+#define LINUX_GATHER_IOVEC_HPP_
+
+#include <gather_framing.hpp>
+#include <linux/transport.hpp>
+#include <sys/uio.h>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	constexpr int FRAME_IOVECS { 0x03 }; ///< Number of \c iovec segments per frame: head, payload and tail
+
+	/**
+	 * Describes the segments of a frame as \c iovec segments. The payload
+	 * segment points to the caller's payload.
+	 *
+	 * @param frame source frame
+	 * @param iov destination, with space for FRAME_IOVECS segments
+	 * @return number of segments written (FRAME_IOVECS)
+	 */
+	int to_iovec(const GatherFraming::GatherFrame& frame, struct iovec* iov);
+
+	/**
+	 * Writes frames to a transport with as few \c writev() calls as possible
+	 * (one per \c IOV_MAX / FRAME_IOVECS frames). Payloads are only copied
+	 * by the kernel.
+	 *
+	 * @param transport destination transport
+	 * @param frames frames to write
+	 * @param count number of frames
+	 * @return total number of bytes written on success
+	 * @retval -1 on error
+	 */
+	ssize_t write_frames(Transport& transport,
+			const GatherFraming::GatherFrame* frames, size_t count);
+}
+}
+
+#endif /* LINUX_GATHER_IOVEC_HPP_ */
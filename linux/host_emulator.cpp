@@ -0,0 +1,239 @@
+/**
+ * \file host_emulator.cpp
+ *
+ * Function definitions for functions in \ref linux/host_emulator.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/host_emulator.hpp>
+#include <framing.hpp>
+#include <magics.hpp>
+#include <simple_endian.hpp>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <initializer_list>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	namespace {
+		uint64_t now_us() {
+			struct timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			return (static_cast<uint64_t>(ts.tv_sec) * 1000000)
+					+ (ts.tv_nsec / 1000);
+		}
+
+		/**
+		 * Milliseconds until a deadline, rounded up so that poll() does not
+		 * return before the deadline.
+		 */
+		int ms_until(uint64_t deadline, uint64_t now) {
+			return (deadline > now) ? static_cast<int>(((deadline - now) + 999)
+					/ 1000) : 0;
+		}
+
+		void record(LatencyStats& stats, uint64_t rtt) {
+			if ((stats.count == 0) || (rtt < stats.min))
+				stats.min = rtt;
+			if (rtt > stats.max)
+				stats.max = rtt;
+			stats.total += rtt;
+			stats.count++;
+		}
+
+		/**
+		 * Next time a message has to be sent, or 0 if it is disabled.
+		 */
+		uint64_t first(uint64_t start, uint16_t interval) {
+			return interval ? (start + (interval * 1000ull)) : 0;
+		}
+
+		bool due(uint64_t deadline, uint64_t now) {
+			return (deadline != 0) && (now >= deadline);
+		}
+	}
+
+	HostEmulator::HostEmulator()
+		: slave { -1 }, path { }, sensor_info { }, registry { &sensor_info, 1 },
+		  sensor_infos { 0 }, run_stats { } {
+	}
+
+	HostEmulator::~HostEmulator() {
+		if (slave >= 0)
+			::close(slave);
+	}
+
+	int HostEmulator::open() {
+		const int master { posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC) };
+		if (master < 0)
+			return -1;
+		if ((grantpt(master) < 0) || (unlockpt(master) < 0)
+				|| (ptsname_r(master, path, sizeof(path)) != 0)) {
+			::close(master);
+			return -1;
+		}
+		// Holding the slave side open keeps the master from seeing hangups
+		// before (and between) sensors opening it
+		slave = ::open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+		if (slave < 0) {
+			::close(master);
+			return -1;
+		}
+		return transport.adopt(master);
+	}
+
+	const char* HostEmulator::slave_path() const {
+		return (transport.fd() >= 0) ? path : nullptr;
+	}
+
+	int HostEmulator::handshake(int timeout_ms) {
+		uint8_t buf[0x100];
+		Decoding::Frame frame;
+
+		if (transport.set_baud(HANDSHAKE_BAUD) < 0)
+			return -1;
+		decoder.reset();
+		registry.reset(0);
+		sensor_infos = 0;
+		const uint64_t deadline { now_us() + (timeout_ms * 1000ull) };
+		for (;;) {
+			int wait { -1 }; // Negative timeouts wait forever
+			if (timeout_ms >= 0) {
+				const uint64_t now { now_us() };
+				if (now >= deadline) {
+					errno = ETIMEDOUT;
+					return -1;
+				}
+				wait = ms_until(deadline, now);
+			}
+			const ssize_t got { transport.read(buf, sizeof(buf), wait) };
+			if (got < 0)
+				return -1;
+			decoder.feed(buf, got);
+
+			while (decoder.next(frame)) {
+				if (frame.is(Magics::CMD::TYPE))
+					sensor_infos = 0; // Start of a (possibly repeated) handshake
+				else if (frame.is_info())
+					sensor_infos++;
+
+				const int8_t result { registry.receive(0, frame) };
+				if (frame.is(Magics::SYS::ACK)) {
+					if (result != 1) {
+						errno = EPROTO;
+						return -1;
+					}
+					uint8_t ack[1];
+					Framing::frame_sys_message(ack, Magics::SYS::ACK);
+					if ((transport.write(ack, sizeof(ack)) < 0)
+							|| (transport.drain() < 0))
+						return -1;
+					return transport.set_baud(sensor_info.speed);
+				}
+			}
+		}
+	}
+
+	int HostEmulator::run(int duration_ms, const HostSchedule& schedule) {
+		uint8_t nack[1];
+		uint8_t select[Framing::BUFFER_MIN];
+		uint8_t write[Framing::BUFFER_MIN];
+		uint8_t payload[Framing::PAYLOAD_EV3_TO_SENSOR_MAX];
+		uint8_t buf[0x100];
+		Decoding::Frame frame;
+
+		Framing::frame_sys_message(nack, Magics::SYS::NACK);
+		for (uint8_t i = 0; i < sizeof(payload); i++)
+			payload[i] = i;
+		const int8_t write_size { Framing::frame_cmd_write_message(write,
+				payload, schedule.write_len) };
+		if ((schedule.write_interval != 0) && (write_size < 0)) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		run_stats = HostStats { };
+		const uint64_t discarded { decoder.discarded() };
+		const uint64_t checksum_errors { decoder.checksum_errors() };
+		const uint64_t start { now_us() };
+		const uint64_t end { start + (duration_ms * 1000ull) };
+		uint64_t next_nack { first(start, schedule.nack_interval) };
+		uint64_t next_select { first(start, schedule.select_interval) };
+		uint64_t next_write { first(start, schedule.write_interval) };
+		uint64_t nack_sent { 0 }; // Outstanding keepalive, if not 0
+		uint64_t select_sent { 0 }; // Outstanding mode change, if not 0
+		uint8_t selected { 0 };
+
+		for (;;) {
+			uint64_t now { now_us() };
+			if (now >= end)
+				break;
+
+			if (due(next_nack, now)) {
+				if (transport.write(nack, sizeof(nack)) < 0)
+					return -1;
+				if (nack_sent == 0)
+					nack_sent = now;
+				run_stats.nacks++;
+				next_nack += schedule.nack_interval * 1000ull;
+			}
+			if (due(next_select, now) && (sensor_info.mode_count > 0)) {
+				selected = (selected + 1) % sensor_info.mode_count;
+				const int8_t size { Framing::frame_cmd_select_message(select,
+						selected) };
+				if (transport.write(select, size) < 0)
+					return -1;
+				select_sent = now;
+				run_stats.selects++;
+				next_select += schedule.select_interval * 1000ull;
+			}
+			if (due(next_write, now)) {
+				if (transport.write(write, write_size) < 0)
+					return -1;
+				run_stats.writes++;
+				next_write += schedule.write_interval * 1000ull;
+			}
+
+			uint64_t wake { end };
+			for (const uint64_t deadline : { next_nack, next_select, next_write }) {
+				if ((deadline != 0) && (deadline < wake))
+					wake = deadline;
+			}
+			const ssize_t got { transport.read(buf, sizeof(buf),
+					ms_until(wake, now)) };
+			if (got < 0)
+				return -1;
+			now = now_us();
+			decoder.feed(buf, got);
+
+			while (decoder.next(frame)) {
+				if (!frame.is_data())
+					continue;
+				run_stats.data_messages++;
+				run_stats.data_bytes += frame.size;
+				if (registry.lookup(0, frame) == nullptr)
+					run_stats.data_malformed++;
+				if (nack_sent != 0) {
+					record(run_stats.nack_rtt, now - nack_sent);
+					nack_sent = 0;
+				}
+				if ((select_sent != 0) && (frame.mode() == selected)) {
+					record(run_stats.select_rtt, now - select_sent);
+					select_sent = 0;
+				}
+			}
+		}
+
+		run_stats.elapsed = now_us() - start;
+		run_stats.discarded = decoder.discarded() - discarded;
+		run_stats.checksum_errors = decoder.checksum_errors() - checksum_errors;
+		return 0;
+	}
+}
+}
@@ -0,0 +1,209 @@
+/**
+ * \file host_emulator.hpp
+ *
+ * Emulation of the EV3 side of the EV3 UART sensor protocol, over a
+ * pseudo-terminal, for end-to-end testing and load generation.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page HostEmulator
+ *
+ * \ref EV3UartGenerator::Linux::HostEmulator plays the part of the EV3:
+ * - it opens a pseudo-terminal pair, and keeps the master side. Sensors
+ *   under test open the slave side, as they would open a tty.
+ * - it consumes the handshake of the sensor into a
+ *   \ref EV3UartGenerator::Registry::SensorInfo (see \ref Registry), and
+ *   acknowledges it with \c SYS \c ACK once the sensor has sent its own
+ *   \c SYS \c ACK
+ * - it switches to the baudrate advertised by the sensor
+ * - it then issues \c SYS \c NACK keepalives, \c CMD \c SELECT and
+ *   \c CMD \c WRITE messages on a configurable
+ *   \ref EV3UartGenerator::Linux::HostSchedule
+ *
+ * While the schedule runs, it measures:
+ * - time to the next \c DATA message after a keepalive: time from sending
+ *   \c SYS \c NACK to receiving the next \c DATA message, of any mode.
+ *   This is not a round trip - the message may have been sent before the
+ *   sensor saw the \c SYS \c NACK, so while the sensor sends \c DATA
+ *   messages periodically, the measurement is bounded by their interval
+ * - round trip latency of mode changes: time from sending \c CMD \c SELECT to
+ *   receiving the first \c DATA message in the new mode
+ * - \c DATA message throughput, and corrupted / discarded bytes
+ * - \c DATA messages which do not match the format of their mode
+ *
+ * The emulator is declared in the file \ref linux/host_emulator.hpp
+ */
+
+#ifndef LINUX_HOST_EMULATOR_HPP_
+#define LINUX_HOST_EMULATOR_HPP_
+
+#include <linux/transport.hpp>
+#include <decoding.hpp>
+#include <sensor_registry.hpp>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	/**
+	 * Traffic issued by the emulator after the handshake. Intervals are in
+	 * milliseconds; an interval of 0 disables that kind of message.
+	 */
+	struct HostSchedule {
+		uint16_t nack_interval; ///< Interval between \c SYS \c NACK keepalives
+		uint16_t select_interval; ///< Interval between \c CMD \c SELECT messages, cycling through all modes
+		uint16_t write_interval; ///< Interval between \c CMD \c WRITE messages
+		uint8_t write_len; ///< Payload length of \c CMD \c WRITE messages [PAYLOAD_MIN, PAYLOAD_EV3_TO_SENSOR_MAX]
+	};
+
+	constexpr HostSchedule DEFAULT_SCHEDULE { 100, 0, 0, 1 }; ///< Keepalives only, as sent by the EV3
+
+	/**
+	 * Round trip latency statistics, in microseconds.
+	 */
+	struct LatencyStats {
+		uint64_t count; ///< Number of round trips measured
+		uint64_t min; ///< Shortest round trip
+		uint64_t max; ///< Longest round trip
+		uint64_t total; ///< Sum of all round trips
+
+		/**
+		 * @return mean round trip latency, or 0 if nothing was measured
+		 */
+		uint64_t mean() const {
+			return count ? (total / count) : 0;
+		}
+	};
+
+	/**
+	 * Measurements taken while running a schedule.
+	 */
+	struct HostStats {
+		uint64_t elapsed; ///< Time spent running the schedule, in microseconds
+		uint64_t data_messages; ///< \c DATA messages received
+		uint64_t data_bytes; ///< Bytes of \c DATA messages received
+		uint64_t data_malformed; ///< \c DATA messages too short for the format of their mode, or for modes without a format
+		uint64_t nacks; ///< \c SYS \c NACK messages sent
+		uint64_t selects; ///< \c CMD \c SELECT messages sent
+		uint64_t writes; ///< \c CMD \c WRITE messages sent
+		uint64_t discarded; ///< Bytes discarded while resynchronizing
+		uint64_t checksum_errors; ///< Messages dropped due to checksum mismatches
+		LatencyStats nack_rtt; ///< Time to the next \c DATA message after \c SYS \c NACK - not a round trip, see \ref HostEmulator
+		LatencyStats select_rtt; ///< Mode change round trips
+
+		/**
+		 * @return \c DATA messages received per second
+		 */
+		double data_rate() const {
+			return elapsed ? (data_messages * 1e6 / elapsed) : 0;
+		}
+	};
+
+	/**
+	 * EV3 emulator on the master side of a pseudo-terminal pair.
+	 */
+	class HostEmulator {
+	public:
+		HostEmulator();
+		~HostEmulator();
+		HostEmulator(const HostEmulator&) = delete;
+		HostEmulator& operator=(const HostEmulator&) = delete;
+
+		/**
+		 * Opens a pseudo-terminal pair.
+		 *
+		 * @retval 0 on success
+		 * @retval -1 on error
+		 */
+		int open();
+
+		/**
+		 * @return path of the slave side, to be opened by the sensor, or
+		 * \c nullptr if not open
+		 */
+		const char* slave_path() const;
+
+		/**
+		 * Waits for a complete handshake from the sensor, acknowledges it
+		 * and switches to the baudrate advertised by the sensor.
+		 *
+		 * Handshakes which are restarted by the sensor midway are followed.
+		 *
+		 * @param timeout_ms maximum time to wait, or -1 to wait forever
+		 * @retval 0 on success
+		 * @retval -1 on error (\c ETIMEDOUT if no complete handshake arrived,
+		 * \c EPROTO if the handshake lacked \c CMD \c TYPE, \c CMD \c MODES,
+		 * \c CMD \c SPEED or the \c INFO \c FORMAT message of a mode, see
+		 * Registry::SensorRegistry::receive())
+		 */
+		int handshake(int timeout_ms);
+
+		/**
+		 * Issues traffic according to a schedule, and measures the responses
+		 * of the sensor. Statistics are reset at the start of every run.
+		 *
+		 * @param duration_ms duration of the run
+		 * @param schedule traffic to issue
+		 * @retval 0 on success
+		 * @retval -1 on error
+		 */
+		int run(int duration_ms, const HostSchedule& schedule = DEFAULT_SCHEDULE);
+
+		/**
+		 * @return sensor type index, from the handshake
+		 */
+		uint8_t type() const {
+			return sensor_info.type;
+		}
+
+		/**
+		 * @return number of modes of the sensor, from the handshake
+		 */
+		uint8_t modes() const {
+			return sensor_info.mode_count;
+		}
+
+		/**
+		 * @return baudrate of the sensor, from the handshake
+		 */
+		uint32_t speed() const {
+			return sensor_info.speed;
+		}
+
+		/**
+		 * @return everything known about the sensor, from the handshake
+		 */
+		const Registry::SensorInfo& sensor() const {
+			return sensor_info;
+		}
+
+		/**
+		 * @return number of INFO messages in the handshake
+		 */
+		uint16_t info_messages() const {
+			return sensor_infos;
+		}
+
+		/**
+		 * @return measurements of the last run
+		 */
+		const HostStats& stats() const {
+			return run_stats;
+		}
+
+	private:
+		Transport transport;
+		int slave;
+		char path[0x40];
+		Decoding::FrameDecoder decoder;
+		Registry::SensorInfo sensor_info;
+		Registry::SensorRegistry registry;
+		uint16_t sensor_infos;
+		HostStats run_stats;
+	};
+}
+}
+
+#endif /* LINUX_HOST_EMULATOR_HPP_ */
@@ -0,0 +1,345 @@
+/**
+ * \file io_batch.cpp
+ *
+ * Function definitions for functions in \ref linux/io_batch.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/io_batch.hpp>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <memory>
+
+#if defined(EV3UARTGENERATOR_IO_URING)
+#include <linux/io_uring.h>
+
+// System call numbers are shared by all architectures since Linux 5.1, but
+// older C libraries do not define them
+#if !defined(__NR_io_uring_setup)
+#define __NR_io_uring_setup 425
+#define __NR_io_uring_enter 426
+#define __NR_io_uring_register 427
+#endif
+#endif
+
+namespace EV3UartGenerator {
+namespace Linux {
+#if defined(EV3UARTGENERATOR_IO_URING)
+	namespace {
+		// User data of entries: the generation of the submission in the high
+		// half, and the index of the operation, or one of these, in the low
+		// half
+		constexpr uint32_t LINK_TIMEOUT { UINT32_MAX }; ///< Timeout linked to an operation
+		constexpr uint32_t CANCEL { UINT32_MAX - 1 }; ///< Cancellation of an operation
+
+		constexpr uint64_t tag(uint32_t generation, uint32_t index) {
+			return (static_cast<uint64_t>(generation) << 32) | index;
+		}
+
+		/**
+		 * Back-off while the kernel is short of resources, with nothing in
+		 * flight to wait for.
+		 */
+		const struct timespec CONGESTED { 0, 100000 };
+
+		/**
+		 * Timeout of operations which can not complete right away - one
+		 * tick of a farm. Pollable files, such as ttys, are otherwise waited
+		 * on by the \c io_uring, even when opened with \c O_NONBLOCK. Ttys
+		 * are written by worker threads of the \c io_uring, which a timeout
+		 * of zero would interrupt before they get to run.
+		 */
+		const struct __kernel_timespec BLOCKED { 0, 1000000 };
+	}
+#endif
+
+	IoBatch::IoBatch(IoBackend preferred)
+		: submitted { false }, calls { 0 }, ring_fd { -1 }, generation { 0 },
+		  rings { nullptr }, rings_size { 0 }, sqes { nullptr }, sqes_size { 0 },
+		  sq_head { nullptr }, sq_tail { nullptr }, sq_mask { 0 },
+		  sq_array { nullptr }, cq_head { nullptr }, cq_tail { nullptr },
+		  cq_mask { 0 }, cqes { nullptr } {
+		if ((preferred == IoBackend::URING) && (setup() < 0))
+			teardown();
+	}
+
+	IoBatch::~IoBatch() {
+		teardown();
+	}
+
+	void IoBatch::queue(int fd, uint8_t* buf, size_t len, bool write) {
+		if (submitted) {
+			ops.clear();
+			submitted = false;
+		}
+		ops.push_back(Op { fd, write, buf, len, 0, false });
+	}
+
+	int IoBatch::submit() {
+		submitted = true;
+		if (ring_fd >= 0) {
+			for (size_t first = 0; first < ops.size(); first += IO_BATCH_ENTRIES) {
+				const size_t count { ((ops.size() - first) < IO_BATCH_ENTRIES)
+						? (ops.size() - first) : IO_BATCH_ENTRIES };
+				if (submit_uring(first, count) < 0)
+					return -1;
+			}
+			return 0;
+		}
+
+		for (Op& op : ops) {
+			ssize_t done;
+			do {
+				done = op.write ? ::write(op.fd, op.buf, op.len)
+						: ::read(op.fd, op.buf, op.len);
+				calls++;
+			} while ((done < 0) && (errno == EINTR));
+			op.result = (done < 0) ? -errno : done;
+		}
+		return 0;
+	}
+
+#if defined(EV3UARTGENERATOR_IO_URING)
+	int IoBatch::setup() {
+		struct io_uring_params params { };
+		// Every operation takes two entries: itself, and its timeout
+		ring_fd = static_cast<int>(syscall(__NR_io_uring_setup,
+				2 * IO_BATCH_ENTRIES, &params));
+		if (ring_fd < 0)
+			return -1;
+		// Linux 5.4 and later map both rings at once
+		if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+			return -1;
+
+		// Reads and writes at the current file position need Linux 5.6
+		const size_t probe_size { sizeof(struct io_uring_probe)
+				+ (IORING_OP_LAST * sizeof(struct io_uring_probe_op)) };
+		std::unique_ptr<uint8_t[]> probe_storage { new uint8_t[probe_size]() };
+		struct io_uring_probe* const probe {
+			reinterpret_cast<struct io_uring_probe*>(probe_storage.get()) };
+		if ((syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE,
+				probe, IORING_OP_LAST) < 0)
+				|| (probe->ops_len <= IORING_OP_WRITE)
+				|| !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)
+				|| !(probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED)
+				|| !(probe->ops[IORING_OP_LINK_TIMEOUT].flags & IO_URING_OP_SUPPORTED))
+			return -1;
+
+		const size_t sq_size { params.sq_off.array
+				+ (params.sq_entries * sizeof(unsigned)) };
+		const size_t cq_size { params.cq_off.cqes
+				+ (params.cq_entries * sizeof(struct io_uring_cqe)) };
+		rings_size = (sq_size > cq_size) ? sq_size : cq_size;
+		rings = mmap(nullptr, rings_size, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+		if (rings == MAP_FAILED) {
+			rings = nullptr;
+			return -1;
+		}
+		sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+		sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+		if (sqes == MAP_FAILED) {
+			sqes = nullptr;
+			return -1;
+		}
+
+		uint8_t* const base { static_cast<uint8_t*>(rings) };
+		sq_head = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+		sq_tail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+		sq_mask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+		sq_array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+		cq_head = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+		cq_tail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+		cq_mask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+		cqes = base + params.cq_off.cqes;
+		return 0;
+	}
+
+	int IoBatch::submit_uring(size_t first, size_t count) {
+		generation++;
+		struct io_uring_sqe* const entries {
+			static_cast<struct io_uring_sqe*>(sqes) };
+		const unsigned start { *sq_tail };
+		unsigned tail { start };
+		for (size_t i = first; i < (first + count); i++) {
+			ops[i].done = false;
+			unsigned index { tail++ & sq_mask };
+			struct io_uring_sqe* sqe { &entries[index] };
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = ops[i].write ? IORING_OP_WRITE : IORING_OP_READ;
+			sqe->flags = IOSQE_IO_LINK;
+			sqe->fd = ops[i].fd;
+			sqe->addr = reinterpret_cast<uintptr_t>(ops[i].buf);
+			sqe->len = (ops[i].len < UINT_MAX)
+					? static_cast<unsigned>(ops[i].len) : UINT_MAX;
+			sqe->off = static_cast<uint64_t>(-1); // Current position, for ttys
+			sqe->user_data = tag(generation, static_cast<uint32_t>(i));
+			sq_array[index] = index;
+
+			index = tail++ & sq_mask;
+			sqe = &entries[index];
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = IORING_OP_LINK_TIMEOUT;
+			sqe->fd = -1;
+			sqe->addr = reinterpret_cast<uintptr_t>(&BLOCKED);
+			sqe->len = 1;
+			sqe->user_data = tag(generation, LINK_TIMEOUT);
+			sq_array[index] = index;
+		}
+		__atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+		unsigned to_submit { tail - start };
+		size_t completed { 0 };
+		bool congested { false };
+		while (completed < count) {
+			// Operations are in flight once both of their entries are taken
+			const size_t in_flight { (((tail - start) - to_submit) / 2)
+					- completed };
+			unsigned submitting { to_submit };
+			unsigned wait_for { static_cast<unsigned>(count - completed) };
+			if (congested && (in_flight == 0)) {
+				nanosleep(&CONGESTED, nullptr);
+			} else if (congested) {
+				// Wait for completions to free resources, before submitting
+				// more
+				submitting = 0;
+				wait_for = 1;
+			}
+
+			const long entered { enter(submitting, wait_for) };
+			const int error { (entered < 0) ? errno : 0 };
+			if (entered > 0)
+				to_submit -= static_cast<unsigned>(entered);
+			completed += reap(first, count);
+			congested = (error == EAGAIN) || (error == EBUSY);
+			if ((error != 0) && (error != EINTR) && !congested) {
+				cancel(first, count,
+						__atomic_load_n(sq_head, __ATOMIC_ACQUIRE) - start);
+				teardown();
+				errno = error;
+				return -1;
+			}
+		}
+		return 0;
+	}
+
+	long IoBatch::enter(unsigned to_submit, unsigned min_complete) {
+		calls++;
+		return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+				IORING_ENTER_GETEVENTS, nullptr, 0);
+	}
+
+	size_t IoBatch::reap(size_t first, size_t count) {
+		const struct io_uring_cqe* const completions {
+			static_cast<const struct io_uring_cqe*>(cqes) };
+		size_t completed { 0 };
+		unsigned head { *cq_head };
+		const unsigned ready { __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) };
+		for (; head != ready; head++) {
+			const struct io_uring_cqe& cqe { completions[head & cq_mask] };
+			// Timeouts, cancellations, and the trailing completions of
+			// earlier submissions
+			const uint32_t index { static_cast<uint32_t>(cqe.user_data) };
+			if (((cqe.user_data >> 32) != generation) || (index < first)
+					|| (index >= (first + count)) || ops[index].done)
+				continue;
+			// Cancelled by its timeout: the operation would have blocked
+			ops[index].result = ((cqe.res == -ECANCELED)
+					|| (cqe.res == -EINTR)) ? -EAGAIN : cqe.res;
+			ops[index].done = true;
+			completed++;
+		}
+		__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+		return completed;
+	}
+
+	void IoBatch::cancel(size_t first, size_t count, unsigned consumed) {
+		// Entries the kernel has not taken are withdrawn. Without a thread
+		// polling the submission ring, only io_uring_enter() takes entries.
+		__atomic_store_n(sq_tail, __atomic_load_n(sq_head, __ATOMIC_ACQUIRE),
+				__ATOMIC_RELEASE);
+
+		struct io_uring_sqe* const entries {
+			static_cast<struct io_uring_sqe*>(sqes) };
+		unsigned tail { *sq_tail };
+		size_t outstanding { 0 };
+		for (size_t i = first; i < (first + count); i++) {
+			// Operations whose entry was taken, even without its timeout
+			if (((2 * (i - first)) >= consumed) || ops[i].done)
+				continue;
+			const unsigned index { tail++ & sq_mask };
+			struct io_uring_sqe& sqe { entries[index] };
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_ASYNC_CANCEL;
+			sqe.fd = -1;
+			sqe.addr = tag(generation, static_cast<uint32_t>(i));
+			sqe.user_data = tag(generation, CANCEL);
+			sq_array[index] = index;
+			outstanding++;
+		}
+		__atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+		unsigned to_submit { static_cast<unsigned>(outstanding) };
+		while (outstanding > 0) {
+			const long entered { enter(to_submit, 1) };
+			if (entered > 0)
+				to_submit -= static_cast<unsigned>(entered);
+			outstanding -= reap(first, count);
+			if ((entered < 0) && (errno != EINTR)) {
+				if ((errno == EAGAIN) || (errno == EBUSY)) {
+					nanosleep(&CONGESTED, nullptr);
+					continue;
+				}
+				return; // Closing the io_uring cancels whatever is left
+			}
+		}
+	}
+
+	void IoBatch::teardown() {
+		if (sqes != nullptr)
+			munmap(sqes, sqes_size);
+		if (rings != nullptr)
+			munmap(rings, rings_size);
+		if (ring_fd >= 0)
+			::close(ring_fd);
+		sqes = nullptr;
+		rings = nullptr;
+		ring_fd = -1;
+	}
+#else
+	int IoBatch::setup() {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	int IoBatch::submit_uring(size_t, size_t) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	long IoBatch::enter(unsigned, unsigned) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	size_t IoBatch::reap(size_t, size_t) {
+		return 0;
+	}
+
+	void IoBatch::cancel(size_t, size_t, unsigned) {
+	}
+
+	void IoBatch::teardown() {
+	}
+#endif
+}
+}
@@ -0,0 +1,204 @@
+/**
+ * \file io_batch.hpp
+ *
+ * Batches of reads and writes on many file descriptors, performed with a
+ * single \c io_uring submission where available.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page IoBatch
+ *
+ * A \ref SensorFarm with hundreds of ports reads the commands of every EV3
+ * that sent something, and writes a framed message to every port whose
+ * deadline expired, on each iteration of its loop. With one \c read() or
+ * \c write() per port, that is one system call per sensor and per tick.
+ * \ref EV3UartGenerator::Linux::IoBatch queues those reads and writes, and
+ * performs all of them at once:
+ *
+ * Backend | Availability | System calls per batch
+ * ------- | ------------ | ----------------------
+ * \ref EV3UartGenerator::Linux::IoBackend::URING "URING" | Linux 5.6 and later, unless \c io_uring is disabled (\c kernel.io_uring_disabled, seccomp filters) | One \c io_uring_enter() per IO_BATCH_ENTRIES operations
+ * \ref EV3UartGenerator::Linux::IoBackend::SYSCALLS "SYSCALLS" | Always | One \c read() or \c write() per operation
+ *
+ * The \c io_uring backend is set up with raw system calls, so no library
+ * besides the C library is needed. When it can not be set up, or does not
+ * support reads and writes, the batch falls back to plain system calls: the
+ * results are the same, only the number of system calls differs. The
+ * fallback is always used when compiling without \c <linux/io_uring.h>, or
+ * with \c EV3UARTGENERATOR_NO_IO_URING defined.
+ *
+ * Operations of a batch run concurrently, and in no particular order: a
+ * batch should hold at most one read and one write per file descriptor.
+ * Descriptors are expected to be non-blocking, like the ttys of a farm -
+ * an operation which would block fails with \c EAGAIN instead. (The
+ * \c io_uring would wait for ttys to become ready, regardless of
+ * \c O_NONBLOCK: every operation is linked to a timeout of 1 ms, which
+ * cancels it if it can not complete.)
+ *
+ * \code
+ * Linux::IoBatch batch;
+ * for (Port& port : ready)
+ *     batch.read(port.fd, port.in, sizeof(port.in));
+ * if (batch.submit() == 0) {
+ *     for (size_t i = 0; i < batch.size(); i++)
+ *         ... // batch.result(i): bytes read, or -errno
+ * }
+ * \endcode
+ *
+ * The batch is declared in the file \ref linux/io_batch.hpp
+ */
+
+#ifndef LINUX_IO_BATCH_HPP_
+#define LINUX_IO_BATCH_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <vector>
+
+#if !defined(EV3UARTGENERATOR_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define EV3UARTGENERATOR_IO_URING
+#endif
+#endif
+
+namespace EV3UartGenerator {
+namespace Linux {
+	constexpr unsigned IO_BATCH_ENTRIES { 0x100 }; ///< Number of operations submitted per \c io_uring_enter()
+
+	/**
+	 * Way the operations of an IoBatch are performed.
+	 */
+	enum class IoBackend : uint8_t {
+		SYSCALLS, ///< One \c read() or \c write() per operation
+		URING, ///< Operations submitted together to an \c io_uring
+	};
+
+	/**
+	 * Batch of reads and writes, performed together by submit().
+	 */
+	class IoBatch {
+	public:
+		/**
+		 * Sets up the backend, falling back to IoBackend::SYSCALLS if
+		 * \c io_uring is unavailable.
+		 *
+		 * @param preferred backend to use, if available
+		 */
+		explicit IoBatch(IoBackend preferred = IoBackend::URING);
+		~IoBatch();
+		IoBatch(const IoBatch&) = delete;
+		IoBatch& operator=(const IoBatch&) = delete;
+
+		/**
+		 * @return backend in use
+		 */
+		IoBackend backend() const {
+			return ring_fd >= 0 ? IoBackend::URING : IoBackend::SYSCALLS;
+		}
+
+		/**
+		 * Queues a read. Queueing after submit() starts a new batch.
+		 *
+		 * @param fd file descriptor
+		 * @param buf destination, which must remain valid until submit()
+		 * returns
+		 * @param len size of the destination
+		 */
+		void read(int fd, uint8_t* buf, size_t len) {
+			queue(fd, buf, len, false);
+		}
+
+		/**
+		 * Queues a write. Queueing after submit() starts a new batch.
+		 *
+		 * @param fd file descriptor
+		 * @param buf bytes to write, which must remain valid until submit()
+		 * returns
+		 * @param len number of bytes to write
+		 */
+		void write(int fd, const uint8_t* buf, size_t len) {
+			queue(fd, const_cast<uint8_t*>(buf), len, true);
+		}
+
+		/**
+		 * @return number of operations in the batch
+		 */
+		size_t size() const {
+			return ops.size();
+		}
+
+		/**
+		 * Performs all queued operations.
+		 *
+		 * @retval 0 on success - the result of every operation is available
+		 * from result(), until the next operation is queued
+		 * @retval -1 on error of the \c io_uring itself (results are not
+		 * available). Operations already submitted are cancelled, and
+		 * waited for where the \c io_uring still allows it, so that their
+		 * buffers may be reused. The \c io_uring is then closed, and the
+		 * batch uses IoBackend::SYSCALLS from then on.
+		 */
+		int submit();
+
+		/**
+		 * @param index index of the operation, in the order queued
+		 * @return result of the operation: number of bytes transferred,
+		 * which may be short, or \c -errno on error
+		 */
+		ssize_t result(size_t index) const {
+			return ops[index].result;
+		}
+
+		/**
+		 * @return number of system calls made by submit() so far
+		 */
+		uint64_t syscalls() const {
+			return calls;
+		}
+
+	private:
+		struct Op {
+			int fd;
+			bool write;
+			uint8_t* buf;
+			size_t len;
+			ssize_t result;
+			bool done; ///< Whether the result is in
+		};
+
+		void queue(int fd, uint8_t* buf, size_t len, bool write);
+		int setup();
+		void teardown();
+		int submit_uring(size_t first, size_t count);
+		long enter(unsigned to_submit, unsigned min_complete);
+		size_t reap(size_t first, size_t count);
+		void cancel(size_t first, size_t count, unsigned consumed);
+
+		std::vector<Op> ops;
+		bool submitted;
+		uint64_t calls;
+
+		int ring_fd;
+		uint32_t generation; ///< Number of submissions, tagging their entries
+		void* rings; ///< Submission and completion rings, mapped together
+		size_t rings_size;
+		void* sqes;
+		size_t sqes_size;
+		unsigned* sq_head;
+		unsigned* sq_tail;
+		unsigned sq_mask;
+		unsigned* sq_array;
+		unsigned* cq_head;
+		unsigned* cq_tail;
+		unsigned cq_mask;
+		void* cqes;
+	};
+}
+}
+
+#endif /* LINUX_IO_BATCH_HPP_ */
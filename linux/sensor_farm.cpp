@@ -0,0 +1,422 @@
+/**
+ * \file sensor_farm.cpp
+ *
+ * Function definitions for functions in \ref linux/sensor_farm.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/sensor_farm.hpp>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	namespace {
+		uint32_t now_ms() {
+			struct timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			return static_cast<uint32_t>((static_cast<uint64_t>(ts.tv_sec)
+					* 1000) + (ts.tv_nsec / 1000000));
+		}
+
+		/**
+		 * Compares timestamps, allowing for wraparound of the clock.
+		 */
+		inline bool before(uint32_t time, uint32_t other) {
+			return (static_cast<int32_t>(time - other) < 0);
+		}
+	}
+
+	/**
+	 * A tty, and the sensor emulated on it.
+	 */
+	struct SensorFarm::Port final : public StateMachine::SensorIo,
+			public Timer {
+		Port(SensorFarm& farm, size_t index,
+				const Descriptor::SensorDescriptor& sensor)
+			: farm(farm), index { index },
+			  length { Descriptor::frame_handshake(handshake, sizeof(handshake),
+					sensor) },
+			  machine { *this, sensor, handshake,
+					static_cast<size_t>((length > 0) ? length : 0),
+					farm.timing },
+			  stats { }, output_len { 0 }, switch_at { 0 }, pending_baud { 0 },
+			  transmitted { 0 }, open { false }, failed { false },
+			  dirty { false }, writable { false } {
+		}
+
+		void write(const uint8_t* buf, size_t len) override {
+			if (buf == handshake)
+				stats.handshakes++;
+			queue(buf, len);
+			if (!farm.batch)
+				send();
+		}
+
+		/**
+		 * Queues a message behind the bytes not written yet, or drops it
+		 * whole if it does not fit.
+		 */
+		void queue(const uint8_t* buf, size_t len) {
+			if (len > (sizeof(output) - output_len)) {
+				stats.bytes_dropped += len;
+				return;
+			}
+			memcpy(output + output_len, buf, len);
+			output_len += len;
+			mark_dirty();
+		}
+
+		void mark_dirty() {
+			if (!dirty) {
+				dirty = true;
+				farm.dirty.push_back(this);
+			}
+		}
+
+		/**
+		 * @return number of queued bytes which may be written now - those
+		 * queued before a pending baudrate switch, if any
+		 */
+		size_t sendable() const {
+			return (pending_baud != 0) ? switch_at : output_len;
+		}
+
+		/**
+		 * Writes the queued bytes right away.
+		 */
+		void send() {
+			if (sendable() == 0)
+				return;
+			ssize_t written;
+			do {
+				written = ::write(transport.fd(), output, sendable());
+			} while ((written < 0) && (errno == EINTR));
+			sent((written < 0) ? -errno : written);
+		}
+
+		/**
+		 * Bytes queued before the switch go out at the old baudrate. The
+		 * switch is only requested here, and applied by switch_baud() from
+		 * the loop, once they have been transmitted: messages queued in the
+		 * meantime wait behind it.
+		 */
+		void set_baud(uint32_t baud) override {
+			if (pending_baud != 0) {
+				// Never sent at the baudrate replaced
+				stats.bytes_dropped += output_len - switch_at;
+				output_len = switch_at;
+			} else {
+				switch_at = output_len;
+			}
+			pending_baud = baud;
+			switch_baud();
+		}
+
+		/**
+		 * Makes progress on a pending baudrate switch, without blocking:
+		 * writes the bytes queued before it while the tty has room
+		 * (\c EPOLLOUT), waits on the timer wheel while the tty transmits
+		 * them (\c TIOCOUTQ), and switches once they are out.
+		 */
+		void switch_baud() {
+			if ((pending_baud == 0) || failed)
+				return;
+			send();
+			watch(switch_at > 0);
+			if (failed || (switch_at > 0))
+				return;
+
+			int queued;
+			if (ioctl(transport.fd(), TIOCOUTQ, &queued) < 0) {
+				failed = true;
+				return;
+			}
+			if (queued > 0) {
+				// 10 bits per byte (8N1), rounded up
+				transmitted = now_ms() + 1 + static_cast<uint32_t>(
+						(static_cast<uint64_t>(queued) * 10000)
+						/ transport.baud());
+				return;
+			}
+			if (transport.set_baud(pending_baud) < 0)
+				failed = true;
+			pending_baud = 0;
+			if (output_len > 0)
+				mark_dirty();
+		}
+
+		/**
+		 * Adds or removes \c EPOLLOUT from the events of the port.
+		 */
+		void watch(bool out) {
+			if (out == writable)
+				return;
+			struct epoll_event event { };
+			event.events = EPOLLIN;
+			if (out)
+				event.events |= EPOLLOUT;
+			event.data.ptr = this;
+			if (epoll_ctl(farm.epoll, EPOLL_CTL_MOD, transport.fd(), &event) < 0)
+				failed = true;
+			else
+				writable = out;
+		}
+
+		uint8_t sample(uint8_t mode, uint8_t* payload) override {
+			return farm.sampler.sample(index, mode, payload);
+		}
+
+		/**
+		 * Accounts for the result of a read, or a batched read.
+		 *
+		 * @param got number of bytes read into \c input, or -errno
+		 */
+		void received(ssize_t got, uint32_t now) {
+			if (got > 0) {
+				stats.bytes_received += got;
+				machine.receive(input, got, now);
+			} else if ((got < 0) && (got != -EAGAIN) && (got != -EINTR)) {
+				failed = true;
+			}
+		}
+
+		/**
+		 * Accounts for the result of a write, or a batched write, of
+		 * \c output. Bytes not written stay queued for the next one, so
+		 * that no message goes out truncated.
+		 *
+		 * @param written number of bytes written, or -errno
+		 */
+		void sent(ssize_t written) {
+			if ((written < 0) && (written != -EAGAIN))
+				failed = true;
+			if (written <= 0)
+				return;
+			stats.bytes_sent += written;
+			output_len -= written;
+			if (pending_baud != 0)
+				switch_at -= written;
+			memmove(output, output + written, output_len);
+		}
+
+		void expire(uint32_t now) override {
+			if (!failed) {
+				switch_baud();
+				machine.poll(now);
+			}
+			farm.update(*this);
+		}
+
+		SensorFarm& farm;
+		const size_t index;
+		uint8_t handshake[Descriptor::HANDSHAKE_MAX];
+		const int16_t length;
+		StateMachine::SensorStateMachine machine;
+		Transport transport;
+		PortStats stats;
+		uint8_t input[0x100];
+		uint8_t output[FARM_OUTPUT_MAX]; ///< Messages not written yet
+		size_t output_len;
+		size_t switch_at; ///< Number of queued bytes to write before pending_baud applies
+		uint32_t pending_baud; ///< Baudrate to switch to, or 0
+		uint32_t transmitted; ///< Time the bytes written before pending_baud should be out
+		bool open;
+		bool failed;
+		bool dirty; ///< Whether the port is in the list of ports with queued bytes
+		bool writable; ///< Whether \c EPOLLOUT is watched
+	};
+
+	SensorFarm::SensorFarm(Sampler& sampler, const StateMachine::Timing& timing)
+		: sampler(sampler), timing(timing),
+		  epoll { epoll_create1(EPOLL_CLOEXEC) }, wheel { now_ms() } {
+		struct epoll_event event { };
+		event.events = EPOLLIN;
+		event.data.ptr = nullptr; // Events of the timerfd carry no port
+		if ((epoll >= 0) && ((wheel.open() < 0)
+				|| (epoll_ctl(epoll, EPOLL_CTL_ADD, wheel.fd(), &event) < 0))) {
+			::close(epoll);
+			epoll = -1;
+		}
+	}
+
+	SensorFarm::~SensorFarm() {
+		for (std::unique_ptr<Port>& port : ports) {
+			if (port->open)
+				close_port(*port);
+		}
+		if (epoll >= 0)
+			::close(epoll);
+	}
+
+	int SensorFarm::add(const char* path,
+			const Descriptor::SensorDescriptor& sensor) {
+		const int fd { ::open(path, O_RDWR | O_NOCTTY | O_CLOEXEC) };
+		if (fd < 0)
+			return -1;
+		return adopt(fd, sensor);
+	}
+
+	int SensorFarm::adopt(int fd, const Descriptor::SensorDescriptor& sensor) {
+		std::unique_ptr<Port> port { new Port(*this, ports.size(), sensor) };
+		if ((epoll < 0) || (port->length < 0)) {
+			::close(fd);
+			errno = EINVAL;
+			return -1;
+		}
+		if (port->transport.adopt(fd) < 0)
+			return -1;
+
+		const int flags { fcntl(fd, F_GETFL) };
+		struct epoll_event event { };
+		event.events = EPOLLIN;
+		event.data.ptr = port.get();
+		if ((flags < 0) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+				|| (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0))
+			return -1; // Transport closes the descriptor
+
+		const uint32_t now { now_ms() };
+		port->open = true;
+		port->machine.begin(now);
+		update(*port);
+		if ((flush() < 0) || (wheel.arm(now) < 0)) {
+			close_port(*port);
+			return -1;
+		}
+		ports.push_back(std::move(port));
+		return static_cast<int>(ports.size() - 1);
+	}
+
+	int SensorFarm::run_once(int timeout_ms) {
+		struct epoll_event events[FARM_EVENTS_MAX];
+		const int count { epoll_wait(epoll, events, FARM_EVENTS_MAX,
+				timeout_ms) };
+		if (count < 0)
+			return (errno == EINTR) ? 0 : -1;
+
+		const uint32_t now { now_ms() };
+		for (int i = 0; i < count; i++) {
+			if (events[i].data.ptr == nullptr)
+				continue; // timerfd, cleared when re-armed below
+			Port& port { *static_cast<Port*>(events[i].data.ptr) };
+			if (events[i].events & (EPOLLHUP | EPOLLERR))
+				port.failed = true;
+			if (events[i].events & EPOLLOUT)
+				port.switch_baud();
+			if ((events[i].events & EPOLLIN) && batch) {
+				batch->read(port.transport.fd(), port.input, sizeof(port.input));
+				batched.push_back(&port);
+				continue; // Updated once the read completes
+			}
+			if (events[i].events & EPOLLIN) {
+				ssize_t got;
+				do {
+					got = ::read(port.transport.fd(), port.input,
+							sizeof(port.input));
+					port.received((got < 0) ? -errno : got, now);
+				} while (got > 0);
+			}
+			// Received messages move deadlines (SYS NACK, SYS ACK)
+			update(port);
+		}
+
+		if (!batched.empty()) {
+			const int submitted { batch->submit() };
+			for (size_t i = 0; i < batched.size(); i++) {
+				batched[i]->received((submitted < 0) ? -EIO : batch->result(i),
+						now);
+				update(*batched[i]);
+			}
+			batched.clear();
+			if (submitted < 0)
+				return -1;
+		}
+
+		wheel.advance(now);
+		if (flush() < 0)
+			return -1;
+		return wheel.arm(now);
+	}
+
+	IoBackend SensorFarm::batch_io(IoBackend preferred) {
+		flush();
+		batch.reset(new IoBatch(preferred));
+		return batch->backend();
+	}
+
+	size_t SensorFarm::active() const {
+		size_t open { 0 };
+		for (const std::unique_ptr<Port>& port : ports)
+			open += port->open;
+		return open;
+	}
+
+	const StateMachine::SensorStateMachine& SensorFarm::machine(
+			size_t port) const {
+		return ports[port]->machine;
+	}
+
+	const PortStats& SensorFarm::stats(size_t port) const {
+		return ports[port]->stats;
+	}
+
+	void SensorFarm::update(Port& port) {
+		if (port.failed) {
+			close_port(port);
+			return;
+		}
+		uint32_t deadline { port.machine.next_deadline() };
+		if ((port.pending_baud != 0) && (port.switch_at == 0)
+				&& before(port.transmitted, deadline))
+			deadline = port.transmitted; // Time to check the switch again
+		wheel.schedule(port, deadline);
+	}
+
+	int SensorFarm::flush() {
+		for (Port* port : dirty) {
+			port->dirty = false;
+			if ((port->output_len == 0) || (port->pending_baud != 0))
+				continue; // Written right away, closed, or up to switch_baud()
+			if (batch)
+				batch->write(port->transport.fd(), port->output, port->output_len);
+			batched.push_back(port);
+		}
+		dirty.clear();
+		if (batched.empty())
+			return 0;
+
+		const int submitted { batch ? batch->submit() : 0 };
+		for (size_t i = 0; i < batched.size(); i++) {
+			Port& port { *batched[i] };
+			if (batch)
+				port.sent((submitted < 0) ? -EIO : batch->result(i));
+			else
+				port.send();
+			if (port.failed)
+				close_port(port);
+			else if (port.sendable() > 0)
+				port.mark_dirty(); // The rest goes out with the next flush
+		}
+		batched.clear();
+		return submitted;
+	}
+
+	void SensorFarm::close_port(Port& port) {
+		port.output_len = 0;
+		port.pending_baud = 0;
+		port.writable = false;
+		wheel.cancel(port);
+		epoll_ctl(epoll, EPOLL_CTL_DEL, port.transport.fd(), nullptr);
+		port.transport.close();
+		port.open = false;
+	}
+}
+}
@@ -0,0 +1,198 @@
+/**
+ * \file sensor_farm.hpp
+ *
+ * Emulation of many sensors at once, each on its own tty, from a single
+ * \c epoll loop.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page SensorFarm
+ *
+ * \ref EV3UartGenerator::Linux::SensorFarm drives any number of emulated
+ * sensors, one per tty, from a single thread:
+ * - every port runs its own
+ *   \ref EV3UartGenerator::StateMachine::SensorStateMachine, with the
+ *   handshake framed once, when the port is added
+ * - bytes from the EV3s are dispatched through one \c epoll instance
+ * - the next deadline of every port (handshake retry, next \c DATA
+ *   message, keepalive timeout) is kept in a \ref TimerWheel, and
+ *   \c epoll_wait() sleeps until input arrives, or until the \c timerfd of
+ *   the wheel fires. An iteration of the loop only touches the ports that
+ *   received bytes or reached a deadline, however many ports there are
+ * - ttys are non-blocking: a port whose EV3 stops reading loses messages,
+ *   instead of stalling every other port. Bytes a short write leaves behind
+ *   stay queued, up to FARM_OUTPUT_MAX bytes per port, and go out on the
+ *   next iteration of the loop: a message which does not fit is dropped
+ *   whole, so that none goes out truncated
+ * - the loop never waits for a tty either when the baudrate changes: the
+ *   bytes queued before the switch are written as the tty has room for
+ *   them (\c EPOLLOUT), and the switch is made once the tty has
+ *   transmitted them (\c TIOCOUTQ). Messages queued in the meantime wait
+ *   behind it - or are dropped, if another switch replaces it
+ * - optionally, with batch_io(), the reads of all ports with input, and
+ *   the writes of all ports with messages to send, are performed as one
+ *   \ref IoBatch each per iteration of the loop, instead of one system call
+ *   per port. Messages are then queued until the end of the iteration
+ *
+ * Samples for \c DATA messages are obtained from a
+ * \ref EV3UartGenerator::Linux::Sampler implemented by the user.
+ *
+ * Pseudo-terminals can stand in for ttys: add the slave side of a pty to the
+ * farm, and talk to the sensor from the master side.
+ *
+ * The farm is declared in the file \ref linux/sensor_farm.hpp
+ */
+
+#ifndef LINUX_SENSOR_FARM_HPP_
+#define LINUX_SENSOR_FARM_HPP_
+
+#include <linux/io_batch.hpp>
+#include <linux/timer_wheel.hpp>
+#include <linux/transport.hpp>
+#include <sensor_state_machine.hpp>
+#include <memory>
+#include <vector>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	constexpr int FARM_EVENTS_MAX { 0x40 }; ///< Maximum number of events processed per \c epoll_wait()
+	constexpr size_t FARM_OUTPUT_MAX { Descriptor::HANDSHAKE_MAX + (4 * Framing::BUFFER_MIN) }; ///< Bytes queued per port - a handshake, and a few messages
+
+	/**
+	 * Source of samples for the ports of a farm, implemented by the user.
+	 */
+	class Sampler {
+	public:
+		/**
+		 * Obtains the payload of the next \c DATA message of a port.
+		 *
+		 * @param port port index, as returned by SensorFarm::add()
+		 * @param mode mode index of the currently selected mode
+		 * @param payload destination, with space for
+		 * PAYLOAD_SENSOR_TO_EV3_MAX bytes
+		 * @return length of the payload, or 0 to skip this \c DATA message
+		 */
+		virtual uint8_t sample(size_t port, uint8_t mode, uint8_t* payload) = 0;
+
+	protected:
+		~Sampler() = default;
+	};
+
+	/**
+	 * Counters kept for every port of a farm.
+	 */
+	struct PortStats {
+		uint64_t bytes_received; ///< Bytes received from the EV3
+		uint64_t bytes_sent; ///< Bytes written to the EV3
+		uint64_t bytes_dropped; ///< Bytes not written, because the tty was full
+		uint32_t handshakes; ///< Number of times the handshake was sent
+	};
+
+	/**
+	 * Many emulated sensors, driven from a single \c epoll loop.
+	 */
+	class SensorFarm {
+	public:
+		/**
+		 * @param sampler source of samples for all ports
+		 * @param timing timing parameters used by all ports
+		 */
+		explicit SensorFarm(Sampler& sampler,
+				const StateMachine::Timing& timing = StateMachine::DEFAULT_TIMING);
+		~SensorFarm();
+		SensorFarm(const SensorFarm&) = delete;
+		SensorFarm& operator=(const SensorFarm&) = delete;
+
+		/**
+		 * Opens a tty, and starts emulating a sensor on it.
+		 *
+		 * @param path path to the tty device
+		 * @param sensor sensor description, which must outlive the farm
+		 * @return port index, if positive
+		 * @retval -1 on error
+		 */
+		int add(const char* path, const Descriptor::SensorDescriptor& sensor);
+
+		/**
+		 * Takes ownership of an open tty file descriptor, and starts emulating
+		 * a sensor on it.
+		 *
+		 * @param fd tty file descriptor, closed by the farm
+		 * @param sensor sensor description, which must outlive the farm
+		 * @return port index, if positive
+		 * @retval -1 on error (the descriptor is closed)
+		 */
+		int adopt(int fd, const Descriptor::SensorDescriptor& sensor);
+
+		/**
+		 * Runs one iteration of the event loop: waits for input or for the
+		 * earliest deadline (but no longer than \c timeout_ms), then processes
+		 * received bytes, and the deadlines due, of the ports concerned.
+		 *
+		 * Ports whose tty hangs up or fails are closed, and take no further
+		 * part in the loop.
+		 *
+		 * @param timeout_ms maximum time to wait, or -1 to wait for the next
+		 * deadline
+		 * @retval 0 on success
+		 * @retval -1 on error
+		 */
+		int run_once(int timeout_ms);
+
+		/**
+		 * Batches the reads and writes of all ports from now on.
+		 *
+		 * @param preferred backend to use, if available
+		 * @return backend in use - IoBackend::SYSCALLS if \c io_uring is
+		 * unavailable
+		 */
+		IoBackend batch_io(IoBackend preferred = IoBackend::URING);
+
+		/**
+		 * @return number of ports, including closed ones
+		 */
+		size_t size() const {
+			return ports.size();
+		}
+
+		/**
+		 * @return number of ports which are still open
+		 */
+		size_t active() const;
+
+		/**
+		 * @param port port index
+		 * @return state machine of the port
+		 */
+		const StateMachine::SensorStateMachine& machine(size_t port) const;
+
+		/**
+		 * @param port port index
+		 * @return counters of the port
+		 */
+		const PortStats& stats(size_t port) const;
+
+	private:
+		struct Port;
+
+		void update(Port& port);
+		int flush();
+		void close_port(Port& port);
+
+		Sampler& sampler;
+		const StateMachine::Timing timing;
+		int epoll;
+		TimerWheel wheel;
+		std::vector<std::unique_ptr<Port>> ports;
+		std::unique_ptr<IoBatch> batch; ///< Set when I/O is batched
+		std::vector<Port*> dirty; ///< Ports with queued bytes
+		std::vector<Port*> batched; ///< Ports with an operation in the batch, in order
+	};
+}
+}
+
+#endif /* LINUX_SENSOR_FARM_HPP_ */
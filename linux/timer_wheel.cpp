@@ -0,0 +1,213 @@
+/**
+ * \file timer_wheel.cpp
+ *
+ * Function definitions for functions in \ref linux/timer_wheel.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/timer_wheel.hpp>
+#include <errno.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	namespace {
+		constexpr uint32_t SLOT_MASK { TIMER_SLOTS - 1 };
+
+		static_assert(TIMER_SLOTS == 64, "Slots of a level are tracked in a 64-bit bitmap");
+
+		/**
+		 * @return number of ticks covered by a slot of a level
+		 */
+		constexpr uint32_t slot_ticks(uint8_t level) {
+			return 1UL << (TIMER_LEVEL_BITS * level);
+		}
+
+		/**
+		 * Rotates a bitmap of slots, so that bit 0 is slot \c start.
+		 */
+		uint64_t rotate(uint64_t bitmap, uint8_t start) {
+			return (start == 0) ? bitmap
+					: ((bitmap >> start) | (bitmap << (TIMER_SLOTS - start)));
+		}
+	}
+
+	constexpr uint16_t Timer::NONE;
+	constexpr uint16_t TimerWheel::EXPIRING;
+
+	Timer::Timer()
+		: next { nullptr }, prev { nullptr }, when { 0 }, slot { NONE } {
+	}
+
+	TimerWheel::TimerWheel(uint32_t now)
+		: slots { }, occupied { }, current { now }, pending { 0 },
+		  timer_fd { -1 } {
+	}
+
+	TimerWheel::~TimerWheel() {
+		if (timer_fd >= 0)
+			::close(timer_fd);
+	}
+
+	void TimerWheel::schedule(Timer& timer, uint32_t deadline) {
+		if (timer.pending())
+			unlink(timer);
+		timer.when = deadline;
+		insert(timer);
+	}
+
+	void TimerWheel::cancel(Timer& timer) {
+		if (timer.pending())
+			unlink(timer);
+	}
+
+	void TimerWheel::insert(Timer& timer) {
+		int32_t delta { static_cast<int32_t>(timer.when - current) };
+		uint32_t target { timer.when };
+		if (delta < 0) {
+			// Past deadlines expire at the next tick processed
+			delta = 0;
+			target = current;
+		} else if (static_cast<uint32_t>(delta) >= TIMER_RANGE) {
+			delta = TIMER_RANGE - 1;
+			target = current + delta;
+		}
+
+		uint8_t level { 0 };
+		while (static_cast<uint32_t>(delta) >= slot_ticks(level + 1))
+			level++;
+		const uint8_t index { static_cast<uint8_t>(
+				(target >> (TIMER_LEVEL_BITS * level)) & SLOT_MASK) };
+		const uint16_t slot { static_cast<uint16_t>(
+				(level * TIMER_SLOTS) + index) };
+
+		timer.prev = nullptr;
+		timer.next = slots[slot];
+		if (timer.next != nullptr)
+			timer.next->prev = &timer;
+		slots[slot] = &timer;
+		timer.slot = slot;
+		occupied[level] |= (1ULL << index);
+		pending++;
+	}
+
+	void TimerWheel::unlink(Timer& timer) {
+		if (timer.prev != nullptr)
+			timer.prev->next = timer.next;
+		else
+			slots[timer.slot] = timer.next;
+		if (timer.next != nullptr)
+			timer.next->prev = timer.prev;
+		if ((timer.slot != EXPIRING) && (slots[timer.slot] == nullptr))
+			occupied[timer.slot / TIMER_SLOTS] &= ~(1ULL
+					<< (timer.slot % TIMER_SLOTS));
+		timer.slot = Timer::NONE;
+		pending--;
+	}
+
+	void TimerWheel::cascade(uint8_t level) {
+		const uint8_t index { static_cast<uint8_t>(
+				(current >> (TIMER_LEVEL_BITS * level)) & SLOT_MASK) };
+		Timer* timer { slots[(level * TIMER_SLOTS) + index] };
+		slots[(level * TIMER_SLOTS) + index] = nullptr;
+		occupied[level] &= ~(1ULL << index);
+		while (timer != nullptr) {
+			Timer* const next { timer->next };
+			pending--;
+			insert(*timer);
+			timer = next;
+		}
+	}
+
+	bool TimerWheel::next_tick(uint32_t& ticks) const {
+		bool found { false };
+		for (uint8_t level = 0; level < TIMER_LEVELS; level++) {
+			if (occupied[level] == 0)
+				continue;
+			// Slots of higher levels are moved down at the start of the
+			// range of ticks they cover, the first of which is in the future
+			const uint8_t shift { static_cast<uint8_t>(TIMER_LEVEL_BITS * level) };
+			uint32_t first { current >> shift };
+			if ((level > 0) && ((current & (slot_ticks(level) - 1)) != 0))
+				first++;
+			const uint32_t offset { static_cast<uint32_t>(__builtin_ctzll(
+					rotate(occupied[level], first & SLOT_MASK))) };
+			const uint32_t distance { ((first + offset) << shift) - current };
+			if (!found || (distance < ticks))
+				ticks = distance;
+			found = true;
+		}
+		return found;
+	}
+
+	size_t TimerWheel::advance(uint32_t now) {
+		size_t expired { 0 };
+		uint32_t ticks;
+		while ((static_cast<int32_t>(now - current) >= 0) && next_tick(ticks)
+				&& (ticks <= (now - current))) {
+			current += ticks;
+
+			// Move timers down, from every level whose range starts here
+			for (uint8_t level = 1; level < TIMER_LEVELS; level++) {
+				if (((current >> (TIMER_LEVEL_BITS * (level - 1))) & SLOT_MASK) != 0)
+					break;
+				cascade(level);
+			}
+
+			const uint8_t index { static_cast<uint8_t>(current & SLOT_MASK) };
+			Timer* timer { slots[index] };
+			slots[index] = nullptr;
+			occupied[0] &= ~(1ULL << index);
+			slots[EXPIRING] = timer;
+			for (; timer != nullptr; timer = timer->next)
+				timer->slot = EXPIRING;
+
+			// Timers scheduled in the past from expire() go to the next tick
+			current++;
+			while (slots[EXPIRING] != nullptr) {
+				Timer& due { *slots[EXPIRING] };
+				unlink(due);
+				due.expire(now);
+				expired++;
+			}
+		}
+		if (static_cast<int32_t>(now - current) >= 0)
+			current = now + 1; // Nothing left to do up to now
+		return expired;
+	}
+
+	int32_t TimerWheel::timeout(uint32_t now) const {
+		uint32_t ticks;
+		if (!next_tick(ticks))
+			return -1;
+		const int32_t remaining { static_cast<int32_t>((current + ticks) - now) };
+		return (remaining > 0) ? remaining : 0;
+	}
+
+	int TimerWheel::open() {
+		if (timer_fd < 0)
+			timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		return (timer_fd < 0) ? -1 : 0;
+	}
+
+	int TimerWheel::arm(uint32_t now) {
+		if (timer_fd < 0) {
+			errno = EBADF;
+			return -1;
+		}
+		struct itimerspec spec { };
+		const int32_t wait { timeout(now) };
+		if (wait == 0) {
+			spec.it_value.tv_nsec = 1; // A zero value disarms the timer
+		} else if (wait > 0) {
+			spec.it_value.tv_sec = wait / 1000;
+			spec.it_value.tv_nsec = (wait % 1000) * 1000000L;
+		}
+		return timerfd_settime(timer_fd, 0, &spec, nullptr);
+	}
+}
+}
@@ -0,0 +1,204 @@
+/**
+ * \file timer_wheel.hpp
+ *
+ * Hierarchical timer wheel, waking an \c epoll loop through a \c timerfd.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page TimerWheel
+ *
+ * Every emulated sensor has a deadline pending at all times - the next
+ * \c DATA message, the next handshake retry, or the end of the keepalive
+ * timeout - which moves every time the sensor sends a message or receives
+ * a \c SYS \c NACK. \ref EV3UartGenerator::Linux::TimerWheel keeps
+ * thousands of such deadlines:
+ * - timers are intrusive (\ref EV3UartGenerator::Linux::Timer), so the wheel
+ *   never allocates memory
+ * - scheduling, rescheduling and cancelling a timer take constant time
+ * - time is counted in ticks of 1 ms. The wheel has TIMER_LEVELS levels of
+ *   TIMER_SLOTS slots each: level 0 holds the timers due within the next
+ *   TIMER_SLOTS ticks, one slot per tick, and every further level covers a
+ *   range TIMER_SLOTS times longer. Timers move down a level each time the
+ *   level below wraps around, and expire from level 0
+ * - every level keeps a bitmap of its non-empty slots, so that advance()
+ *   skips straight to the next tick with anything to do, however long the
+ *   loop slept, and the time of the next wakeup is found by a few bit scans
+ *
+ * The wheel does not read the clock: the current time (in the same
+ * wrapping millisecond units as \ref StateMachine) is passed to every
+ * call. For \c epoll loops, the wheel owns a \c timerfd, armed by arm() for
+ * the next wakeup. The \c timerfd becomes readable when timers are due.
+ *
+ * \code
+ * wheel.schedule(port_timer, now + 10);
+ * wheel.arm(now);
+ * ... // epoll_wait() on wheel.fd() and other descriptors
+ * wheel.advance(now_ms()); // Calls Timer::expire() of due timers
+ * wheel.arm(now_ms());
+ * \endcode
+ *
+ * The wheel is declared in the file \ref linux/timer_wheel.hpp
+ */
+
+#ifndef LINUX_TIMER_WHEEL_HPP_
+#define LINUX_TIMER_WHEEL_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	constexpr uint8_t TIMER_LEVEL_BITS { 6 }; ///< Number of bits of the deadline indexing the slots of a level
+	constexpr uint8_t TIMER_SLOTS { 1 << TIMER_LEVEL_BITS }; ///< Number of slots per level
+	constexpr uint8_t TIMER_LEVELS { 4 }; ///< Number of levels
+	constexpr uint32_t TIMER_RANGE { 1UL << (TIMER_LEVEL_BITS * TIMER_LEVELS) }; ///< Ticks covered by all levels - timers further away are placed at the end, and placed again when they get there
+
+	class TimerWheel;
+
+	/**
+	 * Timer of a TimerWheel, derived from by users of the wheel.
+	 *
+	 * A pending timer must be cancelled before it is destroyed.
+	 */
+	class Timer {
+	public:
+		Timer();
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+		/**
+		 * @return whether the timer is scheduled, and has not expired yet
+		 */
+		bool pending() const {
+			return slot != NONE;
+		}
+
+		/**
+		 * @return time the timer was last scheduled for
+		 */
+		uint32_t deadline() const {
+			return when;
+		}
+
+	protected:
+		~Timer() = default;
+
+		/**
+		 * Called by TimerWheel::advance() when the timer expires. The timer
+		 * is no longer pending, and may be scheduled again.
+		 *
+		 * @param now time passed to TimerWheel::advance()
+		 */
+		virtual void expire(uint32_t now) = 0;
+
+	private:
+		friend class TimerWheel;
+
+		static constexpr uint16_t NONE { 0xffff }; ///< Value of slot for timers which are not pending
+
+		Timer* next;
+		Timer* prev;
+		uint32_t when;
+		uint16_t slot;
+	};
+
+	/**
+	 * Hierarchical timer wheel with 1 ms ticks.
+	 */
+	class TimerWheel {
+	public:
+		/**
+		 * @param now current time
+		 */
+		explicit TimerWheel(uint32_t now);
+		~TimerWheel();
+		TimerWheel(const TimerWheel&) = delete;
+		TimerWheel& operator=(const TimerWheel&) = delete;
+
+		/**
+		 * Schedules a timer, or moves a pending timer to a new deadline.
+		 *
+		 * @param timer timer, which must outlive its time in the wheel
+		 * @param deadline time at which the timer expires. Deadlines in the
+		 * past expire at the next call to advance().
+		 */
+		void schedule(Timer& timer, uint32_t deadline);
+
+		/**
+		 * Cancels a timer, if pending.
+		 */
+		void cancel(Timer& timer);
+
+		/**
+		 * Expires all timers due at or before \c now, in the order of their
+		 * deadlines. Timers may schedule and cancel timers, including
+		 * themselves, from Timer::expire().
+		 *
+		 * @param now current time
+		 * @return number of timers expired
+		 */
+		size_t advance(uint32_t now);
+
+		/**
+		 * @param now current time
+		 * @return time until advance() has work to do - either expiring a
+		 * timer, or moving timers down a level
+		 * @retval -1 if no timer is pending
+		 */
+		int32_t timeout(uint32_t now) const;
+
+		/**
+		 * @return number of pending timers
+		 */
+		size_t size() const {
+			return pending;
+		}
+
+		/**
+		 * Creates the \c timerfd of the wheel, if not open yet.
+		 *
+		 * @retval 0 on success
+		 * @retval -1 on error
+		 */
+		int open();
+
+		/**
+		 * @return file descriptor of the \c timerfd, or -1 if not open
+		 */
+		int fd() const {
+			return timer_fd;
+		}
+
+		/**
+		 * Arms the \c timerfd for the next wakeup, after timeout(), or
+		 * disarms it if no timer is pending. Any expiration of the
+		 * \c timerfd not read yet is cleared.
+		 *
+		 * @param now current time
+		 * @retval 0 on success
+		 * @retval -1 on error
+		 */
+		int arm(uint32_t now);
+
+	private:
+		static constexpr uint16_t EXPIRING { TIMER_LEVELS * TIMER_SLOTS }; ///< Slot of timers being expired
+
+		void insert(Timer& timer);
+		void unlink(Timer& timer);
+		void cascade(uint8_t level);
+		bool next_tick(uint32_t& ticks) const;
+
+		Timer* slots[EXPIRING + 1];
+		uint64_t occupied[TIMER_LEVELS];
+		uint32_t current; ///< Next tick to process
+		size_t pending;
+		int timer_fd;
+	};
+}
+}
+
+#endif /* LINUX_TIMER_WHEEL_HPP_ */
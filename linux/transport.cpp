@@ -0,0 +1,219 @@
+/**
+ * \file transport.cpp
+ *
+ * Function definitions for functions in \ref linux/transport.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/transport.hpp>
+#include <decoding.hpp>
+#include <magics.hpp>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	namespace {
+		struct BaudMapping {
+			uint32_t baud;
+			speed_t speed;
+		};
+
+		constexpr BaudMapping baud_table[] {
+			{ 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 },
+			{ 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 },
+			{ 57600, B57600 }, { 115200, B115200 }, { 230400, B230400 },
+			{ 460800, B460800 }, { 500000, B500000 }, { 576000, B576000 },
+			{ 921600, B921600 }, { 1000000, B1000000 },
+		};
+
+		int64_t now_ms() {
+			struct timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			return (static_cast<int64_t>(ts.tv_sec) * 1000)
+					+ (ts.tv_nsec / 1000000);
+		}
+	}
+
+	Transport::Transport() : tty { -1 }, current_baud { 0 } {
+	}
+
+	Transport::~Transport() {
+		close();
+	}
+
+	int Transport::open(const char* path) {
+		const int fd { ::open(path, O_RDWR | O_NOCTTY | O_CLOEXEC) };
+		if (fd < 0)
+			return -1;
+		return adopt(fd);
+	}
+
+	int Transport::adopt(int fd) {
+		close();
+		tty = fd;
+
+		struct termios tio;
+		if (tcgetattr(tty, &tio) < 0) {
+			close();
+			return -1;
+		}
+		cfmakeraw(&tio);
+		tio.c_cflag |= (CLOCAL | CREAD);
+		tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 0;
+		if (tcsetattr(tty, TCSANOW, &tio) < 0) {
+			close();
+			return -1;
+		}
+		if (set_baud(HANDSHAKE_BAUD) < 0) {
+			close();
+			return -1;
+		}
+		return 0;
+	}
+
+	void Transport::close() {
+		if (tty >= 0)
+			::close(tty);
+		tty = -1;
+		current_baud = 0;
+	}
+
+	int Transport::set_baud(uint32_t baud) {
+		for (const BaudMapping& mapping : baud_table) {
+			if (mapping.baud != baud)
+				continue;
+
+			struct termios tio;
+			if (tcgetattr(tty, &tio) < 0)
+				return -1;
+			cfsetispeed(&tio, mapping.speed);
+			cfsetospeed(&tio, mapping.speed);
+			if (tcsetattr(tty, TCSANOW, &tio) < 0)
+				return -1;
+			current_baud = baud;
+			return 0;
+		}
+		errno = EINVAL;
+		return -1;
+	}
+
+	ssize_t Transport::write(const uint8_t* buf, size_t len) {
+		struct iovec iov { const_cast<uint8_t*>(buf), len };
+		return writev(&iov, 1);
+	}
+
+	ssize_t Transport::writev(const struct iovec* iov, int count,
+			size_t* done) {
+		struct iovec pending[IOV_MAX];
+		size_t ignored;
+		if (done == nullptr)
+			done = &ignored;
+		*done = 0;
+		if ((count < 0) || (count > IOV_MAX)) {
+			errno = EINVAL;
+			return -1;
+		}
+		for (int i = 0; i < count; i++)
+			pending[i] = iov[i];
+
+		struct iovec* next { pending };
+		while (count > 0) {
+			const ssize_t written { ::writev(tty, next, count) };
+			if (written < 0) {
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN) {
+					struct pollfd pfd { tty, POLLOUT, 0 };
+					poll(&pfd, 1, -1);
+					continue;
+				}
+				return -1;
+			}
+			*done += written;
+
+			// Skip fully written buffers, and adjust a partially written one
+			size_t remaining { static_cast<size_t>(written) };
+			while ((count > 0) && (remaining >= next->iov_len)) {
+				remaining -= next->iov_len;
+				next++;
+				count--;
+			}
+			if (count > 0) {
+				next->iov_base = static_cast<uint8_t*>(next->iov_base)
+						+ remaining;
+				next->iov_len -= remaining;
+			}
+		}
+		return static_cast<ssize_t>(*done);
+	}
+
+	ssize_t Transport::read(uint8_t* buf, size_t len, int timeout_ms) {
+		struct pollfd pfd { tty, POLLIN, 0 };
+		int ready;
+		do {
+			ready = poll(&pfd, 1, timeout_ms);
+		} while ((ready < 0) && (errno == EINTR));
+		if (ready <= 0)
+			return ready;
+
+		ssize_t got;
+		do {
+			got = ::read(tty, buf, len);
+		} while ((got < 0) && (errno == EINTR));
+		if ((got < 0) && (errno == EAGAIN))
+			return 0;
+		return got;
+	}
+
+	int Transport::drain() {
+		int ret;
+		do {
+			ret = tcdrain(tty);
+		} while ((ret < 0) && (errno == EINTR));
+		return ret;
+	}
+
+	int Transport::handshake(const struct iovec* iov, int count,
+			uint32_t speed, int timeout_ms) {
+		if ((set_baud(HANDSHAKE_BAUD) < 0) || (writev(iov, count) < 0)
+				|| (drain() < 0))
+			return -1;
+
+		Decoding::FrameDecoder decoder;
+		Decoding::Frame frame;
+		uint8_t buf[0x40];
+		const int64_t deadline { now_ms() + timeout_ms };
+		for (;;) {
+			int wait { -1 }; // Negative timeouts wait forever, as with read()
+			if (timeout_ms >= 0) {
+				const int64_t remaining { deadline - now_ms() };
+				if (remaining <= 0) {
+					errno = ETIMEDOUT;
+					return -1;
+				}
+				wait = static_cast<int>(remaining);
+			}
+
+			const ssize_t got { read(buf, sizeof(buf), wait) };
+			if (got < 0)
+				return -1;
+			decoder.feed(buf, got);
+			while (decoder.next(frame)) {
+				if (frame.is(Magics::SYS::ACK))
+					return set_baud(speed);
+			}
+		}
+	}
+}
+}
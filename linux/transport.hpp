@@ -0,0 +1,174 @@
+/**
+ * \file transport.hpp
+ *
+ * Serial transport for emulated sensors running on Linux, connected to the
+ * EV3 through a tty (or a pseudo-terminal standing in for one).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page Transport
+ *
+ * The library includes a small serial transport for Linux hosts, which
+ * takes care of:
+ * - opening a tty and placing it in raw mode (8N1, no flow control)
+ * - running the handshake at \ref EV3UartGenerator::StateMachine::HANDSHAKE_BAUD
+ * - writing framed buffers with as few system calls as possible (a whole
+ *   handshake is written with a single \c writev())
+ * - switching to the baudrate negotiated by \c CMD \c SPEED, right after
+ *   the EV3 has acknowledged the handshake with \c SYS \c ACK
+ *
+ * Functions return \c -1 and set \c errno on error, like the system calls
+ * they are built on.
+ *
+ * The transport is declared in the file \ref linux/transport.hpp
+ *
+ * \note Code under \c linux/ requires a hosted Linux environment, and is
+ * kept out of the library root so that it is not compiled for Arduino
+ * targets.
+ */
+
+#ifndef LINUX_TRANSPORT_HPP_
+#define LINUX_TRANSPORT_HPP_
+
+#include <sensor_state_machine.hpp>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace EV3UartGenerator {
+namespace Linux {
+	using StateMachine::HANDSHAKE_BAUD;
+
+	/**
+	 * Serial transport over a tty file descriptor.
+	 */
+	class Transport {
+	public:
+		Transport();
+		~Transport();
+		Transport(const Transport&) = delete;
+		Transport& operator=(const Transport&) = delete;
+
+		/**
+		 * Opens a tty, and places it in raw mode at HANDSHAKE_BAUD.
+		 *
+		 * @param path path to the tty device
+		 * @retval 0 on success
+		 * @retval -1 on error
+		 */
+		int open(const char* path);
+
+		/**
+		 * Takes ownership of an open tty file descriptor, and places it in
+		 * raw mode at HANDSHAKE_BAUD.
+		 *
+		 * @param fd tty file descriptor, closed by the transport
+		 * @retval 0 on success
+		 * @retval -1 on error (the descriptor is closed)
+		 */
+		int adopt(int fd);
+
+		/**
+		 * Closes the tty, if open.
+		 */
+		void close();
+
+		/**
+		 * @return file descriptor of the tty, or -1 if closed
+		 */
+		int fd() const {
+			return tty;
+		}
+
+		/**
+		 * @return current baudrate of the tty
+		 */
+		uint32_t baud() const {
+			return current_baud;
+		}
+
+		/**
+		 * Changes the baudrate of the tty immediately.
+		 *
+		 * @param baud baudrate - one of the standard termios baudrates
+		 * @retval 0 on success
+		 * @retval -1 on error (\c EINVAL for unsupported baudrates)
+		 */
+		int set_baud(uint32_t baud);
+
+		/**
+		 * Writes a whole buffer, retrying on partial writes.
+		 *
+		 * @param buf buffer to write
+		 * @param len length of the buffer
+		 * @return number of bytes written (\c len) on success
+		 * @retval -1 on error
+		 */
+		ssize_t write(const uint8_t* buf, size_t len);
+
+		/**
+		 * Writes a set of buffers with a single \c writev(), retrying on
+		 * partial writes.
+		 *
+		 * @param iov buffers to write
+		 * @param count number of buffers
+		 * @param done if not null, set to the number of bytes written - on
+		 * error too, as bytes may have been written before it occurred
+		 * @return total number of bytes written on success
+		 * @retval -1 on error
+		 */
+		ssize_t writev(const struct iovec* iov, int count,
+				size_t* done = nullptr);
+
+		/**
+		 * Reads available bytes, waiting up to \c timeout_ms for at least
+		 * one byte to arrive.
+		 *
+		 * @param buf destination buffer
+		 * @param len size of the destination buffer
+		 * @param timeout_ms maximum time to wait, or -1 to wait forever
+		 * @return number of bytes read, 0 on timeout
+		 * @retval -1 on error
+		 */
+		ssize_t read(uint8_t* buf, size_t len, int timeout_ms);
+
+		/**
+		 * Waits until all written bytes have been transmitted.
+		 *
+		 * @retval 0 on success
+		 * @retval -1 on error
+		 */
+		int drain();
+
+		/**
+		 * Runs the sensor side of the initialization handshake:
+		 * - switches to HANDSHAKE_BAUD
+		 * - writes the handshake (ending with \c SYS \c ACK) with one
+		 *   \c writev(), and waits for it to be transmitted
+		 * - waits for \c SYS \c ACK from the EV3, ignoring other messages
+		 * - switches to \c speed
+		 *
+		 * @param iov handshake, as framed by the functions in \ref Framing
+		 * @param count number of buffers in \c iov
+		 * @param speed baudrate advertised in the \c CMD \c SPEED message
+		 * @param timeout_ms maximum time to wait for the EV3 to acknowledge
+		 * the handshake, or -1 to wait forever
+		 * @retval 0 on success
+		 * @retval -1 on error (\c ETIMEDOUT if the EV3 did not acknowledge)
+		 */
+		int handshake(const struct iovec* iov, int count, uint32_t speed,
+				int timeout_ms);
+
+	private:
+		int tty;
+		uint32_t current_baud;
+	};
+}
+}
+
+#endif /* LINUX_TRANSPORT_HPP_ */
@@ -0,0 +1,412 @@
+/**
+ * \file sample_decoding.cpp
+ *
+ * Function definitions for functions in \ref sample_decoding.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <sample_decoding.hpp>
+#include <simple_endian.hpp>
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(EV3UARTGENERATOR_SAMPLES_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace EV3UartGenerator {
+namespace SampleDecoding {
+	namespace {
+		using Magics::INFO_DTYPE;
+
+		constexpr uint8_t VECTOR_MIN { 4 }; // Modes with less elements are decoded faster one sample at a time
+
+		/**
+		 * Tag selecting the overload for a data type.
+		 */
+		template <INFO_DTYPE D>
+		struct Type {
+		};
+
+		/**
+		 * Scalar access to samples of a data type.
+		 */
+		template <INFO_DTYPE D>
+		struct Sample;
+
+		template <>
+		struct Sample<INFO_DTYPE::S8> {
+			static constexpr uint8_t SIZE { 1 };
+			static int32_t load(const uint8_t* src) {
+				return static_cast<int8_t>(src[0]);
+			}
+		};
+
+		template <>
+		struct Sample<INFO_DTYPE::S16> {
+			static constexpr uint8_t SIZE { 2 };
+			static int32_t load(const uint8_t* src) {
+				return static_cast<int16_t>(SimpleEndian::load_le16(src));
+			}
+		};
+
+		template <>
+		struct Sample<INFO_DTYPE::S32> {
+			static constexpr uint8_t SIZE { 4 };
+			static int32_t load(const uint8_t* src) {
+				return static_cast<int32_t>(SimpleEndian::load_le32(src));
+			}
+		};
+
+		template <>
+		struct Sample<INFO_DTYPE::F32> {
+			static constexpr uint8_t SIZE { 4 };
+			static float load(const uint8_t* src) {
+				return SimpleEndian::load_le_f32(src);
+			}
+		};
+
+		/*
+		 * Data types which can be decoded into each type of sample array.
+		 * S32 samples are converted to float like
+		 * Registry::SensorRegistry::decode() does.
+		 */
+		bool accepts(INFO_DTYPE data_type, const int16_t*) {
+			return (data_type == INFO_DTYPE::S8)
+					|| (data_type == INFO_DTYPE::S16);
+		}
+
+		bool accepts(INFO_DTYPE data_type, const int32_t*) {
+			return (data_type != INFO_DTYPE::F32);
+		}
+
+		bool accepts(INFO_DTYPE, const float*) {
+			return true;
+		}
+
+		/**
+		 * Checks a batch of messages against the format of their mode,
+		 * before anything is read from their payloads.
+		 */
+		template <typename T>
+		bool acceptable(const Decoding::Frame* frames, size_t count,
+				const Registry::ModeInfo& info) {
+			if ((info.sample_size == 0)
+					|| !accepts(info.data_type, static_cast<const T*>(nullptr)))
+				return false;
+			for (size_t m = 0; m < count; m++) {
+				if (frames[m].payload_size() < info.payload_size)
+					return false;
+			}
+			return true;
+		}
+
+		/**
+		 * Decodes elements [first, elems) of messages [begin, end), one
+		 * sample at a time.
+		 */
+		template <INFO_DTYPE D, typename T>
+		void decode_rows(const Decoding::Frame* frames, size_t begin,
+				size_t end, uint8_t first, uint8_t elems, T* columns,
+				size_t stride) {
+			for (size_t m = begin; m < end; m++) {
+				const uint8_t* const payload { frames[m].payload() };
+				for (uint8_t e = first; e < elems; e++)
+					columns[(e * stride) + m] = static_cast<T>(
+							Sample<D>::load(payload + (e * Sample<D>::SIZE)));
+			}
+		}
+
+		/**
+		 * Decodes a batch of messages in tiles of 4 messages x 4 elements,
+		 * and the remaining samples one at a time. The last elements are not
+		 * padded to a full tile: copying them into a padded buffer stalls
+		 * the vector loads on the copy, and takes longer than scalar loads.
+		 *
+		 * \c Isa provides:
+		 * - \c Lanes, a vector of 4 32-bit lanes
+		 * - \c load(), widening 4 samples of a data type to \c Lanes
+		 * - \c transpose(), transposing 4 \c Lanes in place
+		 * - \c store(), writing \c Lanes to 4 samples of a sample array
+		 */
+		template <typename Isa, INFO_DTYPE D, typename T>
+		void decode_tiles(const Decoding::Frame* frames, size_t count,
+				uint8_t elems, T* columns, size_t stride) {
+			using Lanes = typename Isa::Lanes;
+			constexpr Type<D> type { };
+			const size_t tiled { count & ~static_cast<size_t>(0x03) };
+			const uint8_t tiled_elems { static_cast<uint8_t>(elems & ~0x03) };
+			for (size_t m = 0; m < tiled; m += 4) {
+				const uint8_t* const payloads[4] { frames[m].payload(),
+					frames[m + 1].payload(), frames[m + 2].payload(),
+					frames[m + 3].payload() };
+				for (uint8_t e = 0; e < tiled_elems; e += 4) {
+					const size_t offset { static_cast<size_t>(
+							e * Sample<D>::SIZE) };
+					Lanes lanes[4] { Isa::load(payloads[0] + offset, type),
+						Isa::load(payloads[1] + offset, type),
+						Isa::load(payloads[2] + offset, type),
+						Isa::load(payloads[3] + offset, type) };
+					Isa::transpose(lanes);
+					T* const dest { columns + (e * stride) + m };
+					Isa::store(dest, lanes[0], type);
+					Isa::store(dest + stride, lanes[1], type);
+					Isa::store(dest + (2 * stride), lanes[2], type);
+					Isa::store(dest + (3 * stride), lanes[3], type);
+				}
+			}
+			decode_rows<D>(frames, 0, tiled, tiled_elems, elems, columns,
+					stride);
+			decode_rows<D>(frames, tiled, count, 0, elems, columns, stride);
+		}
+
+		template <typename Isa, typename T>
+		int8_t decode_columns_vector(const Decoding::Frame* frames,
+				size_t count, const Registry::ModeInfo& info, T* columns,
+				size_t stride) {
+			if (!acceptable<T>(frames, count, info))
+				return -1;
+			switch (info.data_type) {
+			case INFO_DTYPE::S8:
+				decode_tiles<Isa, INFO_DTYPE::S8>(frames, count, info.elems,
+						columns, stride);
+				break;
+			case INFO_DTYPE::S16:
+				decode_tiles<Isa, INFO_DTYPE::S16>(frames, count, info.elems,
+						columns, stride);
+				break;
+			case INFO_DTYPE::S32:
+				decode_tiles<Isa, INFO_DTYPE::S32>(frames, count, info.elems,
+						columns, stride);
+				break;
+			default:
+				decode_tiles<Isa, INFO_DTYPE::F32>(frames, count, info.elems,
+						columns, stride);
+				break;
+			}
+			return static_cast<int8_t>(info.elems);
+		}
+
+#if defined(__SSE2__)
+		struct Sse2 {
+			using Lanes = __m128i;
+
+			static Lanes load(const uint8_t* src, Type<INFO_DTYPE::S8>) {
+				int32_t word;
+				memcpy(&word, src, sizeof(word));
+				const __m128i bytes { _mm_cvtsi32_si128(word) };
+				const __m128i halves { _mm_unpacklo_epi8(bytes, bytes) };
+				// Every lane holds 4 copies of its byte, shift the top one down
+				return _mm_srai_epi32(_mm_unpacklo_epi16(halves, halves), 24);
+			}
+
+			static Lanes load(const uint8_t* src, Type<INFO_DTYPE::S16>) {
+				const __m128i halves { _mm_loadl_epi64(
+						reinterpret_cast<const __m128i*>(src)) };
+				return _mm_srai_epi32(_mm_unpacklo_epi16(halves, halves), 16);
+			}
+
+			static Lanes load(const uint8_t* src, Type<INFO_DTYPE::S32>) {
+				return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			}
+
+			static Lanes load(const uint8_t* src, Type<INFO_DTYPE::F32>) {
+				return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			}
+
+			static void transpose(Lanes (&lanes)[4]) {
+				const __m128i lo01 { _mm_unpacklo_epi32(lanes[0], lanes[1]) };
+				const __m128i lo23 { _mm_unpacklo_epi32(lanes[2], lanes[3]) };
+				const __m128i hi01 { _mm_unpackhi_epi32(lanes[0], lanes[1]) };
+				const __m128i hi23 { _mm_unpackhi_epi32(lanes[2], lanes[3]) };
+				lanes[0] = _mm_unpacklo_epi64(lo01, lo23);
+				lanes[1] = _mm_unpackhi_epi64(lo01, lo23);
+				lanes[2] = _mm_unpacklo_epi64(hi01, hi23);
+				lanes[3] = _mm_unpackhi_epi64(hi01, hi23);
+			}
+
+			template <INFO_DTYPE D>
+			static void store(int16_t* dest, Lanes lanes, Type<D>) {
+				// S8 and S16 samples fit, so saturation never happens
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(dest),
+						_mm_packs_epi32(lanes, lanes));
+			}
+
+			template <INFO_DTYPE D>
+			static void store(int32_t* dest, Lanes lanes, Type<D>) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), lanes);
+			}
+
+			template <INFO_DTYPE D>
+			static void store(float* dest, Lanes lanes, Type<D>) {
+				_mm_storeu_ps(dest, _mm_cvtepi32_ps(lanes));
+			}
+
+			static void store(float* dest, Lanes lanes, Type<INFO_DTYPE::F32>) {
+				_mm_storeu_ps(dest, _mm_castsi128_ps(lanes));
+			}
+		};
+#endif
+
+#if defined(EV3UARTGENERATOR_SAMPLES_NEON)
+		struct Neon {
+			using Lanes = int32x4_t;
+
+			static Lanes load(const uint8_t* src, Type<INFO_DTYPE::S8>) {
+				uint32_t word;
+				memcpy(&word, src, sizeof(word));
+				const int16x8_t halves { vmovl_s8(vreinterpret_s8_u32(
+						vdup_n_u32(word))) };
+				return vmovl_s16(vget_low_s16(halves));
+			}
+
+			static Lanes load(const uint8_t* src, Type<INFO_DTYPE::S16>) {
+				return vmovl_s16(vreinterpret_s16_u8(vld1_u8(src)));
+			}
+
+			static Lanes load(const uint8_t* src, Type<INFO_DTYPE::S32>) {
+				return vreinterpretq_s32_u8(vld1q_u8(src));
+			}
+
+			static Lanes load(const uint8_t* src, Type<INFO_DTYPE::F32>) {
+				return vreinterpretq_s32_u8(vld1q_u8(src));
+			}
+
+			static void transpose(Lanes (&lanes)[4]) {
+				const int32x4x2_t t01 { vtrnq_s32(lanes[0], lanes[1]) };
+				const int32x4x2_t t23 { vtrnq_s32(lanes[2], lanes[3]) };
+				lanes[0] = vcombine_s32(vget_low_s32(t01.val[0]),
+						vget_low_s32(t23.val[0]));
+				lanes[1] = vcombine_s32(vget_low_s32(t01.val[1]),
+						vget_low_s32(t23.val[1]));
+				lanes[2] = vcombine_s32(vget_high_s32(t01.val[0]),
+						vget_high_s32(t23.val[0]));
+				lanes[3] = vcombine_s32(vget_high_s32(t01.val[1]),
+						vget_high_s32(t23.val[1]));
+			}
+
+			template <INFO_DTYPE D>
+			static void store(int16_t* dest, Lanes lanes, Type<D>) {
+				vst1_s16(dest, vmovn_s32(lanes));
+			}
+
+			template <INFO_DTYPE D>
+			static void store(int32_t* dest, Lanes lanes, Type<D>) {
+				vst1q_s32(dest, lanes);
+			}
+
+			template <INFO_DTYPE D>
+			static void store(float* dest, Lanes lanes, Type<D>) {
+				vst1q_f32(dest, vcvtq_f32_s32(lanes));
+			}
+
+			static void store(float* dest, Lanes lanes, Type<INFO_DTYPE::F32>) {
+				vst1q_f32(dest, vreinterpretq_f32_s32(lanes));
+			}
+		};
+#endif
+	}
+
+	template <typename T>
+	int8_t decode_columns_scalar(const Decoding::Frame* frames, size_t count,
+			const Registry::ModeInfo& info, T* columns, size_t stride) {
+		if (!acceptable<T>(frames, count, info))
+			return -1;
+		switch (info.data_type) {
+		case INFO_DTYPE::S8:
+			decode_rows<INFO_DTYPE::S8>(frames, 0, count, 0, info.elems,
+					columns, stride);
+			break;
+		case INFO_DTYPE::S16:
+			decode_rows<INFO_DTYPE::S16>(frames, 0, count, 0, info.elems,
+					columns, stride);
+			break;
+		case INFO_DTYPE::S32:
+			decode_rows<INFO_DTYPE::S32>(frames, 0, count, 0, info.elems,
+					columns, stride);
+			break;
+		default:
+			decode_rows<INFO_DTYPE::F32>(frames, 0, count, 0, info.elems,
+					columns, stride);
+			break;
+		}
+		return static_cast<int8_t>(info.elems);
+	}
+
+#if defined(__SSE2__)
+	template <typename T>
+	int8_t decode_columns_sse2(const Decoding::Frame* frames, size_t count,
+			const Registry::ModeInfo& info, T* columns, size_t stride) {
+		return decode_columns_vector<Sse2>(frames, count, info, columns,
+				stride);
+	}
+#endif
+
+#if defined(EV3UARTGENERATOR_SAMPLES_NEON)
+	template <typename T>
+	int8_t decode_columns_neon(const Decoding::Frame* frames, size_t count,
+			const Registry::ModeInfo& info, T* columns, size_t stride) {
+		return decode_columns_vector<Neon>(frames, count, info, columns,
+				stride);
+	}
+#endif
+
+	template <typename T>
+	int8_t decode_columns(const Decoding::Frame* frames, size_t count,
+			const Registry::ModeInfo& info, T* columns, size_t stride) {
+#if defined(EV3UARTGENERATOR_SCALAR_SAMPLES)
+		return decode_columns_scalar(frames, count, info, columns, stride);
+#elif defined(__SSE2__)
+		return (info.elems < VECTOR_MIN)
+				? decode_columns_scalar(frames, count, info, columns, stride)
+				: decode_columns_sse2(frames, count, info, columns, stride);
+#elif defined(EV3UARTGENERATOR_SAMPLES_NEON)
+		return (info.elems < VECTOR_MIN)
+				? decode_columns_scalar(frames, count, info, columns, stride)
+				: decode_columns_neon(frames, count, info, columns, stride);
+#else
+		return decode_columns_scalar(frames, count, info, columns, stride);
+#endif
+	}
+
+	const char* kernel() {
+#if defined(EV3UARTGENERATOR_SCALAR_SAMPLES)
+		return "scalar";
+#elif defined(__SSE2__)
+		return "sse2";
+#elif defined(EV3UARTGENERATOR_SAMPLES_NEON)
+		return "neon";
+#else
+		return "scalar";
+#endif
+	}
+
+#define EV3UARTGENERATOR_INSTANTIATE(kernel, T) \
+	template int8_t kernel<T>(const Decoding::Frame* frames, size_t count, \
+			const Registry::ModeInfo& info, T* columns, size_t stride);
+
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_scalar, int16_t)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_scalar, int32_t)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_scalar, float)
+#if defined(__SSE2__)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_sse2, int16_t)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_sse2, int32_t)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_sse2, float)
+#endif
+#if defined(EV3UARTGENERATOR_SAMPLES_NEON)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_neon, int16_t)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_neon, int32_t)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns_neon, float)
+#endif
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns, int16_t)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns, int32_t)
+	EV3UARTGENERATOR_INSTANTIATE(decode_columns, float)
+
+#undef EV3UARTGENERATOR_INSTANTIATE
+}
+}
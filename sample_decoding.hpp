@@ -0,0 +1,139 @@
+/**
+ * \file sample_decoding.hpp
+ *
+ * Bulk decoding of the samples of DATA messages into per-element sample
+ * arrays.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page SampleDecoding
+ *
+ * \ref EV3UartGenerator::Registry::SensorRegistry::decode() decodes the
+ * samples of a single \c DATA message. Hosts that log every sample of many
+ * ports at once, such as \ref HostEmulator, receive batches of \c DATA
+ * messages in the same mode - one per port, or a run of readings from a
+ * single port - and decode them with
+ * \ref EV3UartGenerator::SampleDecoding::decode_columns() instead.
+ *
+ * The samples are written as one array per data element (structure of
+ * arrays): element \c e of message \c m is stored at
+ * <tt>columns[e * stride + m]</tt>. Messages are decoded four at a time,
+ * four elements per message, by widening the samples to 32-bit lanes
+ * (sign extending \c S8 and \c S16 samples) and transposing the resulting
+ * 4 x 4 tile, so that every store writes four consecutive samples of a
+ * single element. The elements left over, for modes with a number of
+ * elements that is not a multiple of 4, are decoded one sample at a time.
+ *
+ * Kernel | Availability
+ * ------ | ------------
+ * \ref EV3UartGenerator::SampleDecoding::decode_columns_scalar() "scalar" | Always, one sample at a time
+ * \ref EV3UartGenerator::SampleDecoding::decode_columns_sse2() "sse2" | When compiling with \c __SSE2__ defined
+ * \ref EV3UartGenerator::SampleDecoding::decode_columns_neon() "neon" | When compiling with \c __ARM_NEON defined, for little-endian targets
+ *
+ * \ref EV3UartGenerator::SampleDecoding::decode_columns() uses the widest
+ * kernel available, selected at compile time, for modes with at least 4
+ * elements. The scalar kernel is used for modes with fewer elements, which
+ * leave nothing to transpose, and always on AVR (Arduino) targets, or when
+ * \c EV3UARTGENERATOR_SCALAR_SAMPLES is defined.
+ *
+ * \code
+ * Decoding::Frame frames[64]; // DATA messages in the same mode
+ * int16_t columns[3][64];     // 3 elements per message, e.g. RGB-RAW
+ * const Registry::ModeInfo& info { registry.sensor(port).modes[4] };
+ * if (SampleDecoding::decode_columns(frames, 64, info, &columns[0][0], 64) == 3)
+ *     ... // columns[1][m] is the green reading of message m
+ * \endcode
+ *
+ * The kernels are declared in the file \ref sample_decoding.hpp
+ */
+
+#ifndef SAMPLE_DECODING_HPP_
+#define SAMPLE_DECODING_HPP_
+
+#include <decoding.hpp>
+#include <sensor_registry.hpp>
+#include <stdint.h> // We can't include <cstdint> if we want to compile under Arduino
+#include <stddef.h> // We can't include <cstddef> if we want to compile under Arduino
+
+#if !defined(EV3UARTGENERATOR_SCALAR_SAMPLES) && defined(__AVR__)
+#define EV3UARTGENERATOR_SCALAR_SAMPLES
+#endif
+
+#if defined(__ARM_NEON) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define EV3UARTGENERATOR_SAMPLES_NEON
+#endif
+
+namespace EV3UartGenerator {
+namespace SampleDecoding {
+	/**
+	 * Decodes the samples of a batch of DATA messages, all in the same
+	 * mode, one sample at a time.
+	 *
+	 * Instantiated for \c T of \c int16_t (S8 and S16 samples), \c int32_t
+	 * (S8, S16 and S32 samples) and \c float (samples of any data type).
+	 *
+	 * @param frames DATA messages, which must remain valid during the call.
+	 * Frames returned by Decoding::FrameDecoder::next() may point into the
+	 * decoder, and so have to be copied before the next message is decoded
+	 * @param count number of messages
+	 * @param info data format of the mode of the messages, e.g. from
+	 * Registry::SensorRegistry::lookup()
+	 * @param columns destination, with space for <tt>info.elems</tt> rows of
+	 * \c stride samples
+	 * @param stride distance between the first samples of consecutive
+	 * elements, at least \c count
+	 * @return number of samples decoded per message
+	 * @retval -1 if the data type of the mode can not be represented by
+	 * \c T, or the payload of a message is too short for the format. Nothing
+	 * is written in that case.
+	 */
+	template <typename T>
+	int8_t decode_columns_scalar(const Decoding::Frame* frames, size_t count,
+			const Registry::ModeInfo& info, T* columns, size_t stride);
+
+#if defined(__SSE2__)
+	/**
+	 * \copybrief decode_columns_scalar()
+	 * Uses SSE2 instructions.
+	 *
+	 * \copydetails decode_columns_scalar()
+	 */
+	template <typename T>
+	int8_t decode_columns_sse2(const Decoding::Frame* frames, size_t count,
+			const Registry::ModeInfo& info, T* columns, size_t stride);
+#endif
+
+#if defined(EV3UARTGENERATOR_SAMPLES_NEON)
+	/**
+	 * \copybrief decode_columns_scalar()
+	 * Uses NEON instructions.
+	 *
+	 * \copydetails decode_columns_scalar()
+	 */
+	template <typename T>
+	int8_t decode_columns_neon(const Decoding::Frame* frames, size_t count,
+			const Registry::ModeInfo& info, T* columns, size_t stride);
+#endif
+
+	/**
+	 * \copybrief decode_columns_scalar()
+	 * Uses the widest kernel available on the target.
+	 *
+	 * \copydetails decode_columns_scalar()
+	 */
+	template <typename T>
+	int8_t decode_columns(const Decoding::Frame* frames, size_t count,
+			const Registry::ModeInfo& info, T* columns, size_t stride);
+
+	/**
+	 * @return name of the kernel used by decode_columns()
+	 */
+	const char* kernel();
+}
+}
+
+#endif /* SAMPLE_DECODING_HPP_ */
@@ -0,0 +1,16 @@
+/**
+ * \file sensor_descriptor.cpp
+ *
+ * Compiles the definitions in \ref sensor_descriptor_impl.hpp, unless the library is
+ * header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <sensor_descriptor.hpp>
+
+#if !EV3UARTGENERATOR_HEADER_ONLY
+#include <sensor_descriptor_impl.hpp>
+#endif
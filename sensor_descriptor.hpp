@@ -0,0 +1,164 @@
+/**
+ * \file sensor_descriptor.hpp
+ *
+ * Data structures describing a sensor, and functions that frame the
+ * initialization handshake of a sensor from its description.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page Descriptor
+ *
+ * Instead of calling the framing functions in \ref Framing one by one, the
+ * identity of a sensor (type, modes, baudrate, and the name, spans, symbol
+ * and data format of each mode) can be described by a
+ * \ref EV3UartGenerator::Descriptor::SensorDescriptor.
+ *
+ * The whole initialization handshake is then framed in one call to
+ * \ref EV3UartGenerator::Descriptor::frame_handshake(), into a buffer that
+ * can be sized exactly by calling
+ * \ref EV3UartGenerator::Descriptor::handshake_size() beforehand.
+ *
+ * Messages are framed in the same order as the LEGO sensors in
+ * \c doc/reference_bitstreams:
+ * - \c CMD \c TYPE, \c CMD \c MODES, \c CMD \c SPEED
+ * - for each mode, starting from the highest mode index: \c INFO \c NAME,
+ *   \c INFO \c SPAN (RAW, PCT, SI - if present), \c INFO \c SYMBOL
+ *   (if present), \c INFO \c FORMAT
+ * - \c SYS \c ACK
+ *
+ * The data structures and functions are declared in the file
+ * \ref sensor_descriptor.hpp
+ */
+
+#ifndef SENSOR_DESCRIPTOR_HPP_
+#define SENSOR_DESCRIPTOR_HPP_
+
+#include <header_only.hpp>
+#include <framing.hpp>
+#include <frame_buffer.hpp>
+#include <magics.hpp>
+#include <stddef.h> // We can't include <cstddef> if we want to compile under Arduino
+
+namespace EV3UartGenerator {
+namespace Descriptor {
+	constexpr uint8_t MODES_MAX { 0x08 }; ///< Maximum number of modes a sensor can have
+	/**
+	 * Maximum size of an initialization handshake: \c CMD \c TYPE,
+	 * \c CMD \c MODES, \c CMD \c SPEED and \c SYS \c ACK (14 bytes), plus
+	 * NAME, three SPANs, SYMBOL and FORMAT for every mode (86 bytes each)
+	 */
+	constexpr uint16_t HANDSHAKE_MAX { 14 + (MODES_MAX * 86) };
+
+	/**
+	 * Span of values returned from a sensor, for a particular unit of
+	 * readings.
+	 */
+	struct SpanDescriptor {
+		bool present; ///< Whether the span is sent to the EV3 at all
+		float lower; ///< Lower bound of the span
+		float upper; ///< Upper bound of the span
+	};
+
+	/**
+	 * Description of a single mode of a sensor.
+	 */
+	struct ModeDescriptor {
+		const char* name; ///< Mode name, with length in range [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+		SpanDescriptor raw; ///< Span of raw readings
+		SpanDescriptor pct; ///< Span of readings in percent
+		SpanDescriptor si; ///< Span of readings in SI units
+		const char* symbol; ///< Symbol of the SI unit, with length in range [PAYLOAD_MIN, SYMBOL_MAX], or \c nullptr if omitted
+		uint8_t elems; ///< Number of data elements in a DATA message
+		Magics::INFO_DTYPE data_type; ///< Type of data elements
+		uint8_t width; ///< Number of characters used to display readings [0, 15]
+		uint8_t decimals; ///< Number of characters after the decimal point used to display readings [0, 15]
+	};
+
+	/**
+	 * Description of a sensor.
+	 */
+	struct SensorDescriptor {
+		uint8_t type; ///< Sensor type index [0, 255]
+		uint8_t modes; ///< Number of modes in \c mode_table [1, MODES_MAX]
+		uint8_t modes_visible; ///< Number of modes visible to the user [1, modes]
+		uint32_t speed; ///< Maximum baudrate supported by the sensor
+		const ModeDescriptor* mode_table; ///< Descriptions of each mode, indexed by mode index
+	};
+
+	/**
+	 * Calculates the exact size of the initialization handshake of a sensor.
+	 *
+	 * @param sensor sensor description
+	 * @return size of the handshake in bytes, if positive.
+	 * @retval -1 on error (invalid mode count, name length or symbol length)
+	 */
+	int16_t handshake_size(const SensorDescriptor& sensor);
+
+	/**
+	 * Frames the initialization handshake of a sensor, from the first
+	 * \c CMD \c TYPE message to the final \c SYS \c ACK message.
+	 *
+	 * Nothing is written to the buffer if the handshake does not fit into
+	 * it, or if the description is invalid.
+	 *
+	 * @param dest destination buffer
+	 * @param capacity size of the destination buffer
+	 * @param sensor sensor description
+	 * @return length of framed handshake (written to the buffer), if positive.
+	 * @retval -1 on error (invalid description / buffer too small)
+	 *
+	 * @note the counts in the \c CMD \c MODES message are sent as
+	 * <tt>modes - 1</tt> and <tt>modes_visible - 1</tt>, as done by the
+	 * LEGO sensors.
+	 */
+	int16_t frame_handshake(uint8_t* dest, const size_t capacity,
+			const SensorDescriptor& sensor);
+
+	/**
+	 * Appends the initialization handshake of a sensor to a buffer. See
+	 * frame_handshake().
+	 *
+	 * @param buffer destination buffer
+	 * @param sensor sensor description
+	 * @return size of the handshake, or the reason for failing
+	 * (FrameError::INVALID for an invalid description, FrameError::NO_SPACE
+	 * if the handshake does not fit). Nothing is appended on error.
+	 */
+	Framing::FrameResult frame_handshake(Framing::FrameBuffer& buffer,
+			const SensorDescriptor& sensor);
+
+	/**
+	 * Frames an EV3 data message for a mode of a sensor from an array of
+	 * native samples, checking the samples against the data format of the
+	 * mode. See Framing::frame_data_samples().
+	 *
+	 * @param dest destination buffer
+	 * @param sensor sensor description
+	 * @param mode mode index, in range [0, sensor.modes - 1]
+	 * @param samples \c elems samples of the mode, of type \c int8_t,
+	 * \c int16_t, \c int32_t or \c float matching the \c data_type of the
+	 * mode
+	 * @return length of framed message (written to the buffer), if positive.
+	 * @retval -1 on error (mode out of range, sample type does not match)
+	 */
+	template <typename T>
+	int8_t frame_mode_data(uint8_t* dest, const SensorDescriptor& sensor,
+			const uint8_t mode, const T* samples) {
+		return (mode < sensor.modes)
+				? Framing::frame_data_samples(dest, mode, samples,
+						sensor.mode_table[mode].elems,
+						sensor.mode_table[mode].data_type)
+				: -1;
+	}
+}
+}
+
+#if EV3UARTGENERATOR_HEADER_ONLY
+#include <sensor_descriptor_impl.hpp>
+#endif
+
+#endif /* SENSOR_DESCRIPTOR_HPP_ */
@@ -0,0 +1,133 @@
+/**
+ * \file sensor_descriptor_impl.hpp
+ *
+ * Function definitions for functions in \ref sensor_descriptor.hpp
+ *
+ * Compiled in \c sensor_descriptor.cpp, or included by \ref sensor_descriptor.hpp when the library
+ * is header-only (see \ref HeaderOnly).
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#ifndef SENSOR_DESCRIPTOR_IMPL_HPP_
+#define SENSOR_DESCRIPTOR_IMPL_HPP_
+
+#include <sensor_descriptor.hpp>
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+namespace EV3UartGenerator {
+namespace Descriptor {
+	namespace Detail {
+		constexpr uint8_t HEADER_SIZE { Framing::frame_size_cmd_type_message()
+				+ Framing::frame_size_cmd_modes_message()
+				+ Framing::frame_size_cmd_speed_message() };
+		constexpr uint8_t TRAILER_SIZE { Framing::frame_size_sys_message() }; // SYS ACK
+
+		inline int16_t mode_size(const ModeDescriptor& mode) {
+			const size_t name_length { mode.name != nullptr ?
+					strlen(mode.name) : 0 };
+			if (name_length > Framing::PAYLOAD_SENSOR_TO_EV3_MAX)
+				return -1;
+			const int8_t name_size { Framing::frame_size_info_message_name(
+					static_cast<uint8_t>(name_length)) };
+			if (name_size < 0)
+				return -1;
+
+			int16_t size { static_cast<int16_t>(name_size
+					+ Framing::frame_size_info_message_format()) };
+			const SpanDescriptor* spans[] { &mode.raw, &mode.pct, &mode.si };
+			for (const SpanDescriptor* span : spans) {
+				if (span->present)
+					size += Framing::frame_size_info_message_span();
+			}
+
+			if (mode.symbol != nullptr) {
+				const size_t symbol_length { strlen(mode.symbol) };
+				if (symbol_length > Framing::SYMBOL_MAX)
+					return -1;
+				const int8_t symbol_size {
+					Framing::frame_size_info_message_symbol(
+							static_cast<uint8_t>(symbol_length)) };
+				if (symbol_size < 0)
+					return -1;
+				size += symbol_size;
+			}
+			return size;
+		}
+
+		inline uint8_t* frame_mode(uint8_t* dest, const uint8_t index,
+				const ModeDescriptor& mode) {
+			dest += Framing::frame_info_message_name(dest, index, mode.name);
+			if (mode.raw.present)
+				dest += Framing::frame_info_message_span(dest, index,
+						Magics::INFO_SPAN::RAW, mode.raw.lower, mode.raw.upper);
+			if (mode.pct.present)
+				dest += Framing::frame_info_message_span(dest, index,
+						Magics::INFO_SPAN::PCT, mode.pct.lower, mode.pct.upper);
+			if (mode.si.present)
+				dest += Framing::frame_info_message_span(dest, index,
+						Magics::INFO_SPAN::SI, mode.si.lower, mode.si.upper);
+			if (mode.symbol != nullptr)
+				dest += Framing::frame_info_message_symbol(dest, index,
+						mode.symbol);
+			dest += Framing::frame_info_message_format(dest, index, mode.elems,
+					mode.data_type, mode.width, mode.decimals);
+			return dest;
+		}
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int16_t handshake_size(const SensorDescriptor& sensor) {
+		if ((sensor.modes < 0x01) || (sensor.modes > MODES_MAX) ||
+				(sensor.modes_visible < 0x01) ||
+				(sensor.modes_visible > sensor.modes) ||
+				(sensor.mode_table == nullptr))
+			return -1;
+
+		int16_t size { Detail::HEADER_SIZE + Detail::TRAILER_SIZE };
+		for (uint8_t i = 0; i < sensor.modes; i++) {
+			const int16_t sz { Detail::mode_size(sensor.mode_table[i]) };
+			if (sz < 0)
+				return -1;
+			size += sz;
+		}
+		return size;
+	}
+
+	EV3UARTGENERATOR_INLINE
+	int16_t frame_handshake(uint8_t* dest, const size_t capacity,
+			const SensorDescriptor& sensor) {
+		const int16_t size { handshake_size(sensor) };
+		if ((size < 0) || (static_cast<size_t>(size) > capacity))
+			return -1;
+
+		uint8_t* const orig_dest { dest };
+		dest += Framing::frame_cmd_type_message(dest, sensor.type);
+		dest += Framing::frame_cmd_modes_message(dest, sensor.modes - 1,
+				sensor.modes_visible - 1);
+		dest += Framing::frame_cmd_speed_message(dest, sensor.speed);
+		for (uint8_t i = sensor.modes; i-- > 0; )
+			dest = Detail::frame_mode(dest, i, sensor.mode_table[i]);
+		dest += Framing::frame_sys_message(dest, Magics::SYS::ACK);
+		return static_cast<int16_t>(dest - orig_dest);
+	}
+
+	EV3UARTGENERATOR_INLINE
+	Framing::FrameResult frame_handshake(Framing::FrameBuffer& buffer,
+			const SensorDescriptor& sensor) {
+		const int16_t size { handshake_size(sensor) };
+		if (size < 0)
+			return Framing::FrameResult { 0, Framing::FrameError::INVALID };
+		uint8_t* const dest { buffer.reserve(size) };
+		if (dest == nullptr)
+			return Framing::FrameResult { 0, Framing::FrameError::NO_SPACE };
+		return Framing::FrameResult { static_cast<uint16_t>(
+				frame_handshake(dest, size, sensor)),
+				Framing::FrameError::NONE };
+	}
+}
+}
+
+#endif /* SENSOR_DESCRIPTOR_IMPL_HPP_ */
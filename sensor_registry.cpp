@@ -0,0 +1,198 @@
+/**
+ * \file sensor_registry.cpp
+ *
+ * Function definitions for functions in \ref sensor_registry.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <sensor_registry.hpp>
+#include <simple_endian.hpp>
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
+
+namespace EV3UartGenerator {
+namespace Registry {
+	namespace {
+		constexpr uint8_t RECEIVED_TYPE { 0x01 };
+		constexpr uint8_t RECEIVED_MODES { 0x02 };
+		constexpr uint8_t RECEIVED_SPEED { 0x04 };
+		constexpr uint8_t RECEIVED_ALL { RECEIVED_TYPE | RECEIVED_MODES
+				| RECEIVED_SPEED };
+
+		constexpr uint8_t INFO_NAME { 0x00 };
+		constexpr uint8_t INFO_SYMBOL { 0x04 };
+		constexpr uint8_t INFO_FORMAT { 0x80 };
+
+		uint8_t sample_size(const Magics::INFO_DTYPE data_type) {
+			switch (data_type) {
+			case Magics::INFO_DTYPE::S8:
+				return 1;
+			case Magics::INFO_DTYPE::S16:
+				return 2;
+			case Magics::INFO_DTYPE::S32:
+			case Magics::INFO_DTYPE::F32:
+				return 4;
+			default:
+				return 0;
+			}
+		}
+
+		/**
+		 * Copies a null terminated, or padded, string out of a payload.
+		 */
+		void copy_text(char* dest, const uint8_t max, const uint8_t* payload,
+				const uint8_t size) {
+			uint8_t len { 0 };
+			while ((len < size) && (len < max) && (payload[len] != 0x00))
+				len++;
+			memcpy(dest, payload, len);
+			dest[len] = '\0';
+		}
+
+		/**
+		 * Decodes samples of an integer data type.
+		 */
+		template <typename T>
+		void widen(const ModeInfo& info, const uint8_t* payload, T* samples) {
+			switch (info.data_type) {
+			case Magics::INFO_DTYPE::S8:
+				for (uint8_t i = 0; i < info.elems; i++)
+					samples[i] = static_cast<int8_t>(payload[i]);
+				break;
+			case Magics::INFO_DTYPE::S16:
+				for (uint8_t i = 0; i < info.elems; i++)
+					samples[i] = static_cast<int16_t>(
+							SimpleEndian::load_le16(payload + (i * 2)));
+				break;
+			default:
+				for (uint8_t i = 0; i < info.elems; i++)
+					samples[i] = static_cast<int32_t>(
+							SimpleEndian::load_le32(payload + (i * 4)));
+				break;
+			}
+		}
+	}
+
+	Descriptor::SensorDescriptor SensorInfo::descriptor(
+			Descriptor::ModeDescriptor (&table)[Descriptor::MODES_MAX]) const {
+		for (uint8_t mode = 0; mode < Descriptor::MODES_MAX; mode++) {
+			const ModeDetails& d { details[mode] };
+			table[mode] = Descriptor::ModeDescriptor { d.name, d.raw, d.pct,
+				d.si, (d.symbol[0] != '\0') ? d.symbol : nullptr,
+				modes[mode].elems, modes[mode].data_type, d.width, d.decimals };
+		}
+		return Descriptor::SensorDescriptor { type, mode_count, modes_visible,
+			speed, table };
+	}
+
+	SensorRegistry::SensorRegistry(SensorInfo* table, size_t ports)
+		: table { table }, ports { ports } {
+		for (size_t port = 0; port < ports; port++)
+			reset(port);
+	}
+
+	void SensorRegistry::reset(size_t port) {
+		memset(&table[port], 0, sizeof(table[port]));
+	}
+
+	int8_t SensorRegistry::receive(size_t port, const Decoding::Frame& frame) {
+		SensorInfo& sensor { table[port] };
+		const uint8_t* const payload { frame.payload() };
+		const uint8_t size { frame.payload_size() };
+
+		if (frame.is(Magics::CMD::TYPE)) {
+			// Start of a (possibly repeated) handshake
+			reset(port);
+			sensor.type = payload[0];
+			sensor.received = RECEIVED_TYPE;
+			return 0;
+		} else if (frame.is(Magics::CMD::MODES)) {
+			// The number of visible modes is optional
+			sensor.mode_count = (payload[0] & 0x07) + 1;
+			sensor.modes_visible = (size > 1) ? ((payload[1] & 0x07) + 1)
+					: sensor.mode_count;
+			sensor.received |= RECEIVED_MODES;
+			return 0;
+		} else if (frame.is(Magics::CMD::SPEED)) {
+			if (size < 4)
+				return -1;
+			sensor.speed = SimpleEndian::load_le32(payload);
+			sensor.received |= RECEIVED_SPEED;
+			return 0;
+		} else if (frame.is(Magics::SYS::ACK)) {
+			const uint8_t all_modes { static_cast<uint8_t>(
+					(0x01 << sensor.mode_count) - 1) };
+			uint8_t formats { 0 };
+			for (uint8_t mode = 0; mode < Descriptor::MODES_MAX; mode++)
+				formats |= (sensor.modes[mode].sample_size != 0) << mode;
+			sensor.complete = (sensor.received == RECEIVED_ALL)
+					&& ((formats & all_modes) == all_modes);
+			return sensor.complete ? 1 : -1;
+		} else if (!frame.is_info()) {
+			return 0;
+		}
+
+		const uint8_t mode { frame.mode() };
+		ModeDetails& details { sensor.details[mode] };
+		switch (frame.info_type()) {
+		case INFO_NAME:
+			copy_text(details.name, Framing::PAYLOAD_SENSOR_TO_EV3_MAX, payload,
+					size);
+			return 0;
+		case static_cast<uint8_t>(Magics::INFO_SPAN::RAW):
+		case static_cast<uint8_t>(Magics::INFO_SPAN::PCT):
+		case static_cast<uint8_t>(Magics::INFO_SPAN::SI): {
+			if (size < 8)
+				return -1;
+			Descriptor::SpanDescriptor* const spans[] { &details.raw,
+				&details.pct, &details.si };
+			*spans[frame.info_type() - 1] = Descriptor::SpanDescriptor { true,
+				SimpleEndian::load_le_f32(payload),
+				SimpleEndian::load_le_f32(payload + 4) };
+			return 0;
+		}
+		case INFO_SYMBOL:
+			copy_text(details.symbol, Framing::SYMBOL_MAX, payload, size);
+			return 0;
+		case INFO_FORMAT: {
+			const Magics::INFO_DTYPE data_type {
+				static_cast<Magics::INFO_DTYPE>(payload[1]) };
+			const uint8_t bytes { sample_size(data_type) };
+			if ((size < 4) || (bytes == 0)
+					|| ((payload[0] * bytes) > Framing::PAYLOAD_SENSOR_TO_EV3_MAX))
+				return -1;
+			sensor.modes[mode] = ModeInfo { payload[0], data_type, bytes,
+				static_cast<uint8_t>(payload[0] * bytes) };
+			details.width = payload[2];
+			details.decimals = payload[3];
+			return 0;
+		}
+		default:
+			return -1;
+		}
+	}
+
+	int8_t SensorRegistry::decode(size_t port, const Decoding::Frame& frame,
+			int32_t* samples) const {
+		const ModeInfo* const info { lookup(port, frame) };
+		if ((info == nullptr) || (info->data_type == Magics::INFO_DTYPE::F32))
+			return -1;
+		widen(*info, frame.payload(), samples);
+		return static_cast<int8_t>(info->elems);
+	}
+
+	int8_t SensorRegistry::decode(size_t port, const Decoding::Frame& frame,
+			float* samples) const {
+		const ModeInfo* const info { lookup(port, frame) };
+		if (info == nullptr)
+			return -1;
+		if (info->data_type == Magics::INFO_DTYPE::F32)
+			SimpleEndian::load_le(samples, frame.payload(), info->elems);
+		else
+			widen(*info, frame.payload(), samples);
+		return static_cast<int8_t>(info->elems);
+	}
+}
+}
@@ -0,0 +1,209 @@
+/**
+ * \file sensor_registry.hpp
+ *
+ * Host side tables of the modes of connected sensors, built from their
+ * initialization handshakes.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page Registry
+ *
+ * On the EV3 side of the protocol, every \c DATA message has to be
+ * interpreted with the data format that the sensor announced for the mode
+ * in its handshake. \ref EV3UartGenerator::Registry::SensorRegistry consumes
+ * the handshake of the sensor on every port message by message, as the
+ * messages arrive, and records each mode in a
+ * \ref EV3UartGenerator::Registry::SensorInfo:
+ * - the data format needed to decode \c DATA messages is kept in a
+ *   compact table of \ref EV3UartGenerator::Registry::ModeInfo, 4 bytes per
+ *   mode, indexed by the mode field of the message type byte - decoding a
+ *   \c DATA message takes a single table lookup
+ * - names, symbols, spans and display settings, which are not needed to
+ *   decode \c DATA messages, are kept apart, in
+ *   \ref EV3UartGenerator::Registry::ModeDetails, so that they do not share
+ *   cache lines with the table
+ *
+ * \code
+ * Registry::SensorInfo table[4];
+ * Registry::SensorRegistry registry { table, 4 };
+ * while (decoder.next(frame)) {
+ *     if (frame.is_data()) {
+ *         int32_t samples[Framing::PAYLOAD_SENSOR_TO_EV3_MAX];
+ *         const int8_t count { registry.decode(port, frame, samples) };
+ *         ...
+ *     } else if (registry.receive(port, frame) == 1) {
+ *         ... // Handshake complete, acknowledge it
+ *     }
+ * }
+ * \endcode
+ *
+ * The registry does not allocate memory. It is declared in the file
+ * \ref sensor_registry.hpp
+ */
+
+#ifndef SENSOR_REGISTRY_HPP_
+#define SENSOR_REGISTRY_HPP_
+
+#include <decoding.hpp>
+#include <sensor_descriptor.hpp>
+#include <framing.hpp>
+#include <magics.hpp>
+#include <stdint.h> // We can't include <cstdint> if we want to compile under Arduino
+#include <stddef.h> // We can't include <cstddef> if we want to compile under Arduino
+
+namespace EV3UartGenerator {
+namespace Registry {
+	/**
+	 * Data format of a mode, everything needed to decode its \c DATA
+	 * messages.
+	 */
+	struct ModeInfo {
+		uint8_t elems; ///< Number of samples in a DATA message
+		Magics::INFO_DTYPE data_type; ///< Data type of the samples
+		uint8_t sample_size; ///< Size of a sample in bytes, or 0 if no INFO FORMAT message was received for the mode
+		uint8_t payload_size; ///< Size of all samples in bytes, without padding
+	};
+
+	static_assert(sizeof(ModeInfo) == 4, "ModeInfo tables are packed 4 bytes per mode");
+
+	/**
+	 * Remaining properties of a mode, which are not needed to decode its
+	 * \c DATA messages.
+	 */
+	struct ModeDetails {
+		char name[Framing::PAYLOAD_SENSOR_TO_EV3_MAX + 1]; ///< Null terminated name, from INFO NAME
+		char symbol[Framing::SYMBOL_MAX + 1]; ///< Null terminated symbol, from INFO SYMBOL, or empty
+		Descriptor::SpanDescriptor raw; ///< Span of raw readings, from INFO SPAN
+		Descriptor::SpanDescriptor pct; ///< Span of readings in percent, from INFO SPAN
+		Descriptor::SpanDescriptor si; ///< Span of readings in SI units, from INFO SPAN
+		uint8_t width; ///< Number of characters used to display readings, from INFO FORMAT
+		uint8_t decimals; ///< Number of decimals used to display readings, from INFO FORMAT
+	};
+
+	/**
+	 * Everything known about the sensor on a port.
+	 */
+	struct SensorInfo {
+		ModeInfo modes[Descriptor::MODES_MAX]; ///< Data formats, indexed by mode
+		uint8_t type; ///< Sensor type index, from CMD TYPE
+		uint8_t mode_count; ///< Number of modes, from CMD MODES
+		uint8_t modes_visible; ///< Number of modes visible to the user, from CMD MODES
+		uint8_t received; ///< Parts of the handshake received so far, see SensorRegistry::receive()
+		uint32_t speed; ///< Maximum baudrate, from CMD SPEED
+		bool complete; ///< Whether the complete handshake, up to SYS ACK, was received
+		ModeDetails details[Descriptor::MODES_MAX]; ///< Remaining properties, indexed by mode
+
+		/**
+		 * Describes the sensor as it described itself, e.g. to emulate it,
+		 * or to frame its handshake again.
+		 *
+		 * @param table receives the descriptions of all modes, which refer to
+		 * the names and symbols in \c details
+		 * @return sensor description, referring to \c table
+		 */
+		Descriptor::SensorDescriptor descriptor(
+				Descriptor::ModeDescriptor (&table)[Descriptor::MODES_MAX]) const;
+	};
+
+	/**
+	 * Sensor information for a number of ports, built from handshakes.
+	 *
+	 * The registry does not own its table.
+	 */
+	class SensorRegistry {
+	public:
+		/**
+		 * @param table one entry per port
+		 * @param ports number of ports
+		 */
+		SensorRegistry(SensorInfo* table, size_t ports);
+
+		/**
+		 * @return number of ports
+		 */
+		size_t size() const {
+			return ports;
+		}
+
+		/**
+		 * @param port port index
+		 * @return information about the sensor on the port
+		 */
+		const SensorInfo& sensor(size_t port) const {
+			return table[port];
+		}
+
+		/**
+		 * Forgets the sensor on a port, e.g. when it is disconnected.
+		 */
+		void reset(size_t port);
+
+		/**
+		 * Consumes a message of a handshake.
+		 *
+		 * \c CMD \c TYPE starts a new handshake, and so discards everything
+		 * known about the port. DATA messages, and messages sent by the EV3,
+		 * are ignored.
+		 *
+		 * @param port port index
+		 * @param frame message received from the sensor
+		 * @retval 1 if the message was \c SYS \c ACK, completing a handshake
+		 * with \c CMD \c TYPE, \c MODES, \c SPEED and an \c INFO \c FORMAT
+		 * message for every mode
+		 * @retval 0 if the message was consumed, or ignored
+		 * @retval -1 if the message is malformed, or is \c SYS \c ACK ending
+		 * an incomplete handshake
+		 */
+		int8_t receive(size_t port, const Decoding::Frame& frame);
+
+		/**
+		 * Looks up the data format of a DATA message.
+		 *
+		 * @param port port index
+		 * @param frame DATA message
+		 * @return data format of the mode of the message
+		 * @retval nullptr if the format of the mode is unknown, or the
+		 * payload of the message is too short for it
+		 */
+		const ModeInfo* lookup(size_t port, const Decoding::Frame& frame) const {
+			const ModeInfo& info { table[port].modes[frame.mode()] };
+			return ((info.sample_size != 0)
+					&& (info.payload_size <= frame.payload_size())) ? &info
+					: nullptr;
+		}
+
+		/**
+		 * Decodes the samples of a DATA message with an integer data type.
+		 *
+		 * @param samples destination, with space for
+		 * PAYLOAD_SENSOR_TO_EV3_MAX samples
+		 * @return number of samples decoded
+		 * @retval -1 if lookup() fails, or the data type is F32
+		 */
+		int8_t decode(size_t port, const Decoding::Frame& frame,
+				int32_t* samples) const;
+
+		/**
+		 * Decodes the samples of a DATA message of any data type, as single
+		 * precision floats.
+		 *
+		 * @param samples destination, with space for
+		 * PAYLOAD_SENSOR_TO_EV3_MAX samples
+		 * @return number of samples decoded
+		 * @retval -1 if lookup() fails
+		 */
+		int8_t decode(size_t port, const Decoding::Frame& frame,
+				float* samples) const;
+
+	private:
+		SensorInfo* const table;
+		const size_t ports;
+	};
+}
+}
+
+#endif /* SENSOR_REGISTRY_HPP_ */
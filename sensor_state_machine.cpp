@@ -0,0 +1,136 @@
+/**
+ * \file sensor_state_machine.cpp
+ *
+ * Function definitions for functions in \ref sensor_state_machine.hpp
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <sensor_state_machine.hpp>
+
+namespace EV3UartGenerator {
+namespace StateMachine {
+	namespace {
+		/**
+		 * Compares timestamps, allowing for wraparound of the clock.
+		 */
+		inline bool reached(uint32_t now, uint32_t deadline) {
+			return (static_cast<int32_t>(now - deadline) >= 0);
+		}
+	}
+
+	SensorStateMachine::SensorStateMachine(SensorIo& io,
+			const Descriptor::SensorDescriptor& sensor,
+			const uint8_t* handshake, size_t handshake_len,
+			const Timing& timing)
+		: io(io), sensor(sensor), handshake { handshake },
+		  handshake_len { handshake_len }, timing(timing),
+		  current_state { State::IDLE }, current_mode { 0 },
+		  retry_deadline { 0 }, keepalive_deadline { 0 }, data_deadline { 0 } {
+	}
+
+	void SensorStateMachine::begin(uint32_t now) {
+		current_state = State::HANDSHAKE;
+		current_mode = 0;
+		retry_deadline = now;
+		decoder.reset();
+		io.set_baud(HANDSHAKE_BAUD);
+	}
+
+	void SensorStateMachine::receive(const uint8_t* data, size_t len,
+			uint32_t now) {
+		Decoding::Frame frame;
+		decoder.feed(data, len);
+		while (decoder.next(frame))
+			handle(frame, now);
+	}
+
+	void SensorStateMachine::handle(const Decoding::Frame& frame,
+			uint32_t now) {
+		switch (current_state) {
+		case State::WAIT_ACK:
+			if (frame.is(Magics::SYS::ACK)) {
+				io.set_baud(sensor.speed);
+				current_state = State::DATA;
+				keepalive_deadline = now + timing.keepalive_timeout;
+				data_deadline = now;
+			}
+			break;
+		case State::DATA:
+			if (frame.is(Magics::SYS::NACK)) {
+				keepalive_deadline = now + timing.keepalive_timeout;
+				send_data(); // Keepalives are answered right away
+			} else if (frame.is(Magics::CMD::SELECT)) {
+				const uint8_t mode { frame.payload()[0] };
+				if (mode < sensor.modes) {
+					current_mode = mode;
+					io.selected(mode);
+					send_data();
+					data_deadline = now + timing.data_interval;
+				}
+			} else if (frame.is(Magics::CMD::WRITE)) {
+				io.written(frame.payload(), frame.payload_size());
+			}
+			break;
+		default:
+			break; // Nothing from the EV3 is expected before the handshake
+		}
+	}
+
+	void SensorStateMachine::poll(uint32_t now) {
+		switch (current_state) {
+		case State::HANDSHAKE:
+			send_handshake(now);
+			break;
+		case State::WAIT_ACK:
+			if (reached(now, retry_deadline))
+				send_handshake(now);
+			break;
+		case State::DATA:
+			if (reached(now, keepalive_deadline)) {
+				begin(now); // EV3 is gone - start over
+				send_handshake(now);
+			} else if (reached(now, data_deadline)) {
+				send_data();
+				data_deadline += timing.data_interval;
+				if (reached(now, data_deadline)) // Don't burst after stalls
+					data_deadline = now + timing.data_interval;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	uint32_t SensorStateMachine::next_deadline() const {
+		switch (current_state) {
+		case State::HANDSHAKE:
+		case State::WAIT_ACK:
+			return retry_deadline;
+		case State::DATA:
+			return (static_cast<int32_t>(data_deadline - keepalive_deadline) < 0)
+					? data_deadline : keepalive_deadline;
+		default:
+			return retry_deadline;
+		}
+	}
+
+	void SensorStateMachine::send_handshake(uint32_t now) {
+		io.write(handshake, handshake_len);
+		current_state = State::WAIT_ACK;
+		retry_deadline = now + timing.handshake_retry;
+	}
+
+	void SensorStateMachine::send_data() {
+		uint8_t payload[Framing::PAYLOAD_SENSOR_TO_EV3_MAX];
+		uint8_t message[Framing::BUFFER_MIN];
+		const uint8_t len { io.sample(current_mode, payload) };
+		const int8_t size { Framing::frame_data_message(message, current_mode,
+				payload, len) };
+		if (size > 0)
+			io.write(message, size);
+	}
+}
+}
@@ -0,0 +1,213 @@
+/**
+ * \file sensor_state_machine.hpp
+ *
+ * State machine implementing the sensor side of the EV3 UART sensor
+ * protocol.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page StateMachine
+ *
+ * Every emulated sensor goes through the same lifecycle:
+ * - send the initialization handshake at 2400 baud, repeating it until the
+ *   EV3 acknowledges it with \c SYS \c ACK
+ * - switch to the baudrate advertised in the \c CMD \c SPEED message
+ * - send \c DATA messages for the selected mode at a fixed interval
+ * - answer \c SYS \c NACK keepalives from the EV3 with a \c DATA message
+ *   immediately, and start over if the keepalives stop
+ * - honor \c CMD \c SELECT (mode changes) and \c CMD \c WRITE messages
+ *
+ * \ref EV3UartGenerator::StateMachine::SensorStateMachine implements this
+ * lifecycle without allocating memory, and without blocking. It is driven by:
+ * - bytes received from the EV3, passed to
+ *   \ref EV3UartGenerator::StateMachine::SensorStateMachine::receive()
+ * - the current time from a monotonic millisecond clock, passed to
+ *   \ref EV3UartGenerator::StateMachine::SensorStateMachine::poll()
+ *
+ * \ref EV3UartGenerator::StateMachine::SensorStateMachine::next_deadline()
+ * returns the time at which \c poll() has to be called next, so that the
+ * caller can sleep (or wait for bytes) until then, instead of polling in
+ * a loop.
+ *
+ * Bytes are written, baudrates changed and samples obtained through
+ * the \ref EV3UartGenerator::StateMachine::SensorIo interface, implemented
+ * by the user.
+ *
+ * The state machine is declared in the file \ref sensor_state_machine.hpp
+ */
+
+#ifndef SENSOR_STATE_MACHINE_HPP_
+#define SENSOR_STATE_MACHINE_HPP_
+
+#include <decoding.hpp>
+#include <sensor_descriptor.hpp>
+#include <framing.hpp>
+#include <stddef.h> // We can't include <cstddef> if we want to compile under Arduino
+
+namespace EV3UartGenerator {
+namespace StateMachine {
+	constexpr uint32_t HANDSHAKE_BAUD { 2400 }; ///< Baudrate used by the EV3 and sensors before the handshake completes
+
+	/**
+	 * Timing parameters of the state machine, in milliseconds.
+	 */
+	struct Timing {
+		uint16_t handshake_retry; ///< Time to wait for \c SYS \c ACK before sending the handshake again
+		uint16_t keepalive_timeout; ///< Time without \c SYS \c NACK from the EV3 before starting over
+		uint16_t data_interval; ///< Time between \c DATA messages
+	};
+
+	constexpr Timing DEFAULT_TIMING { 500, 1000, 10 }; ///< Default timing parameters
+
+	/**
+	 * States of the state machine.
+	 */
+	enum class State : uint8_t {
+		IDLE,		///< begin() has not been called yet
+		HANDSHAKE,	///< Handshake is due to be sent
+		WAIT_ACK,	///< Handshake has been sent, waiting for \c SYS \c ACK
+		DATA,		///< Handshake complete, sending \c DATA messages
+	};
+
+	/**
+	 * Interface between the state machine and the sensor, implemented
+	 * by the user.
+	 */
+	class SensorIo {
+	public:
+		/**
+		 * Writes bytes to the EV3.
+		 *
+		 * @param buf bytes to write
+		 * @param len number of bytes to write
+		 */
+		virtual void write(const uint8_t* buf, size_t len) = 0;
+
+		/**
+		 * Changes the baudrate of the UART.
+		 *
+		 * @param baud new baudrate
+		 */
+		virtual void set_baud(uint32_t baud) = 0;
+
+		/**
+		 * Obtains the payload of the next \c DATA message.
+		 *
+		 * @param mode mode index of the currently selected mode
+		 * @param payload destination, with space for
+		 * PAYLOAD_SENSOR_TO_EV3_MAX bytes
+		 * @return length of the payload
+		 * [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX], or 0 to skip this
+		 * \c DATA message
+		 */
+		virtual uint8_t sample(uint8_t mode, uint8_t* payload) = 0;
+
+		/**
+		 * Called when the EV3 selects a mode with \c CMD \c SELECT.
+		 *
+		 * @param mode mode index of the newly selected mode
+		 */
+		virtual void selected(uint8_t /* mode */) {
+		}
+
+		/**
+		 * Called when the EV3 writes data to the sensor with \c CMD \c WRITE.
+		 *
+		 * @param data data written, including padding
+		 * @param len length of data
+		 */
+		virtual void written(const uint8_t* /* data */, uint8_t /* len */) {
+		}
+
+	protected:
+		~SensorIo() = default;
+	};
+
+	/**
+	 * Sensor side protocol state machine.
+	 */
+	class SensorStateMachine {
+	public:
+		/**
+		 * @param io interface to the sensor
+		 * @param sensor sensor description, used to validate mode selections
+		 * and to obtain the negotiated baudrate
+		 * @param handshake framed handshake, as produced by
+		 * Descriptor::frame_handshake() or StaticFraming::handshake(). Must
+		 * remain valid for the lifetime of the state machine.
+		 * @param handshake_len length of the framed handshake
+		 * @param timing timing parameters
+		 */
+		SensorStateMachine(SensorIo& io,
+				const Descriptor::SensorDescriptor& sensor,
+				const uint8_t* handshake, size_t handshake_len,
+				const Timing& timing = DEFAULT_TIMING);
+
+		/**
+		 * Starts (or restarts) the handshake, at the next call to poll().
+		 *
+		 * @param now current time
+		 */
+		void begin(uint32_t now);
+
+		/**
+		 * Processes bytes received from the EV3.
+		 *
+		 * @param data bytes received
+		 * @param len number of bytes received
+		 * @param now current time
+		 */
+		void receive(const uint8_t* data, size_t len, uint32_t now);
+
+		/**
+		 * Processes timed events - sends (and re-sends) the handshake, sends
+		 * \c DATA messages, and detects keepalive timeouts.
+		 *
+		 * @param now current time
+		 */
+		void poll(uint32_t now);
+
+		/**
+		 * @return time at which poll() has to be called next
+		 */
+		uint32_t next_deadline() const;
+
+		/**
+		 * @return current state
+		 */
+		State state() const {
+			return current_state;
+		}
+
+		/**
+		 * @return currently selected mode index
+		 */
+		uint8_t mode() const {
+			return current_mode;
+		}
+
+	private:
+		void send_handshake(uint32_t now);
+		void send_data();
+		void handle(const Decoding::Frame& frame, uint32_t now);
+
+		SensorIo& io;
+		const Descriptor::SensorDescriptor& sensor;
+		const uint8_t* const handshake;
+		const size_t handshake_len;
+		const Timing timing;
+		Decoding::FrameDecoder decoder;
+		State current_state;
+		uint8_t current_mode;
+		uint32_t retry_deadline;
+		uint32_t keepalive_deadline;
+		uint32_t data_deadline;
+	};
+}
+}
+
+#endif /* SENSOR_STATE_MACHINE_HPP_ */
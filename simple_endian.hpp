@@ -4,6 +4,22 @@
  * Contains simple endianess conversion functions necessary for the EV3
  * UART sensor protocol library.
  *
+ * All multi-byte values in the protocol (speeds, spans and \c DATA samples)
+ * are little-endian. Values are converted with:
+ * - \c to_le16(), \c from_le16(), \c to_le32(), \c from_le32(): conversion
+ *   of integers between host and little-endian byte order, also available
+ *   under the \c <endian.h> names \c htole16(), \c le16toh(), \c htole32()
+ *   and \c le32toh()
+ * - \c store_le16(), \c store_le32(), \c store_le_f32() and their \c load_
+ *   counterparts: conversion to / from bytes at possibly unaligned addresses
+ * - \c store_le() and \c load_le(): conversion of whole arrays of samples,
+ *   which are plain copies on little-endian hosts, and loops without
+ *   dependencies between iterations (vectorized into byte shuffles by the
+ *   compiler) on big-endian hosts
+ *
+ * Everything is defined inline, so the header can be included from any
+ * number of translation units.
+ *
  * \copyright Shenghao Yang, 2018
  *
  * See LICENSE for more details
@@ -13,25 +29,213 @@
 #define SIMPLE_ENDIAN_HPP
 
 #include <stdint.h> // We can't include <cstdint> if we want to compile under Arduino
+#include <stddef.h> // We can't include <cstddef> if we want to compile under Arduino
+#include <string.h> // Need to include bare string.h for compatibility with Arduino platforms
 
 #ifndef __BYTE_ORDER__
 #error "__BYTE_ORDER__ is not defined by your system - are you compiling under GCC?"
 #endif
 
+#if (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__) \
+	&& (__BYTE_ORDER__ != __ORDER_BIG_ENDIAN__) \
+	&& (__BYTE_ORDER__ != __ORDER_PDP_ENDIAN__)
+#error "__BYTE_ORDER__ currently defined is not supported - please submit a bug report"
+#endif
+
 namespace EV3UartGenerator {
 namespace SimpleEndian {
-uint32_t htole32(uint32_t host_32bits) {
+	/**
+	 * @param host_16bits value in host byte order
+	 * @return value in little-endian byte order
+	 */
+	constexpr uint16_t to_le16(uint16_t host_16bits) {
+#if (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		return __builtin_bswap16(host_16bits);
+#else
+		return host_16bits; // PDP-endian 16-bit words are little-endian
+#endif
+	}
+
+	/**
+	 * @param le_16bits value in little-endian byte order
+	 * @return value in host byte order
+	 */
+	constexpr uint16_t from_le16(uint16_t le_16bits) {
+		return to_le16(le_16bits); // Swapping is its own inverse
+	}
+
+	/**
+	 * @param host_32bits value in host byte order
+	 * @return value in little-endian byte order
+	 */
+	constexpr uint32_t to_le32(uint32_t host_32bits) {
 #if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-	return host_32bits;
+		return host_32bits;
 #elif (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
-	return __builtin_bswap32(host_32bits);
-#elif (__BYTE_ORDER__ == __ORDER_PDP_ENDIAN__)
-	return (((host_32bits & 0xffff0000) >> 0x10) | ((host_32bits & 0x0000ffff) << 0x10));
-#elif 1
-#error "__BYTE_ORDER__ currently defined is not supported - please submit a bug report"
+		return __builtin_bswap32(host_32bits);
+#else
+		return (((host_32bits & 0xffff0000) >> 0x10) | ((host_32bits & 0x0000ffff) << 0x10));
 #endif
-}
+	}
+
+	/**
+	 * @param le_32bits value in little-endian byte order
+	 * @return value in host byte order
+	 */
+	constexpr uint32_t from_le32(uint32_t le_32bits) {
+		return to_le32(le_32bits); // Swapping is its own inverse
+	}
+
+	/*
+	 * Names following <endian.h>. The C library may define these as macros,
+	 * so the names are parenthesized to keep them from being expanded here -
+	 * callers which also include <endian.h> have to do the same, or use the
+	 * names above.
+	 */
+	/// \copydoc to_le16()
+	constexpr uint16_t (htole16)(uint16_t host_16bits) {
+		return to_le16(host_16bits);
+	}
+
+	/// \copydoc from_le16()
+	constexpr uint16_t (le16toh)(uint16_t le_16bits) {
+		return from_le16(le_16bits);
+	}
+
+	/// \copydoc to_le32()
+	constexpr uint32_t (htole32)(uint32_t host_32bits) {
+		return to_le32(host_32bits);
+	}
+
+	/// \copydoc from_le32()
+	constexpr uint32_t (le32toh)(uint32_t le_32bits) {
+		return from_le32(le_32bits);
+	}
+
+	/**
+	 * Writes a 16-bit value as 2 little-endian bytes.
+	 */
+	inline void store_le16(uint8_t* dest, uint16_t value) {
+		const uint16_t le { to_le16(value) };
+		memcpy(dest, &le, sizeof(le));
+	}
+
+	/**
+	 * Writes a 32-bit value as 4 little-endian bytes.
+	 */
+	inline void store_le32(uint8_t* dest, uint32_t value) {
+		const uint32_t le { to_le32(value) };
+		memcpy(dest, &le, sizeof(le));
+	}
+
+	/**
+	 * Writes a single precision float as 4 little-endian bytes.
+	 */
+	inline void store_le_f32(uint8_t* dest, float value) {
+		static_assert(sizeof(float) == sizeof(uint32_t),
+				"float must be IEEE 754 single precision");
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		store_le32(dest, bits);
+	}
+
+	/**
+	 * @return 16-bit value read from 2 little-endian bytes
+	 */
+	inline uint16_t load_le16(const uint8_t* src) {
+		uint16_t le;
+		memcpy(&le, src, sizeof(le));
+		return from_le16(le);
+	}
+
+	/**
+	 * @return 32-bit value read from 4 little-endian bytes
+	 */
+	inline uint32_t load_le32(const uint8_t* src) {
+		uint32_t le;
+		memcpy(&le, src, sizeof(le));
+		return from_le32(le);
+	}
+
+	/**
+	 * @return single precision float read from 4 little-endian bytes
+	 */
+	inline float load_le_f32(const uint8_t* src) {
+		static_assert(sizeof(float) == sizeof(uint32_t),
+				"float must be IEEE 754 single precision");
+		const uint32_t bits { load_le32(src) };
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	namespace Detail {
+		/**
+		 * Unsigned integer type holding the bits of a sample.
+		 */
+		template <size_t SIZE> struct Bits;
+		template <> struct Bits<1> { typedef uint8_t type; };
+		template <> struct Bits<2> { typedef uint16_t type; };
+		template <> struct Bits<4> { typedef uint32_t type; };
+
+		constexpr uint8_t swap(uint8_t bits) {
+			return bits;
+		}
+
+		constexpr uint16_t swap(uint16_t bits) {
+			return to_le16(bits);
+		}
+
+		constexpr uint32_t swap(uint32_t bits) {
+			return to_le32(bits);
+		}
+	}
+
+	/**
+	 * Writes an array of samples as little-endian bytes.
+	 *
+	 * @param dest destination, with space for <tt>count * sizeof(T)</tt> bytes
+	 * @param src samples of type \c int8_t, \c uint8_t, \c int16_t,
+	 * \c uint16_t, \c int32_t, \c uint32_t or \c float
+	 * @param count number of samples
+	 */
+	template <typename T>
+	inline void store_le(uint8_t* dest, const T* src, size_t count) {
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+		memcpy(dest, src, count * sizeof(T));
+#else
+		typedef typename Detail::Bits<sizeof(T)>::type Bits;
+		for (size_t i = 0; i < count; i++) {
+			Bits bits;
+			memcpy(&bits, &src[i], sizeof(bits));
+			bits = Detail::swap(bits);
+			memcpy(dest + (i * sizeof(bits)), &bits, sizeof(bits));
+		}
+#endif
+	}
+
+	/**
+	 * Reads an array of samples from little-endian bytes.
+	 *
+	 * @param dest destination samples, of the types accepted by store_le()
+	 * @param src source, holding <tt>count * sizeof(T)</tt> bytes
+	 * @param count number of samples
+	 */
+	template <typename T>
+	inline void load_le(T* dest, const uint8_t* src, size_t count) {
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+		memcpy(dest, src, count * sizeof(T));
+#else
+		typedef typename Detail::Bits<sizeof(T)>::type Bits;
+		for (size_t i = 0; i < count; i++) {
+			Bits bits;
+			memcpy(&bits, src + (i * sizeof(bits)), sizeof(bits));
+			bits = Detail::swap(bits);
+			memcpy(&dest[i], &bits, sizeof(bits));
+		}
+#endif
+	}
 }
 }
 
-#endif /* SIMPLE_ENDAIN_HPP */
+#endif /* SIMPLE_ENDIAN_HPP */
@@ -0,0 +1,369 @@
+/**
+ * \file static_framing.hpp
+ *
+ * Functions that help to create buffers of data that can be sent directly
+ * to the EV3, at compile time.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+/**
+ * \page StaticFraming
+ *
+ * For sensors with fixed descriptions, the messages making up the
+ * initialization handshake never change. The library includes \c constexpr
+ * counterparts of the framing functions in \ref Framing that can be
+ * evaluated at compile time, so that the whole handshake can be placed
+ * in read-only memory, instead of being framed on every boot.
+ *
+ * Each \c constexpr framing function returns a
+ * \ref EV3UartGenerator::StaticFraming::Message, with the size of the message
+ * encoded in its type. Messages are concatenated into a \c std::array by
+ * \ref EV3UartGenerator::StaticFraming::handshake():
+ *
+ * \code
+ * using namespace EV3UartGenerator;
+ * static constexpr auto color_sensor = StaticFraming::handshake(
+ *     StaticFraming::cmd_type(0x1d),
+ *     StaticFraming::cmd_modes(0x05, 0x02),
+ *     StaticFraming::cmd_speed(57600),
+ *     StaticFraming::info_name(5, "COL-CAL"),
+ *     ...
+ *     StaticFraming::sys(Magics::SYS::ACK));
+ * \endcode
+ *
+ * Mode names and symbols are passed as string literals, and their lengths
+ * are checked at compile time.
+ *
+ * The functions are declared in the file \ref static_framing.hpp
+ *
+ * \note This header requires C++14, and a standard library providing
+ * \c std::array.
+ * \warning Floating point span values are converted to their IEEE single
+ * precision representation at compile time, independent of the
+ * representation used by the target.
+ */
+
+#ifndef STATIC_FRAMING_HPP_
+#define STATIC_FRAMING_HPP_
+
+#if (__cplusplus < 201402L)
+#error "static_framing.hpp requires C++14 or later"
+#endif
+
+#include <framing.hpp>
+#include <magics.hpp>
+#include <stddef.h>
+#include <array>
+#include <utility>
+
+namespace EV3UartGenerator {
+namespace StaticFraming {
+	/**
+	 * A framed message of \c N bytes.
+	 */
+	template <size_t N>
+	struct Message {
+		static constexpr size_t size { N }; ///< Size of the framed message, in bytes
+		uint8_t bytes[N]; ///< Bytes of the framed message
+	};
+
+	/**
+	 * \c constexpr counterpart of Framing::checksum().
+	 *
+	 * @param buf source buffer
+	 * @param len length of data message in the source buffer
+	 * @return checksum of \c len bytes of data in the source buffer
+	 */
+	constexpr uint8_t checksum(const uint8_t* buf, const size_t len) {
+		uint8_t acc { 0xff };
+		for (size_t i = 0; i < len; i++)
+			acc ^= buf[i];
+		return acc;
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::insert_padding().
+	 *
+	 * @param dest address of the byte right after the end of the
+	 * payload segment
+	 * @param len length of payload segment
+	 * [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 * @return number of padding bytes written
+	 */
+	constexpr uint8_t insert_padding(uint8_t* dest, const uint8_t len) {
+		const uint8_t padding {
+			static_cast<uint8_t>((0x01 << Framing::log2(len)) - len) };
+		for (uint8_t i = 0; i < padding; i++)
+			dest[i] = 0x00;
+		return padding;
+	}
+
+	/**
+	 * Calculates the IEEE single precision representation of a finite
+	 * floating point value.
+	 *
+	 * @param value value to convert
+	 * @return bits of the IEEE single precision representation of \c value
+	 *
+	 * @note negative zero is converted to positive zero, and NaNs are
+	 * converted to the canonical quiet NaN.
+	 */
+	constexpr uint32_t float_bits(float value) {
+		if (value != value)
+			return 0x7fc00000;
+		const uint32_t sign { value < 0.0f ? 0x80000000u : 0x00u };
+		if (value < 0.0f)
+			value = -value;
+		if (value == 0.0f)
+			return 0x00;
+		if (value > __FLT_MAX__)
+			return (sign | 0x7f800000);
+
+		int16_t exponent { 0 };
+		while (value >= 2.0f) {
+			value /= 2.0f;
+			exponent++;
+		}
+		while ((value < 1.0f) && (exponent > -126)) {
+			value *= 2.0f;
+			exponent--;
+		}
+
+		if (value < 1.0f) // Subnormal
+			return (sign | static_cast<uint32_t>(value * 8388608.0f));
+		return (sign | (static_cast<uint32_t>(exponent + 127) << 23)
+				| static_cast<uint32_t>((value - 1.0f) * 8388608.0f));
+	}
+
+	/**
+	 * Calculates the size of a message containing a payload of \c len
+	 * bytes, excluding the message type byte, checksum and any other
+	 * header bytes.
+	 *
+	 * @param len length of the payload
+	 * [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 * @return length of the payload, after padding
+	 */
+	constexpr uint8_t padded_length(const uint8_t len) {
+		return (0x01 << Framing::log2(len));
+	}
+
+	namespace Detail {
+		template <size_t N>
+		constexpr void seal(Message<N>& msg) {
+			msg.bytes[N - 1] = checksum(msg.bytes, N - 1);
+		}
+
+		constexpr void put_le32(uint8_t* dest, const uint32_t val) {
+			dest[0] = static_cast<uint8_t>(val);
+			dest[1] = static_cast<uint8_t>(val >> 0x08);
+			dest[2] = static_cast<uint8_t>(val >> 0x10);
+			dest[3] = static_cast<uint8_t>(val >> 0x18);
+		}
+
+		template <size_t N, size_t M>
+		constexpr void append(Message<N>& dest, size_t& pos,
+				const Message<M>& src) {
+			for (size_t i = 0; i < M; i++)
+				dest.bytes[pos++] = src.bytes[i];
+		}
+
+		template <size_t N, size_t... I>
+		constexpr std::array<uint8_t, N> to_array(const Message<N>& msg,
+				std::index_sequence<I...>) {
+			return {{ msg.bytes[I]... }};
+		}
+
+		constexpr size_t sum() {
+			return 0;
+		}
+
+		template <typename... T>
+		constexpr size_t sum(size_t first, T... rest) {
+			return first + sum(rest...);
+		}
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::frame_sys_message().
+	 *
+	 * @param sys_type type of the system message
+	 * @return framed message
+	 */
+	constexpr Message<1> sys(Magics::SYS sys_type) {
+		return {{ static_cast<uint8_t>(static_cast<uint8_t>(sys_type)
+				| static_cast<uint8_t>(Magics::SYS::SYS_BASE)) }};
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::frame_cmd_type_message().
+	 *
+	 * @param type sensor type index [0, 255]
+	 * @return framed message
+	 */
+	constexpr Message<3> cmd_type(const uint8_t type) {
+		Message<3> msg {{ static_cast<uint8_t>(
+				static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+				| static_cast<uint8_t>(Magics::CMD::TYPE)
+				| Framing::length_code(0x01)), type }};
+		Detail::seal(msg);
+		return msg;
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::frame_cmd_modes_message().
+	 *
+	 * @param modes upper bound of sensor modes in sensor mode set [0, 7]
+	 * @param modes_visible upper bound of sensor modes in the set of sensor
+	 * modes visible [0, 7] to the user
+	 * @return framed message
+	 */
+	constexpr Message<4> cmd_modes(const uint8_t modes,
+			const uint8_t modes_visible) {
+		Message<4> msg {{ static_cast<uint8_t>(
+				static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+				| static_cast<uint8_t>(Magics::CMD::MODES)
+				| Framing::length_code(0x02)),
+				static_cast<uint8_t>(0x07 & modes),
+				static_cast<uint8_t>(0x07 & modes_visible) }};
+		Detail::seal(msg);
+		return msg;
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::frame_cmd_speed_message().
+	 *
+	 * @param speed maximum baudrate supported by the device.
+	 * @return framed message
+	 */
+	constexpr Message<6> cmd_speed(const uint32_t speed) {
+		Message<6> msg {{ static_cast<uint8_t>(
+				static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+				| static_cast<uint8_t>(Magics::CMD::SPEED)
+				| Framing::length_code(0x04)) }};
+		Detail::put_le32(msg.bytes + 1, speed);
+		Detail::seal(msg);
+		return msg;
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::frame_info_message_name().
+	 *
+	 * @param mode mode index [0, 7]
+	 * @param name mode name, a string literal with length (not inclusive
+	 * of null byte) in range [PAYLOAD_MIN, PAYLOAD_SENSOR_TO_EV3_MAX]
+	 * @return framed message
+	 */
+	template <size_t L>
+	constexpr Message<0x03 + padded_length(L - 1)> info_name(
+			const uint8_t mode, const char (&name)[L]) {
+		static_assert(((L - 1) >= Framing::PAYLOAD_MIN) &&
+				((L - 1) <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX),
+				"Name length doesn't fall into limits");
+		constexpr size_t N { 0x03 + padded_length(L - 1) };
+		Message<N> msg {{ static_cast<uint8_t>(
+				static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+				| (0x07 & mode)
+				| Framing::length_code(L - 1)), 0x00 }};
+		for (size_t i = 0; i < (L - 1); i++)
+			msg.bytes[0x02 + i] = static_cast<uint8_t>(name[i]);
+		insert_padding(msg.bytes + 0x02 + (L - 1), L - 1);
+		Detail::seal(msg);
+		return msg;
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::frame_info_message_span().
+	 *
+	 * @param mode mode index [0, 7]
+	 * @param span_type type of span for which information is to be sent for
+	 * @param lower lower bound of the span
+	 * @param upper upper bound of the span
+	 * @return framed message
+	 */
+	constexpr Message<11> info_span(const uint8_t mode,
+			Magics::INFO_SPAN span_type, const float lower, const float upper) {
+		Message<11> msg {{ static_cast<uint8_t>(
+				static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+				| (0x07 & mode)
+				| Framing::length_code(0x08)),
+				static_cast<uint8_t>(span_type) }};
+		Detail::put_le32(msg.bytes + 0x02, float_bits(lower));
+		Detail::put_le32(msg.bytes + 0x06, float_bits(upper));
+		Detail::seal(msg);
+		return msg;
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::frame_info_message_symbol().
+	 *
+	 * @param mode mode index [0, 7]
+	 * @param symbol symbol text representation, a string literal with
+	 * length (not inclusive of null byte) in range [PAYLOAD_MIN, SYMBOL_MAX]
+	 * @return framed message
+	 */
+	template <size_t L>
+	constexpr Message<11> info_symbol(const uint8_t mode,
+			const char (&symbol)[L]) {
+		static_assert(((L - 1) >= Framing::PAYLOAD_MIN) &&
+				((L - 1) <= Framing::SYMBOL_MAX),
+				"Symbol length doesn't fall into limits");
+		Message<11> msg {{ static_cast<uint8_t>(
+				static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+				| (0x07 & mode)
+				| Framing::length_code(0x08)), 0x04 }}; // Length hardcoded to 8
+		for (size_t i = 0; i < (L - 1); i++)
+			msg.bytes[0x02 + i] = static_cast<uint8_t>(symbol[i]);
+		Detail::seal(msg);
+		return msg;
+	}
+
+	/**
+	 * \c constexpr counterpart of Framing::frame_info_message_format().
+	 *
+	 * @param mode mode index [0, 7]
+	 * @param elems number of data elements in a DATA message
+	 * @param data_type type of data elements
+	 * @param width number of characters used to display readings [0, 15]
+	 * @param decimals number of characters after the decimal place [0, 15]
+	 * @return framed message
+	 */
+	constexpr Message<7> info_format(const uint8_t mode, const uint8_t elems,
+			Magics::INFO_DTYPE data_type, const uint8_t width,
+			const uint8_t decimals) {
+		Message<7> msg {{ static_cast<uint8_t>(
+				static_cast<uint8_t>(Magics::INFO::INFO_BASE)
+				| (0x07 & mode)
+				| Framing::length_code(0x04)), 0x80,
+				static_cast<uint8_t>(0x3f & elems),
+				static_cast<uint8_t>(0x03 & static_cast<uint8_t>(data_type)),
+				static_cast<uint8_t>(0x0f & width),
+				static_cast<uint8_t>(0x0f & decimals) }};
+		Detail::seal(msg);
+		return msg;
+	}
+
+	/**
+	 * Concatenates framed messages into a single buffer, in the order
+	 * given.
+	 *
+	 * @param msgs messages to concatenate
+	 * @return buffer containing all bytes of all messages
+	 */
+	template <size_t... N>
+	constexpr std::array<uint8_t, Detail::sum(N...)> handshake(
+			const Message<N>&... msgs) {
+		constexpr size_t total { Detail::sum(N...) };
+		Message<total> all {};
+		size_t pos { 0 };
+		const int expand[] { 0, (Detail::append(all, pos, msgs), 0)... };
+		static_cast<void>(expand);
+		return Detail::to_array(all, std::make_index_sequence<total>());
+	}
+}
+}
+
+#endif /* STATIC_FRAMING_HPP_ */
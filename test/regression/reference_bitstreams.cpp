@@ -0,0 +1,231 @@
+/**
+ * \file reference_bitstreams.cpp
+ *
+ * Regression harness, comparing the handshakes framed for the sensors in
+ * \ref lego_sensors.hpp against the bitstreams captured from the real
+ * sensors, under \c doc/reference_bitstreams/
+ *
+ * Usage: <tt>reference_bitstreams [DIRECTORY]</tt>
+ *
+ * Both the framed handshake and the capture are split into messages, using
+ * the message lengths of \ref Decoding, and compared message by message.
+ * For every sensor, the first mismatching message is reported together
+ * with the field that differs, e.g.:
+ *
+ * \verbatim
+ * color: message 4 (INFO SPAN RAW, mode 5) differs in upper bound byte 1:
+ * framed 0xff, captured 0xfe
+ * \endverbatim
+ *
+ * Exits with 0 if every handshake matches its capture exactly.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <lego_sensors.hpp>
+#include <sensor_descriptor.hpp>
+#include <decoding.hpp>
+#include <magics.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	struct Reference {
+		const char* sensor; ///< Name, for LegoSensors::find()
+		const char* capture; ///< Capture file, relative to the directory
+	};
+
+	constexpr Reference REFERENCES[] {
+		{ "color", "EV3ColorSensor_Initialization_FromSensor.bin" },
+		{ "gyro", "EV3GyroSensor_Initialization_FromSensor.bin" },
+		{ "ultrasonic", "EV3UltrasonicSensor_Initialization_FromSensor.bin" },
+	};
+
+	/**
+	 * Splits a bitstream into messages, by the length given in their
+	 * message type bytes. Checksums are not verified, so that a corrupted
+	 * message is still compared field by field.
+	 *
+	 * @param rest receives the offset of the first byte that does not
+	 * start a complete message, or the size of the bitstream
+	 */
+	std::vector<std::vector<uint8_t>> split(const std::vector<uint8_t>& stream,
+			size_t& rest) {
+		std::vector<std::vector<uint8_t>> messages;
+		rest = 0;
+		while (rest < stream.size()) {
+			const uint8_t size { Decoding::frame_size(stream[rest]) };
+			if ((size == 0) || (size > (stream.size() - rest)))
+				break;
+			messages.emplace_back(stream.begin() + rest,
+					stream.begin() + rest + size);
+			rest += size;
+		}
+		return messages;
+	}
+
+	/**
+	 * @return human readable kind of a message, e.g. "INFO SPAN RAW, mode 4"
+	 */
+	std::string describe(const std::vector<uint8_t>& message) {
+		const Decoding::Frame frame { message.data(),
+			static_cast<uint8_t>(message.size()) };
+		static const char* const CMDS[] { "TYPE", "MODES", "SPEED", "SELECT",
+			"WRITE" };
+		static const char* const SYSS[] { "SYNC", "?", "NACK", "?", "ACK", "?",
+			"ESC", "?" };
+		char text[0x40];
+		if (frame.is_info()) {
+			const uint8_t info { frame.info_type() };
+			const char* kind { "?" };
+			switch (info & ~0x20) { // 0x20 marks modes 8 and above
+			case 0x00: kind = "NAME"; break;
+			case 0x01: kind = "SPAN RAW"; break;
+			case 0x02: kind = "SPAN PCT"; break;
+			case 0x03: kind = "SPAN SI"; break;
+			case 0x04: kind = "SYMBOL"; break;
+			case 0x80: kind = "FORMAT"; break;
+			}
+			snprintf(text, sizeof(text), "INFO %s, mode %u", kind,
+					frame.mode() + ((info & 0x20) ? 8u : 0u));
+		} else if (frame.is_data()) {
+			snprintf(text, sizeof(text), "DATA, mode %u", frame.mode());
+		} else if (frame.base() == static_cast<uint8_t>(Magics::CMD::CMD_BASE)) {
+			const uint8_t cmd { frame.mode() };
+			snprintf(text, sizeof(text), "CMD %s", (cmd < 5) ? CMDS[cmd] : "?");
+		} else {
+			snprintf(text, sizeof(text), "SYS %s", SYSS[frame.type() & 0x07]);
+		}
+		return text;
+	}
+
+	/**
+	 * @return name of the field holding byte \c index of a message
+	 */
+	std::string field(const std::vector<uint8_t>& message, const size_t index) {
+		const Decoding::Frame frame { message.data(),
+			static_cast<uint8_t>(message.size()) };
+		if (index == 0)
+			return "message type byte";
+		if (index == message.size() - 1)
+			return "checksum";
+
+		const size_t offset { index - (frame.payload() - frame.data) };
+		if (frame.is_info()) {
+			if (index == 1)
+				return "INFO type byte";
+			switch (frame.info_type() & ~0x20) {
+			case 0x01:
+			case 0x02:
+			case 0x03:
+				return std::string((offset < 4) ? "lower" : "upper")
+						+ " bound byte " + std::to_string(offset % 4);
+			case 0x80: {
+				static const char* const FORMAT[] { "number of elements",
+					"data type", "width", "decimals" };
+				return (offset < 4) ? FORMAT[offset] : "padding";
+			}
+			default:
+				break;
+			}
+		} else if (frame.is(Magics::CMD::SPEED)) {
+			return "speed byte " + std::to_string(offset);
+		}
+		return "payload byte " + std::to_string(offset);
+	}
+
+	/**
+	 * Compares the handshake of a sensor against its capture.
+	 *
+	 * @return whether the handshake matches
+	 */
+	bool check(const Reference& reference, const std::string& directory) {
+		const std::string path { directory + "/" + reference.capture };
+		std::ifstream file { path, std::ios::binary };
+		if (!file) {
+			printf("%s: cannot read %s\n", reference.sensor, path.c_str());
+			return false;
+		}
+		const std::vector<uint8_t> captured_stream {
+			std::istreambuf_iterator<char>(file),
+			std::istreambuf_iterator<char>() };
+
+		const Descriptor::SensorDescriptor& sensor {
+			*LegoSensors::find(reference.sensor) };
+		std::vector<uint8_t> framed_stream(Descriptor::HANDSHAKE_MAX);
+		const int16_t size { Descriptor::frame_handshake(framed_stream.data(),
+				framed_stream.size(), sensor) };
+		if (size < 0) {
+			printf("%s: handshake could not be framed\n", reference.sensor);
+			return false;
+		}
+		framed_stream.resize(size);
+
+		size_t framed_rest, captured_rest;
+		const auto framed = split(framed_stream, framed_rest);
+		const auto captured = split(captured_stream, captured_rest);
+		if (captured_rest != captured_stream.size()) {
+			printf("%s: captured byte %zu (0x%02x) does not start a complete"
+					" message\n", reference.sensor, captured_rest,
+					captured_stream[captured_rest]);
+			return false;
+		}
+		if (framed_rest != framed_stream.size()) {
+			printf("%s: framed byte %zu (0x%02x) does not start a complete"
+					" message\n", reference.sensor, framed_rest,
+					framed_stream[framed_rest]);
+			return false;
+		}
+
+		for (size_t i = 0; (i < framed.size()) && (i < captured.size()); i++) {
+			const std::vector<uint8_t>& f { framed[i] };
+			const std::vector<uint8_t>& c { captured[i] };
+			if (f == c)
+				continue;
+			if (f.size() != c.size()) {
+				printf("%s: message %zu differs in length: framed %s (%zu"
+						" bytes), captured %s (%zu bytes)\n", reference.sensor, i,
+						describe(f).c_str(), f.size(), describe(c).c_str(),
+						c.size());
+				return false;
+			}
+			size_t byte { 0 };
+			while (f[byte] == c[byte])
+				byte++;
+			printf("%s: message %zu (%s) differs in %s: framed 0x%02x,"
+					" captured 0x%02x\n", reference.sensor, i,
+					describe(c).c_str(), field(c, byte).c_str(), f[byte],
+					c[byte]);
+			return false;
+		}
+		if (framed.size() != captured.size()) {
+			const bool extra { framed.size() > captured.size() };
+			const size_t i { extra ? captured.size() : framed.size() };
+			printf("%s: %zu framed and %zu captured messages, message %zu (%s)"
+					" is %s\n", reference.sensor, framed.size(), captured.size(),
+					i, describe(extra ? framed[i] : captured[i]).c_str(),
+					extra ? "not captured" : "missing");
+			return false;
+		}
+
+		printf("%s: %zu messages, %d bytes match\n", reference.sensor,
+				framed.size(), size);
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::string directory { (argc > 1) ? argv[1]
+			: "doc/reference_bitstreams" };
+	bool passed { true };
+	for (const Reference& reference : REFERENCES)
+		passed = check(reference, directory) && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/**
+ * \file test_checksum.cpp
+ *
+ * Tests for the checksum kernels of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <checksum.hpp>
+#include "catch.hpp"
+#include <vector>
+#include <random>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	/**
+	 * Checks \c kernel against the scalar kernel, for every length and
+	 * alignment of the source buffer up to \c max_len bytes.
+	 */
+	template <typename Kernel>
+	void check_kernel(Kernel kernel, size_t max_len) {
+		std::vector<uint8_t> buffer(max_len + 0x40);
+		std::mt19937 gen { 0x1d };
+		for (uint8_t& b : buffer)
+			b = static_cast<uint8_t>(gen());
+
+		for (size_t offset = 0; offset < 0x40; offset++) {
+			for (size_t len = 0; len <= max_len; len++) {
+				REQUIRE(kernel(buffer.data() + offset, len)
+						== Checksum::xor_reduce_scalar(buffer.data() + offset,
+								len));
+			}
+		}
+	}
+}
+
+TEST_CASE("xor_reduce_scalar() returns correct results", "[checksum]") {
+	using namespace EV3UartGenerator;
+	const uint8_t buffer[] { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x81 };
+	REQUIRE(Checksum::xor_reduce_scalar(buffer, 0) == 0x00);
+	REQUIRE(Checksum::xor_reduce_scalar(buffer, 1) == 0x01);
+	REQUIRE(Checksum::xor_reduce_scalar(buffer, 8) == 0xfe);
+}
+
+TEST_CASE("All kernels agree with the scalar kernel", "[checksum]") {
+	using namespace EV3UartGenerator;
+	INFO("xor_reduce() kernel: " << Checksum::kernel());
+
+	SECTION("words") {
+		check_kernel(Checksum::xor_reduce_words, 0x200);
+	}
+#if defined(__SSE2__)
+	SECTION("sse2") {
+		check_kernel(Checksum::xor_reduce_sse2, 0x200);
+	}
+#endif
+#if defined(__AVX2__)
+	SECTION("avx2") {
+		check_kernel(Checksum::xor_reduce_avx2, 0x200);
+	}
+#endif
+#if defined(__ARM_NEON)
+	SECTION("neon") {
+		check_kernel(Checksum::xor_reduce_neon, 0x200);
+	}
+#endif
+	SECTION("xor_reduce()") {
+		check_kernel(Checksum::xor_reduce, 0x200);
+	}
+}
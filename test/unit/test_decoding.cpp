@@ -0,0 +1,231 @@
+/**
+ * \file test_decoding.cpp
+ *
+ * Tests for the decoding portion of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <decoding.hpp>
+#include "catch.hpp"
+#include <array>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	/**
+	 * Frames one message of every type into \c stream, recording the
+	 * size of each message in \c sizes.
+	 */
+	void frame_all_messages(std::vector<uint8_t>& stream,
+			std::vector<uint8_t>& sizes) {
+		std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+		std::array<uint8_t, Framing::PAYLOAD_SENSOR_TO_EV3_MAX> payload { };
+		std::iota(payload.begin(), payload.end(), 0x40);
+
+		auto append = [&](int8_t sz) {
+			stream.insert(stream.end(), buffer.data(), buffer.data() + sz);
+			sizes.push_back(sz);
+		};
+
+		append(Framing::frame_sys_message(buffer.data(), Magics::SYS::NACK));
+		append(Framing::frame_cmd_type_message(buffer.data(), 0x1d));
+		append(Framing::frame_cmd_modes_message(buffer.data(), 5, 2));
+		append(Framing::frame_cmd_speed_message(buffer.data(), 57600));
+		append(Framing::frame_cmd_select_message(buffer.data(), 3));
+		append(Framing::frame_sys_message(buffer.data(), Magics::SYS::ACK));
+		for (uint8_t sz = Framing::PAYLOAD_MIN;
+				sz <= Framing::PAYLOAD_EV3_TO_SENSOR_MAX; sz++)
+			append(Framing::frame_cmd_write_message(buffer.data(),
+					payload.data(), sz));
+		append(Framing::frame_info_message_name(buffer.data(), 5,
+				"ABCDEFGHIJKLMNOPQRSTUVWXYZ012345"));
+		append(Framing::frame_info_message_span(buffer.data(), 4,
+				Magics::INFO_SPAN::SI, 0, 1020.188));
+		append(Framing::frame_info_message_symbol(buffer.data(), 2, "pct"));
+		append(Framing::frame_info_message_format(buffer.data(), 1, 3,
+				Magics::INFO_DTYPE::S16, 4, 0));
+		for (uint8_t sz = Framing::PAYLOAD_MIN;
+				sz <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; sz++)
+			append(Framing::frame_data_message(buffer.data(), sz & 0x07,
+					payload.data(), sz));
+	}
+
+	/**
+	 * Decodes \c stream in chunks of \c chunk_len bytes, comparing every
+	 * message against the expected message.
+	 */
+	void decode_in_chunks(const std::vector<uint8_t>& stream,
+			const std::vector<uint8_t>& sizes, size_t chunk_len) {
+		Decoding::FrameDecoder decoder;
+		Decoding::Frame frame;
+		size_t msg { 0 };
+		size_t offset { 0 };
+
+		for (size_t pos = 0; pos < stream.size(); pos += chunk_len) {
+			const size_t len { std::min(chunk_len, stream.size() - pos) };
+			decoder.feed(stream.data() + pos, len);
+			while (decoder.next(frame)) {
+				REQUIRE(msg < sizes.size());
+				REQUIRE(frame.size == sizes[msg]);
+				REQUIRE(std::equal(frame.data, frame.data + frame.size,
+						stream.data() + offset));
+				offset += sizes[msg++];
+			}
+		}
+		REQUIRE(msg == sizes.size());
+		REQUIRE(decoder.discarded() == 0);
+		REQUIRE(decoder.checksum_errors() == 0);
+	}
+}
+
+TEST_CASE("frame_size() returns correct sizes", "[decode] [frame_size()]") {
+	using namespace EV3UartGenerator;
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	std::array<uint8_t, Framing::PAYLOAD_SENSOR_TO_EV3_MAX> payload { };
+
+	SECTION("sizes of framed messages are recovered from the type byte") {
+		for (uint8_t sz = Framing::PAYLOAD_MIN;
+				sz <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; sz++) {
+			int8_t s = Framing::frame_data_message(buffer.data(), 0,
+					payload.data(), sz);
+			REQUIRE(Decoding::frame_size(buffer[0]) == s);
+			s = Framing::frame_cmd_write_message(buffer.data(),
+					payload.data(), sz);
+			REQUIRE(Decoding::frame_size(buffer[0]) == s);
+		}
+		REQUIRE(Decoding::frame_size(static_cast<uint8_t>(
+				Magics::SYS::NACK)) == 1);
+		int8_t s = Framing::frame_info_message_span(buffer.data(), 0,
+				Magics::INFO_SPAN::RAW, 0, 1);
+		REQUIRE(Decoding::frame_size(buffer[0]) == s);
+	}
+
+	SECTION("invalid type bytes are rejected") {
+		REQUIRE(Decoding::frame_size(0x01) == 0);
+		REQUIRE(Decoding::frame_size(0x08) == 0);
+		REQUIRE(Decoding::frame_size(0x45) == 0);
+		REQUIRE(Decoding::frame_size(0xf0) == 0); // 64 byte payload
+		REQUIRE(Decoding::frame_size(0xb8) == 0); // 128 byte payload
+	}
+}
+
+TEST_CASE("Framed messages are decoded", "[decode] [FrameDecoder]") {
+	using namespace EV3UartGenerator;
+	std::vector<uint8_t> stream;
+	std::vector<uint8_t> sizes;
+	frame_all_messages(stream, sizes);
+
+	SECTION("messages are decoded from a single chunk, without copies") {
+		Decoding::FrameDecoder decoder;
+		Decoding::Frame frame;
+		decoder.feed(stream.data(), stream.size());
+		const uint8_t* expected { stream.data() };
+		for (uint8_t sz : sizes) {
+			REQUIRE(decoder.next(frame));
+			REQUIRE(frame.data == expected);
+			REQUIRE(frame.size == sz);
+			expected += sz;
+		}
+		REQUIRE_FALSE(decoder.next(frame));
+	}
+
+	SECTION("messages are decoded from chunks of every size") {
+		for (size_t chunk_len = 1; chunk_len <= Framing::BUFFER_MIN + 1;
+				chunk_len++)
+			decode_in_chunks(stream, sizes, chunk_len);
+	}
+
+	SECTION("message fields are accessible through the frame") {
+		Decoding::FrameDecoder decoder;
+		Decoding::Frame frame;
+		decoder.feed(stream.data(), stream.size());
+
+		REQUIRE(decoder.next(frame));
+		REQUIRE(frame.is(Magics::SYS::NACK));
+		REQUIRE(frame.payload_size() == 0);
+		for (uint8_t i = 0; i < 4; i++)
+			REQUIRE(decoder.next(frame));
+		REQUIRE(frame.is(Magics::CMD::SELECT));
+		REQUIRE_FALSE(frame.is(Magics::CMD::WRITE));
+		REQUIRE(frame.payload()[0] == 3);
+		REQUIRE(decoder.next(frame));
+		REQUIRE(frame.is(Magics::SYS::ACK));
+		for (uint8_t i = 0; i < Framing::PAYLOAD_EV3_TO_SENSOR_MAX + 1; i++)
+			REQUIRE(decoder.next(frame));
+		REQUIRE(frame.is_info());
+		REQUIRE(frame.mode() == 5);
+		REQUIRE(frame.info_type() == 0x00);
+		REQUIRE(frame.payload_size() == 32);
+		REQUIRE(frame.payload()[0] == 'A');
+	}
+}
+
+TEST_CASE("The decoder resynchronizes on invalid data", "[decode] [FrameDecoder]") {
+	using namespace EV3UartGenerator;
+	std::vector<uint8_t> stream;
+	std::vector<uint8_t> sizes;
+	frame_all_messages(stream, sizes);
+
+	SECTION("leading garbage bytes are discarded") {
+		std::vector<uint8_t> garbage { 0x01, 0x03, 0xf8, 0x47 };
+		garbage.insert(garbage.end(), stream.begin(), stream.end());
+		for (size_t chunk_len = 1; chunk_len < 8; chunk_len++) {
+			Decoding::FrameDecoder decoder;
+			Decoding::Frame frame;
+			size_t count { 0 };
+			for (size_t pos = 0; pos < garbage.size(); pos += chunk_len) {
+				decoder.feed(garbage.data() + pos,
+						std::min(chunk_len, garbage.size() - pos));
+				while (decoder.next(frame))
+					count++;
+			}
+			REQUIRE(count == sizes.size());
+			REQUIRE(decoder.discarded() == 4);
+		}
+	}
+
+	SECTION("messages with bad checksums are discarded") {
+		// Corrupt the checksum of the CMD SPEED message
+		const size_t speed_offset { static_cast<size_t>(sizes[0]
+				+ sizes[1] + sizes[2]) };
+		stream[speed_offset + sizes[3] - 1] ^= 0x01;
+
+		for (size_t chunk_len = 1; chunk_len <= Framing::BUFFER_MIN + 1;
+				chunk_len++) {
+			Decoding::FrameDecoder decoder;
+			Decoding::Frame frame;
+			std::vector<uint8_t> decoded;
+			for (size_t pos = 0; pos < stream.size(); pos += chunk_len) {
+				decoder.feed(stream.data() + pos,
+						std::min(chunk_len, stream.size() - pos));
+				while (decoder.next(frame))
+					decoded.push_back(frame.type());
+			}
+			REQUIRE(decoder.checksum_errors() >= 1);
+			// SPEED payload bytes 0x00 0xe1 0x00 0x00 contain three SYNC
+			// bytes, which are indistinguishable from real SYNC messages.
+			REQUIRE(decoded.size() == sizes.size() - 1 + 3);
+			REQUIRE(decoded[3] == static_cast<uint8_t>(Magics::SYS::SYNC));
+			REQUIRE(decoded[6] == (static_cast<uint8_t>(Magics::CMD::CMD_BASE)
+					| static_cast<uint8_t>(Magics::CMD::SELECT)
+					| Framing::length_code(1)));
+		}
+	}
+
+	SECTION("reset() discards partial messages") {
+		Decoding::FrameDecoder decoder;
+		Decoding::Frame frame;
+		decoder.feed(stream.data() + 1, 2); // Part of CMD TYPE message
+		REQUIRE_FALSE(decoder.next(frame));
+		decoder.reset();
+		decoder.feed(stream.data() + 4, stream.size() - 4);
+		REQUIRE(decoder.next(frame));
+		REQUIRE(frame.is(Magics::CMD::MODES));
+	}
+}
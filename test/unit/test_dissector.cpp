@@ -0,0 +1,230 @@
+/**
+ * \file test_dissector.cpp
+ *
+ * Tests for the dissection portion of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <dissector.hpp>
+#include <framing.hpp>
+#include <lego_sensors.hpp>
+#include <sensor_descriptor.hpp>
+#include "catch.hpp"
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	/**
+	 * Dissects a single framed message.
+	 */
+	Dissection::Message dissect(Dissection::Dissector& dissector,
+			const uint8_t* data, int8_t size) {
+		REQUIRE(size > 0);
+		Dissection::Message message;
+		dissector.dissect(Decoding::Frame { data, static_cast<uint8_t>(size) },
+				message);
+		return message;
+	}
+
+	/**
+	 * Recomputes the checksum of a message, after its bytes were modified.
+	 */
+	void fix_checksum(uint8_t* data, int8_t size) {
+		data[size - 1] = Framing::checksum(data, size - 1);
+	}
+}
+
+TEST_CASE("SYS and CMD messages are dissected", "[dissector]") {
+	Dissection::Dissector dissector;
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	uint8_t* const dest { buffer.data() };
+	Dissection::Message m;
+
+	m = dissect(dissector, dest, Framing::frame_sys_message(dest,
+			Magics::SYS::ACK));
+	REQUIRE(std::string(m.kind) == "SYS ACK");
+	REQUIRE(m.issues == 0);
+
+	m = dissect(dissector, dest, Framing::frame_cmd_type_message(dest, 0x1d));
+	REQUIRE(std::string(m.kind) == "CMD TYPE");
+	REQUIRE(m.value == 0x1d);
+
+	m = dissect(dissector, dest, Framing::frame_cmd_modes_message(dest, 5, 2));
+	REQUIRE(std::string(m.kind) == "CMD MODES");
+	REQUIRE(m.value == 5);
+	REQUIRE(m.views == 2);
+
+	m = dissect(dissector, dest, Framing::frame_cmd_speed_message(dest, 57600));
+	REQUIRE(std::string(m.kind) == "CMD SPEED");
+	REQUIRE(m.value == 57600);
+
+	m = dissect(dissector, dest, Framing::frame_cmd_select_message(dest, 3));
+	REQUIRE(std::string(m.kind) == "CMD SELECT");
+	REQUIRE(m.mode == 3);
+	REQUIRE(m.issues == 0);
+}
+
+TEST_CASE("INFO messages are dissected", "[dissector]") {
+	Dissection::Dissector dissector;
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	uint8_t* const dest { buffer.data() };
+	Dissection::Message m;
+
+	m = dissect(dissector, dest, Framing::frame_info_message_name(dest, 5,
+			"COL-CAL"));
+	REQUIRE(std::string(m.kind) == "INFO NAME");
+	REQUIRE(m.mode == 5);
+	REQUIRE(std::string(m.text) == "COL-CAL");
+	REQUIRE(m.issues == 0);
+
+	m = dissect(dissector, dest, Framing::frame_info_message_span(dest, 4,
+			Magics::INFO_SPAN::SI, -1.5, 1020.1875));
+	REQUIRE(std::string(m.kind) == "INFO SPAN-SI");
+	REQUIRE(m.mode == 4);
+	REQUIRE(m.lower == -1.5);
+	REQUIRE(m.upper == 1020.1875);
+
+	m = dissect(dissector, dest, Framing::frame_info_message_symbol(dest, 2,
+			"pct"));
+	REQUIRE(std::string(m.kind) == "INFO SYMBOL");
+	REQUIRE(std::string(m.text) == "pct");
+
+	m = dissect(dissector, dest, Framing::frame_info_message_format(dest, 4, 3,
+			Magics::INFO_DTYPE::S16, 4, 1));
+	REQUIRE(std::string(m.kind) == "INFO FORMAT");
+	REQUIRE(m.elems == 3);
+	REQUIRE(m.data_type == Magics::INFO_DTYPE::S16);
+	REQUIRE(m.width == 4);
+	REQUIRE(m.decimals == 1);
+	REQUIRE(m.issues == 0);
+}
+
+TEST_CASE("DATA messages are dissected with the format of their mode",
+		"[dissector]") {
+	Dissection::Dissector dissector;
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	uint8_t* const dest { buffer.data() };
+	Dissection::Message m;
+
+	const int16_t samples[] { 1, -2, 300 };
+	const int8_t data_size { Framing::frame_data_samples(dest, 4, samples, 3,
+			Magics::INFO_DTYPE::S16) };
+	m = dissect(dissector, dest, data_size);
+	REQUIRE(std::string(m.kind) == "DATA");
+	REQUIRE(m.mode == 4);
+	REQUIRE(m.has(Dissection::Issue::NO_FORMAT));
+
+	dissect(dissector, dest, Framing::frame_info_message_format(dest, 4, 3,
+			Magics::INFO_DTYPE::S16, 4, 0));
+	Framing::frame_data_samples(dest, 4, samples, 3, Magics::INFO_DTYPE::S16);
+	m = dissect(dissector, dest, data_size);
+	REQUIRE(m.issues == 0);
+	REQUIRE(m.elems == 3);
+	REQUIRE(m.integer_sample(0) == 1);
+	REQUIRE(m.integer_sample(1) == -2);
+	REQUIRE(m.integer_sample(2) == 300);
+
+	SECTION("Non-zero padding is reported") {
+		dest[7] = 0x01; // Padding after the 6 bytes of samples
+		fix_checksum(dest, data_size);
+		m = dissect(dissector, dest, data_size);
+		REQUIRE(m.issues == static_cast<uint8_t>(Dissection::Issue::PADDING));
+		REQUIRE(m.integer_sample(2) == 300);
+	}
+
+	SECTION("Payloads shorter than the format are reported") {
+		const int16_t sample { 7 };
+		m = dissect(dissector, dest, Framing::frame_data_samples(dest, 4,
+				&sample, 1, Magics::INFO_DTYPE::S16));
+		REQUIRE(m.has(Dissection::Issue::LENGTH));
+		REQUIRE(m.elems == 0);
+	}
+
+	SECTION("Floating point samples are read") {
+		const float values[] { 1.5f, -0.25f };
+		dissect(dissector, dest, Framing::frame_info_message_format(dest, 1, 2,
+				Magics::INFO_DTYPE::F32, 4, 2));
+		m = dissect(dissector, dest, Framing::frame_data_samples(dest, 1,
+				values, 2, Magics::INFO_DTYPE::F32));
+		REQUIRE(m.issues == 0);
+		REQUIRE(m.float_sample(0) == 1.5f);
+		REQUIRE(m.float_sample(1) == -0.25f);
+	}
+
+	SECTION("Formats are forgotten on reset") {
+		dissector.reset();
+		m = dissect(dissector, dest, data_size);
+		REQUIRE(m.has(Dissection::Issue::NO_FORMAT));
+	}
+}
+
+TEST_CASE("Malformed INFO messages are reported", "[dissector]") {
+	Dissection::Dissector dissector;
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	uint8_t* const dest { buffer.data() };
+	Dissection::Message m;
+
+	SECTION("Bytes after the end of a name") {
+		const int8_t size { Framing::frame_info_message_name(dest, 0, "ABCDE") };
+		dest[2 + 6] = 'X';
+		fix_checksum(dest, size);
+		m = dissect(dissector, dest, size);
+		REQUIRE(std::string(m.text) == "ABCDE");
+		REQUIRE(m.issues == static_cast<uint8_t>(Dissection::Issue::PADDING));
+	}
+
+	SECTION("Unknown data types") {
+		const int8_t size { Framing::frame_info_message_format(dest, 0, 1,
+				Magics::INFO_DTYPE::S8, 3, 0) };
+		dest[3] = 0x07;
+		fix_checksum(dest, size);
+		m = dissect(dissector, dest, size);
+		REQUIRE(m.has(Dissection::Issue::VALUE));
+		REQUIRE(std::string(Dissection::data_type_name(m.data_type)) == "?");
+	}
+
+	SECTION("Unknown INFO types") {
+		const int8_t size { Framing::frame_info_message_symbol(dest, 0, "x") };
+		dest[1] = 0x10;
+		fix_checksum(dest, size);
+		m = dissect(dissector, dest, size);
+		REQUIRE(std::string(m.kind) == "INFO");
+		REQUIRE(m.has(Dissection::Issue::VALUE));
+	}
+}
+
+TEST_CASE("LEGO sensor handshakes are dissected without issues",
+		"[dissector]") {
+	for (const char* name : { "color", "ultrasonic", "gyro" }) {
+		const Descriptor::SensorDescriptor& sensor { *LegoSensors::find(name) };
+		std::vector<uint8_t> stream(Descriptor::HANDSHAKE_MAX);
+		const int16_t size { Descriptor::frame_handshake(stream.data(),
+				stream.size(), sensor) };
+		REQUIRE(size > 0);
+
+		Decoding::FrameDecoder decoder;
+		Dissection::Dissector dissector;
+		Decoding::Frame frame;
+		Dissection::Message m;
+		uint8_t names { 0 };
+		decoder.feed(stream.data(), size);
+		while (decoder.next(frame)) {
+			dissector.dissect(frame, m);
+			REQUIRE(m.issues == 0);
+			if (std::string(m.kind) == "INFO NAME") {
+				REQUIRE(std::string(m.text)
+						== sensor.mode_table[m.mode].name);
+				names++;
+			}
+		}
+		REQUIRE(names == sensor.modes);
+		REQUIRE(std::string(m.kind) == "SYS ACK");
+	}
+}
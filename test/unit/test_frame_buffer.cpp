@@ -0,0 +1,150 @@
+/**
+ * \file test_frame_buffer.cpp
+ *
+ * Tests for the bounds checked buffer and the message size functions of
+ * EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <frame_buffer.hpp>
+#include <sensor_descriptor.hpp>
+#include <lego_sensors.hpp>
+#include "catch.hpp"
+#include <array>
+#include <string>
+#include <vector>
+
+using namespace EV3UartGenerator;
+using Magics::INFO_DTYPE;
+using Magics::INFO_SPAN;
+
+static_assert(Framing::frame_size_data_message(3) == 6,
+		"Message sizes are usable in constant expressions");
+
+TEST_CASE("Message sizes match the framed messages",
+		"[frame_buffer] [frame_size]") {
+	std::array<uint8_t, Framing::BUFFER_MIN> dest { };
+	std::array<uint8_t, Framing::PAYLOAD_SENSOR_TO_EV3_MAX> payload { };
+
+	REQUIRE(Framing::frame_size_sys_message()
+			== Framing::frame_sys_message(dest.data(), Magics::SYS::ACK));
+	REQUIRE(Framing::frame_size_cmd_type_message()
+			== Framing::frame_cmd_type_message(dest.data(), 0x1d));
+	REQUIRE(Framing::frame_size_cmd_modes_message()
+			== Framing::frame_cmd_modes_message(dest.data(), 5, 2));
+	REQUIRE(Framing::frame_size_cmd_speed_message()
+			== Framing::frame_cmd_speed_message(dest.data(), 57600));
+	REQUIRE(Framing::frame_size_cmd_select_message()
+			== Framing::frame_cmd_select_message(dest.data(), 3));
+	REQUIRE(Framing::frame_size_info_message_span()
+			== Framing::frame_info_message_span(dest.data(), 0, INFO_SPAN::RAW,
+					0, 100));
+	REQUIRE(Framing::frame_size_info_message_format()
+			== Framing::frame_info_message_format(dest.data(), 0, 1,
+					INFO_DTYPE::S8, 3, 0));
+
+	for (uint8_t len = 0; len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX + 1; len++) {
+		const std::string str(len, 'A');
+		REQUIRE(Framing::frame_size_cmd_write_message(len)
+				== Framing::frame_cmd_write_message(dest.data(), payload.data(),
+						len));
+		REQUIRE(Framing::frame_size_data_message(len)
+				== Framing::frame_data_message(dest.data(), 0, payload.data(),
+						len));
+		REQUIRE(Framing::frame_size_info_message_name(len)
+				== Framing::frame_info_message_name(dest.data(), 0,
+						str.c_str()));
+		REQUIRE(Framing::frame_size_info_message_symbol(len)
+				== Framing::frame_info_message_symbol(dest.data(), 0,
+						str.c_str()));
+	}
+}
+
+TEST_CASE("Messages are appended within the capacity of a buffer",
+		"[frame_buffer] [FrameBuffer]") {
+	std::array<uint8_t, 0x20> storage { };
+	storage.fill(0xa5);
+	Framing::FrameBuffer buffer { storage.data(), 0x10 };
+	std::array<uint8_t, 0x20> expected { };
+	expected.fill(0xa5);
+
+	Framing::FrameResult result { buffer.append_cmd_type_message(0x1d) };
+	REQUIRE(result);
+	REQUIRE(result.size == 3);
+	result = buffer.append_cmd_speed_message(57600);
+	REQUIRE(result);
+	REQUIRE(result.size == 6);
+	REQUIRE(buffer.size() == 9);
+	REQUIRE(buffer.remaining() == 7);
+
+	Framing::frame_cmd_type_message(expected.data(), 0x1d);
+	Framing::frame_cmd_speed_message(expected.data() + 3, 57600);
+	REQUIRE(storage == expected);
+
+	SECTION("Messages which do not fit are not written") {
+		result = buffer.append_info_message_name(0, "COL-REFLECT");
+		REQUIRE(!result);
+		REQUIRE(result.error == Framing::FrameError::NO_SPACE);
+		REQUIRE(result.size == 0);
+		REQUIRE(buffer.size() == 9);
+		REQUIRE(storage == expected);
+
+		// An exact fit still succeeds
+		REQUIRE(buffer.append_info_message_format(0, 1, INFO_DTYPE::S8, 3, 0));
+		REQUIRE(buffer.remaining() == 0);
+		REQUIRE(buffer.append_sys_message(Magics::SYS::ACK).error
+				== Framing::FrameError::NO_SPACE);
+	}
+
+	SECTION("Invalid messages are not written") {
+		REQUIRE(buffer.append_info_message_name(0, nullptr).error
+				== Framing::FrameError::INVALID);
+		REQUIRE(buffer.append_info_message_symbol(0, "TOO-LONG-").error
+				== Framing::FrameError::INVALID);
+		REQUIRE(buffer.append_data_message(0, storage.data(), 0).error
+				== Framing::FrameError::INVALID);
+		const int16_t samples[] { 1, 2 };
+		REQUIRE(buffer.append_data_samples(0, samples, 2, INFO_DTYPE::S8).error
+				== Framing::FrameError::INVALID);
+		REQUIRE(buffer.size() == 9);
+		REQUIRE(storage == expected);
+
+		REQUIRE(buffer.append_data_samples(0, samples, 2, INFO_DTYPE::S16).size
+				== 6);
+	}
+
+	SECTION("Cleared buffers are reused from the start") {
+		buffer.clear();
+		REQUIRE(buffer.size() == 0);
+		REQUIRE(buffer.append_sys_message(Magics::SYS::ACK).size == 1);
+		REQUIRE(storage[0] == 0x04);
+	}
+}
+
+TEST_CASE("Handshakes are appended to a buffer", "[frame_buffer] [descriptor]") {
+	const int16_t size { Descriptor::handshake_size(LegoSensors::COLOR) };
+	REQUIRE(size == 311);
+
+	std::vector<uint8_t> expected(size);
+	REQUIRE(Descriptor::frame_handshake(expected.data(), expected.size(),
+			LegoSensors::COLOR) == size);
+
+	std::vector<uint8_t> storage(size + 1);
+	Framing::FrameBuffer buffer { storage.data(), storage.size() };
+	REQUIRE(buffer.append_sys_message(Magics::SYS::NACK));
+	const Framing::FrameResult result { Descriptor::frame_handshake(buffer,
+			LegoSensors::COLOR) };
+	REQUIRE(result);
+	REQUIRE(result.size == size);
+	REQUIRE(buffer.remaining() == 0);
+	REQUIRE(std::equal(expected.begin(), expected.end(), storage.begin() + 1));
+
+	REQUIRE(Descriptor::frame_handshake(buffer, LegoSensors::COLOR).error
+			== Framing::FrameError::NO_SPACE);
+	const Descriptor::SensorDescriptor invalid { 0x1d, 0, 0, 57600, nullptr };
+	REQUIRE(Descriptor::frame_handshake(buffer, invalid).error
+			== Framing::FrameError::INVALID);
+}
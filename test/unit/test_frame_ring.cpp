@@ -0,0 +1,240 @@
+/**
+ * \file test_frame_ring.cpp
+ *
+ * Tests for the Linux frame ring of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <linux/frame_ring.hpp>
+#include <decoding.hpp>
+#include <framing.hpp>
+#include "catch.hpp"
+#include <array>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	/**
+	 * Copies all bytes described by FrameRing::peek().
+	 */
+	std::vector<uint8_t> peek_bytes(const Linux::FrameRing& ring) {
+		struct iovec iov[Linux::RING_IOVECS];
+		const int segments { ring.peek(iov) };
+		std::vector<uint8_t> bytes;
+		for (int i = 0; i < segments; i++) {
+			const uint8_t* const base { static_cast<const uint8_t*>(
+					iov[i].iov_base) };
+			bytes.insert(bytes.end(), base, base + iov[i].iov_len);
+		}
+		return bytes;
+	}
+
+	/**
+	 * Frames a DATA message carrying a sequence number.
+	 */
+	int8_t frame_sequence(uint8_t* dest, uint32_t sequence) {
+		const int32_t sample { static_cast<int32_t>(sequence) };
+		return Framing::frame_data_samples(dest, sequence & 0x07, &sample, 1,
+				Magics::INFO_DTYPE::S32);
+	}
+}
+
+TEST_CASE("Frame ring capacities are rounded up", "[linux] [frame_ring]") {
+	REQUIRE(Linux::FrameRing { 0 }.capacity() == 0x40);
+	REQUIRE(Linux::FrameRing { 0x40 }.capacity() == 0x40);
+	REQUIRE(Linux::FrameRing { 0x41 }.capacity() == 0x80);
+	REQUIRE(Linux::FrameRing { 0x1000 }.capacity() == 0x1000);
+}
+
+TEST_CASE("Frame rings queue messages in order", "[linux] [frame_ring]") {
+	Linux::FrameRing ring { 0x40 };
+	struct iovec iov[Linux::RING_IOVECS];
+	REQUIRE(ring.peek(iov) == 0);
+	REQUIRE(ring.size() == 0);
+
+	std::array<uint8_t, Framing::BUFFER_MIN> ack { };
+	const int8_t ack_size { Framing::frame_sys_message(ack.data(),
+			Magics::SYS::ACK) };
+	REQUIRE(ring.push(ack.data(), ack_size));
+
+	uint8_t* const dest { ring.reserve() };
+	REQUIRE(dest != nullptr);
+	const int8_t size { Framing::frame_cmd_speed_message(dest, 57600) };
+	ring.commit(size);
+	REQUIRE(ring.size() == static_cast<size_t>(ack_size + size));
+
+	std::vector<uint8_t> expected { ack.data(), ack.data() + ack_size };
+	std::array<uint8_t, Framing::BUFFER_MIN> speed { };
+	Framing::frame_cmd_speed_message(speed.data(), 57600);
+	expected.insert(expected.end(), speed.data(), speed.data() + size);
+	REQUIRE(peek_bytes(ring) == expected);
+	REQUIRE(ring.peek(iov) == 1);
+
+	ring.consume(ack_size);
+	REQUIRE(peek_bytes(ring) == std::vector<uint8_t>(expected.begin()
+			+ ack_size, expected.end()));
+}
+
+TEST_CASE("Frame rings refuse messages when full", "[linux] [frame_ring]") {
+	Linux::FrameRing ring { 0x40 };
+	std::array<uint8_t, Framing::BUFFER_MIN> message { };
+	const int8_t size { frame_sequence(message.data(), 0) }; // 6 bytes
+	size_t pushed { 0 };
+	while (ring.push(message.data(), size))
+		pushed++;
+	// Space for BUFFER_MIN bytes is required, whatever the size of the message
+	REQUIRE(pushed == ((0x40 - Framing::BUFFER_MIN) / size) + 1);
+	REQUIRE(ring.reserve() == nullptr);
+
+	// 0x40 - (5 * 6) bytes free, 0x40 - (4 * 6) after consuming a message
+	ring.consume(size);
+	REQUIRE(ring.reserve() != nullptr);
+}
+
+TEST_CASE("Messages crossing the end of a frame ring are wrapped",
+		"[linux] [frame_ring]") {
+	Linux::FrameRing ring { 0x40 };
+	std::vector<uint8_t> expected;
+	std::vector<uint8_t> received;
+	for (uint32_t sequence = 0; sequence < 0x100; sequence++) {
+		uint8_t* const dest { ring.reserve() };
+		if (dest == nullptr) {
+			// Drain half of the ring, in two segments when it wraps
+			const std::vector<uint8_t> bytes { peek_bytes(ring) };
+			received.insert(received.end(), bytes.begin(), bytes.begin()
+					+ (bytes.size() / 2));
+			ring.consume(bytes.size() / 2);
+			sequence--;
+			continue;
+		}
+		const int8_t size { frame_sequence(dest, sequence) };
+		expected.insert(expected.end(), dest, dest + size);
+		ring.commit(size);
+	}
+	const std::vector<uint8_t> rest { peek_bytes(ring) };
+	received.insert(received.end(), rest.begin(), rest.end());
+	REQUIRE(received == expected);
+}
+
+TEST_CASE("Frame rings pass messages between threads",
+		"[linux] [frame_ring]") {
+	constexpr uint32_t MESSAGES { 100000 };
+	Linux::FrameRing ring { 0x100 };
+
+	std::thread producer { [&ring] {
+		for (uint32_t sequence = 0; sequence < MESSAGES; sequence++) {
+			uint8_t* dest;
+			while ((dest = ring.reserve()) == nullptr)
+				std::this_thread::yield();
+			ring.commit(frame_sequence(dest, sequence));
+		}
+	} };
+
+	Decoding::FrameDecoder decoder;
+	Decoding::Frame frame;
+	uint32_t next { 0 };
+	bool in_order { true };
+	while (next < MESSAGES) {
+		struct iovec iov[Linux::RING_IOVECS];
+		const int segments { ring.peek(iov) };
+		size_t len { 0 };
+		for (int i = 0; i < segments; i++) {
+			decoder.feed(static_cast<const uint8_t*>(iov[i].iov_base),
+					iov[i].iov_len);
+			len += iov[i].iov_len;
+			while (decoder.next(frame)) {
+				const int32_t sequence { static_cast<int32_t>(
+						frame.payload()[0] | (frame.payload()[1] << 8)
+						| (frame.payload()[2] << 16)
+						| (frame.payload()[3] << 24)) };
+				in_order &= (sequence == static_cast<int32_t>(next))
+						&& (frame.mode() == (next & 0x07));
+				next++;
+			}
+		}
+		ring.consume(len);
+		if (segments == 0)
+			std::this_thread::yield();
+	}
+	producer.join();
+
+	REQUIRE(in_order);
+	REQUIRE(decoder.discarded() == 0);
+	REQUIRE(decoder.checksum_errors() == 0);
+	REQUIRE(ring.size() == 0);
+}
+
+TEST_CASE("Frame rings are drained to transports", "[linux] [frame_ring]") {
+	const int master { posix_openpt(O_RDWR | O_NOCTTY) };
+	REQUIRE(master >= 0);
+	grantpt(master);
+	unlockpt(master);
+	Linux::Transport transport;
+	REQUIRE(transport.adopt(open(ptsname(master), O_RDWR | O_NOCTTY)) == 0);
+
+	Linux::FrameRing ring { 0x40 };
+	REQUIRE(ring.drain(transport) == 0);
+
+	std::vector<uint8_t> expected;
+	for (uint32_t sequence = 0; sequence < 0x20; sequence++) {
+		uint8_t* const dest { ring.reserve() };
+		if (dest == nullptr) {
+			REQUIRE(ring.drain(transport) > 0);
+			sequence--;
+			continue;
+		}
+		const int8_t size { frame_sequence(dest, sequence) };
+		expected.insert(expected.end(), dest, dest + size);
+		ring.commit(size);
+	}
+	REQUIRE(ring.drain(transport) > 0);
+	REQUIRE(ring.size() == 0);
+
+	std::vector<uint8_t> received;
+	uint8_t buf[0x100];
+	while (received.size() < expected.size()) {
+		const ssize_t got { read(master, buf, sizeof(buf)) };
+		if (got <= 0)
+			break;
+		received.insert(received.end(), buf, buf + got);
+	}
+	REQUIRE(received == expected);
+	close(master);
+}
+
+TEST_CASE("Frame rings keep only unwritten bytes on errors",
+		"[linux] [frame_ring]") {
+	const int master { posix_openpt(O_RDWR | O_NOCTTY) };
+	REQUIRE(master >= 0);
+	grantpt(master);
+	unlockpt(master);
+	Linux::Transport transport;
+	REQUIRE(transport.adopt(open(ptsname(master),
+			O_RDWR | O_NOCTTY | O_NONBLOCK)) == 0);
+
+	// More bytes than the pty buffers: the drain waits for room, and fails
+	// once the master side is closed
+	Linux::FrameRing ring { 0x40000 };
+	uint32_t sequence { 0 };
+	uint8_t* dest;
+	while ((dest = ring.reserve()) != nullptr)
+		ring.commit(frame_sequence(dest, sequence++));
+	const size_t queued { ring.size() };
+	std::thread hangup { [master] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		close(master);
+	} };
+	REQUIRE(ring.drain(transport) == -1);
+	hangup.join();
+	REQUIRE(ring.size() > 0);
+	REQUIRE(ring.size() < queued);
+}
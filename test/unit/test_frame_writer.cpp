@@ -0,0 +1,61 @@
+/**
+ * \file test_frame_writer.cpp
+ *
+ * Tests for the single pass message writer of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <frame_writer.hpp>
+#include <framing.hpp>
+#include "catch.hpp"
+#include <array>
+#include <numeric>
+
+using namespace EV3UartGenerator;
+
+TEST_CASE("Checksums are accumulated while bytes are written",
+		"[frame_writer] [FrameWriter]") {
+	std::array<uint8_t, 0x40> source { };
+	std::iota(source.begin(), source.end(), 0x5a);
+
+	for (uint8_t len = 0; len <= 0x30; len++) {
+		for (uint8_t padding = 0; padding <= 0x08; padding += 0x04) {
+			std::array<uint8_t, 0x40> buffer { };
+			buffer.fill(0xa5);
+			// Unaligned source, to cover every alignment of the word loop
+			Framing::FrameWriter writer { buffer.data() };
+			writer.put(0xc2);
+			writer.put(source.data() + (len % 8), len);
+			writer.pad(padding);
+			REQUIRE(writer.size() == (0x01u + len + padding));
+			REQUIRE(writer.finish() == (0x02 + len + padding));
+
+			REQUIRE(buffer[0] == 0xc2);
+			REQUIRE(std::equal(source.data() + (len % 8),
+					source.data() + (len % 8) + len, buffer.data() + 1));
+			for (uint8_t i = 0; i < padding; i++)
+				REQUIRE(buffer[1 + len + i] == 0x00);
+			REQUIRE(buffer[1 + len + padding]
+					== Framing::checksum(buffer.data(), 0x01 + len + padding));
+			REQUIRE(buffer[2 + len + padding] == 0xa5); // Nothing written past the checksum
+		}
+	}
+}
+
+TEST_CASE("Little-endian values are written with their checksum",
+		"[frame_writer] [FrameWriter]") {
+	std::array<uint8_t, 0x10> buffer { };
+	Framing::FrameWriter writer { buffer.data() };
+	const int16_t samples[] { 0x0102, -2 };
+
+	writer.put_le32(57600);
+	writer.put_le_f32(-1.0f);
+	writer.put_le(samples, 2);
+	REQUIRE(writer.finish() == 13);
+	REQUIRE(buffer == (std::array<uint8_t, 0x10> { 0x00, 0xe1, 0x00, 0x00,
+			0x00, 0x00, 0x80, 0xbf, 0x02, 0x01, 0xfe, 0xff,
+			Framing::checksum(buffer.data(), 12), 0x00, 0x00, 0x00 }));
+}
@@ -115,7 +115,7 @@ TEST_CASE("Command messages are correctly framed", "[frame] [cmd]") {
 	SECTION("Payloads with invalid size are discarded and correct"
 			" byte counts are returned") {
 		for (uint16_t sz = 0; sz < 0x100; sz++) {
-			uint8_t payload[sz];
+			uint8_t payload[0x100];
 			if (sz < Framing::PAYLOAD_MIN) {
 				REQUIRE(Framing::frame_cmd_write_message(buffer.data(),
 								payload, sz) == -1);
@@ -360,7 +360,7 @@ TEST_CASE("DATA messages are correctly framed", "[frame] [data]") {
 			" byte counts are returned") {
 		for (uint16_t mode = 0; mode < 0x100; mode++) {
 			for (uint16_t sz = 0; sz < 0x100; sz++) {
-				uint8_t payload[sz];
+				uint8_t payload[0x100];
 				if (sz < Framing::PAYLOAD_MIN) {
 					REQUIRE(Framing::frame_data_message(buffer.data(),
 							mode, payload, sz) == -1);
@@ -399,6 +399,45 @@ TEST_CASE("DATA messages are correctly framed", "[frame] [data]") {
 	}
 }
 
+TEST_CASE("Batches of DATA messages are correctly framed",
+		"[frame] [data] [frame_data_messages()]") {
+	using namespace EV3UartGenerator;
+	constexpr uint16_t count { 0x11 };
+	std::array<uint8_t, Framing::PAYLOAD_SENSOR_TO_EV3_MAX * count> samples { };
+	std::iota(samples.begin(), samples.end(), 0);
+
+	SECTION("Payloads with invalid size are discarded") {
+		std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+		REQUIRE(Framing::frame_data_messages(buffer.data(), 0,
+				samples.data(), 0, 1) == -1);
+		REQUIRE(Framing::frame_data_messages(buffer.data(), 0,
+				samples.data(), Framing::PAYLOAD_SENSOR_TO_EV3_MAX + 1,
+				1) == -1);
+		REQUIRE(Framing::frame_data_messages(buffer.data(), 0,
+				samples.data(), 1, 0) == 0);
+	}
+
+	SECTION("Batches are identical to individually framed messages") {
+		std::array<uint8_t, Framing::BUFFER_MIN * count> batch { };
+		std::array<uint8_t, Framing::BUFFER_MIN * count> single { };
+		for (uint16_t mode = 0; mode < 0x10; mode++) {
+			for (uint8_t sz = Framing::PAYLOAD_MIN;
+					sz <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; sz++) {
+				batch.fill(0xff);
+				single.fill(0xff);
+				int32_t total { 0 };
+				for (uint16_t i = 0; i < count; i++)
+					total += Framing::frame_data_message(single.data() + total,
+							mode, samples.data() + (i * sz), sz);
+
+				REQUIRE(Framing::frame_data_messages(batch.data(), mode,
+						samples.data(), sz, count) == total);
+				REQUIRE(batch == single);
+			}
+		}
+	}
+}
+
 TEST_CASE("checksum() returns correct results", "[frame] [checksum()]") {
 	using namespace EV3UartGenerator;
 	std::array<uint8_t, 0xff> buffer {};
@@ -446,6 +485,30 @@ TEST_CASE("length_code() returns correct results", "[frame] [length_code()]") {
 	}
 }
 
+TEST_CASE("padded_length() and padding_length() return correct results",
+		"[frame] [padded_length()] [padding_length()]") {
+	using namespace EV3UartGenerator;
+	static_assert(Framing::padded_length(0x05) == 0x08, "compile time use");
+	static_assert(Framing::padding_length(0x11) == 0x0f, "compile time use");
+	for (uint8_t arg = 1; arg <= 0x20; arg++) {
+		REQUIRE(Framing::padded_length(arg) == (0x01 << Framing::log2(arg)));
+		REQUIRE(Framing::padding_length(arg)
+				== (Framing::padded_length(arg) - arg));
+		REQUIRE(Framing::payload_length(Framing::length_code(arg))
+				== Framing::padded_length(arg));
+	}
+}
+
+TEST_CASE("Software fallbacks match compiler builtins", "[frame] [log2()]") {
+	using namespace EV3UartGenerator;
+	for (uint32_t arg = 1; arg != 0; arg <<= 1) {
+		REQUIRE(Framing::Detail::soft_clz(arg) == __builtin_clz(arg));
+		REQUIRE(Framing::Detail::soft_clz(arg | 0x01) == __builtin_clz(arg | 0x01));
+	}
+	for (uint16_t arg = 1; arg < 256; arg++)
+		REQUIRE(Framing::Detail::search_log2(arg) == Framing::log2(arg));
+}
+
 TEST_CASE("insert_padding() returns correct results and inserts the correct"
 		" amount and type of padding", "[frame] [insert_padding()]") {
 	using namespace EV3UartGenerator;
@@ -466,3 +529,64 @@ TEST_CASE("insert_padding() returns correct results and inserts the correct"
 
 
 
+TEST_CASE("DATA messages are correctly framed from native samples",
+		"[frame] [data] [frame_data_samples()]") {
+	using namespace EV3UartGenerator;
+	using Magics::INFO_DTYPE;
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer {};
+	std::array<uint8_t, Framing::BUFFER_MIN> expected {};
+
+	SECTION("S16 samples are packed little-endian (RGB-RAW)") {
+		const int16_t samples[] { 0x0102, -2, 0x7fff };
+		const uint8_t packed[] { 0x02, 0x01, 0xfe, 0xff, 0xff, 0x7f };
+		const int8_t size { Framing::frame_data_message(expected.data(), 4,
+				packed, sizeof(packed)) };
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 4, samples, 3,
+				INFO_DTYPE::S16) == size);
+		REQUIRE(buffer == expected);
+	}
+
+	SECTION("S8, S32 and F32 samples are packed little-endian") {
+		const int8_t s8[] { -1, 2 };
+		const uint8_t s8_packed[] { 0xff, 0x02 };
+		int8_t size { Framing::frame_data_message(expected.data(), 0,
+				s8_packed, sizeof(s8_packed)) };
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 0, s8, 2,
+				INFO_DTYPE::S8) == size);
+		REQUIRE(buffer == expected);
+
+		const int32_t s32[] { 0x01020304 };
+		const uint8_t s32_packed[] { 0x04, 0x03, 0x02, 0x01 };
+		size = Framing::frame_data_message(expected.data(), 1, s32_packed,
+				sizeof(s32_packed));
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 1, s32, 1,
+				INFO_DTYPE::S32) == size);
+		REQUIRE(buffer == expected);
+
+		const float f32[] { 1020.1875f, -1.0f };
+		const uint8_t f32_packed[] { 0x00, 0x0c, 0x7f, 0x44,
+				0x00, 0x00, 0x80, 0xbf };
+		size = Framing::frame_data_message(expected.data(), 2, f32_packed,
+				sizeof(f32_packed));
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 2, f32, 2,
+				INFO_DTYPE::F32) == size);
+		REQUIRE(buffer == expected);
+	}
+
+	SECTION("Mismatched data types and counts are rejected") {
+		const int16_t samples[0x11] {};
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 0, samples, 1,
+				INFO_DTYPE::S8) == -1);
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 0, samples, 0,
+				INFO_DTYPE::S16) == -1);
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 0, samples, 0x11,
+				INFO_DTYPE::S16) == -1);
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 0, samples, 0x10,
+				INFO_DTYPE::S16) == 0x22);
+		const float floats[0x09] {};
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 0, floats, 0x09,
+				INFO_DTYPE::F32) == -1);
+		REQUIRE(Framing::frame_data_samples(buffer.data(), 0, floats, 0x08,
+				INFO_DTYPE::S32) == -1);
+	}
+}
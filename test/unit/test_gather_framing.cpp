@@ -0,0 +1,73 @@
+/**
+ * \file test_gather_framing.cpp
+ *
+ * Tests for the scatter-gather framing portion of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <gather_framing.hpp>
+#include "catch.hpp"
+#include <array>
+#include <numeric>
+#include <string>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	std::array<uint8_t, Framing::BUFFER_MIN> flat(
+			const GatherFraming::GatherFrame& frame) {
+		std::array<uint8_t, Framing::BUFFER_MIN> bytes { };
+		REQUIRE(GatherFraming::flatten(bytes.data(), frame) == frame.size());
+		return bytes;
+	}
+}
+
+TEST_CASE("Gathered messages match copied messages",
+		"[gather] [frame]") {
+	std::array<uint8_t, Framing::PAYLOAD_SENSOR_TO_EV3_MAX> payload { };
+	std::iota(payload.begin(), payload.end(), 0xa0);
+
+	for (uint8_t len = Framing::PAYLOAD_MIN;
+			len <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; len++) {
+		GatherFraming::GatherFrame frame;
+		std::array<uint8_t, Framing::BUFFER_MIN> expected { };
+
+		const int8_t data_size { Framing::frame_data_message(expected.data(),
+				5, payload.data(), len) };
+		REQUIRE(GatherFraming::gather_data_message(frame, 5, payload.data(),
+				len) == data_size);
+		REQUIRE(frame.payload == payload.data()); // Referenced in place
+		REQUIRE(flat(frame) == expected);
+
+		expected.fill(0);
+		const int8_t write_size { Framing::frame_cmd_write_message(
+				expected.data(), payload.data(), len) };
+		REQUIRE(GatherFraming::gather_cmd_write_message(frame, payload.data(),
+				len) == write_size);
+		REQUIRE(flat(frame) == expected);
+
+		expected.fill(0);
+		const std::string name(len, 'N');
+		const int8_t name_size { Framing::frame_info_message_name(
+				expected.data(), 3, name.c_str()) };
+		REQUIRE(GatherFraming::gather_info_message_name(frame, 3,
+				name.c_str()) == name_size);
+		REQUIRE(frame.head_len == 2);
+		REQUIRE(flat(frame) == expected);
+	}
+}
+
+TEST_CASE("Gathered messages with invalid lengths are rejected",
+		"[gather] [frame]") {
+	const uint8_t payload[0x21] { };
+	GatherFraming::GatherFrame frame { };
+	REQUIRE(GatherFraming::gather_data_message(frame, 0, payload, 0) == -1);
+	REQUIRE(GatherFraming::gather_data_message(frame, 0, payload, 0x21) == -1);
+	REQUIRE(GatherFraming::gather_cmd_write_message(frame, payload, 0) == -1);
+	REQUIRE(GatherFraming::gather_info_message_name(frame, 0, "") == -1);
+	REQUIRE(GatherFraming::gather_info_message_name(frame, 0, nullptr) == -1);
+	REQUIRE(frame.size() == 0);
+}
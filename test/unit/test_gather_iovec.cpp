@@ -0,0 +1,71 @@
+/**
+ * \file test_gather_iovec.cpp
+ *
+ * Tests for the Linux scatter-gather output of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <linux/gather_iovec.hpp>
+#include "catch.hpp"
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+TEST_CASE("Frames are described as iovec segments", "[linux] [gather]") {
+	using namespace EV3UartGenerator;
+	const uint8_t payload[] { 0x01, 0x02, 0x03 };
+	GatherFraming::GatherFrame frame;
+	REQUIRE(GatherFraming::gather_data_message(frame, 1, payload,
+			sizeof(payload)) == 6);
+
+	struct iovec iov[Linux::FRAME_IOVECS];
+	REQUIRE(Linux::to_iovec(frame, iov) == Linux::FRAME_IOVECS);
+	REQUIRE(iov[0].iov_len == 1);
+	REQUIRE(iov[1].iov_base == static_cast<const void*>(payload));
+	REQUIRE(iov[1].iov_len == 3);
+	REQUIRE(iov[2].iov_len == 2);
+}
+
+TEST_CASE("Batches of frames are written with writev()", "[linux] [gather]") {
+	using namespace EV3UartGenerator;
+	const int master { posix_openpt(O_RDWR | O_NOCTTY) };
+	REQUIRE(master >= 0);
+	grantpt(master);
+	unlockpt(master);
+	Linux::Transport transport;
+	REQUIRE(transport.open(ptsname(master)) == 0);
+
+	// More frames than fit into a single writev()
+	constexpr size_t FRAMES { 0x200 };
+	std::vector<uint8_t> payloads(FRAMES * 2);
+	std::vector<GatherFraming::GatherFrame> frames(FRAMES);
+	std::vector<uint8_t> expected;
+	for (size_t i = 0; i < FRAMES; i++) {
+		payloads[2 * i] = static_cast<uint8_t>(i);
+		payloads[2 * i + 1] = static_cast<uint8_t>(i >> 8);
+		GatherFraming::gather_data_message(frames[i], 0, &payloads[2 * i], 2);
+		uint8_t buf[Framing::BUFFER_MIN];
+		const int8_t size { Framing::frame_data_message(buf, 0,
+				&payloads[2 * i], 2) };
+		expected.insert(expected.end(), buf, buf + size);
+	}
+	REQUIRE(Linux::write_frames(transport, frames.data(), FRAMES)
+			== static_cast<ssize_t>(expected.size()));
+
+	std::vector<uint8_t> received;
+	uint8_t buf[0x400];
+	struct pollfd pfd { master, POLLIN, 0 };
+	while ((received.size() < expected.size()) && (poll(&pfd, 1, 1000) > 0)) {
+		const ssize_t got { read(master, buf, sizeof(buf)) };
+		if (got <= 0)
+			break;
+		received.insert(received.end(), buf, buf + got);
+	}
+	REQUIRE(received == expected);
+	close(master);
+}
@@ -0,0 +1,63 @@
+/**
+ * \file test_header_only.cpp
+ *
+ * Tests for the header-only build of EV3UartGenerator. This file is linked
+ * without any of the library sources, and fails to link if a definition is
+ * missing from the *_impl.hpp headers.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#define EV3UARTGENERATOR_HEADER_ONLY 1
+#include <sensor_descriptor.hpp>
+#include <frame_buffer.hpp>
+#include <gather_framing.hpp>
+#include "catch.hpp"
+#include <array>
+
+using namespace EV3UartGenerator;
+using Magics::INFO_DTYPE;
+
+TEST_CASE("Header-only messages are framed as by the library",
+		"[header_only]") {
+	std::array<uint8_t, Framing::BUFFER_MIN> dest { };
+
+	REQUIRE(Framing::frame_cmd_speed_message(dest.data(), 57600) == 6);
+	REQUIRE(dest[0] == 0x52);
+	REQUIRE(dest[1] == 0x00);
+	REQUIRE(dest[2] == 0xe1);
+	REQUIRE(dest[3] == 0x00);
+	REQUIRE(dest[4] == 0x00);
+	REQUIRE(dest[5] == 0x4c);
+
+	const uint8_t payload[] { 0x01, 0x02, 0x03 };
+	REQUIRE(Framing::frame_data_message(dest.data(), 1, payload, 3) == 6);
+	REQUIRE(dest[5] == Framing::checksum(dest.data(), 5));
+
+	GatherFraming::GatherFrame frame;
+	REQUIRE(GatherFraming::gather_data_message(frame, 1, payload, 3) == 6);
+	std::array<uint8_t, Framing::BUFFER_MIN> flat { };
+	REQUIRE(GatherFraming::flatten(flat.data(), frame) == 6);
+	REQUIRE(flat == dest);
+}
+
+TEST_CASE("Header-only handshakes are framed into buffers",
+		"[header_only] [descriptor]") {
+	constexpr Descriptor::SpanDescriptor NO_SPAN { false, 0, 0 };
+	const Descriptor::ModeDescriptor modes[] {
+		{ "COL-REFLECT", { true, 0, 100 }, NO_SPAN, { true, 0, 100 }, "pct",
+				1, INFO_DTYPE::S8, 3, 0 },
+	};
+	const Descriptor::SensorDescriptor sensor { 0x1d, 1, 1, 57600, modes };
+
+	std::array<uint8_t, 0x80> storage { };
+	Framing::FrameBuffer buffer { storage.data(), storage.size() };
+	const Framing::FrameResult result { Descriptor::frame_handshake(buffer,
+			sensor) };
+	REQUIRE(result);
+	REQUIRE(result.size == Descriptor::handshake_size(sensor));
+	REQUIRE(storage[0] == 0x40);
+	REQUIRE(storage[result.size - 1] == 0x04);
+}
@@ -0,0 +1,118 @@
+/**
+ * \file test_host_emulator.cpp
+ *
+ * Tests for the Linux EV3 host emulator of EV3UartGenerator, against
+ * sensors emulated by the sensor farm.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <linux/host_emulator.hpp>
+#include <linux/sensor_farm.hpp>
+#include <lego_sensors.hpp>
+#include "catch.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	class ModeSampler : public Linux::Sampler {
+	public:
+		uint8_t sample(size_t, uint8_t mode, uint8_t* payload) override {
+			payload[0] = mode;
+			return 1;
+		}
+	};
+
+	/**
+	 * Sensor emulated on the slave side of a host emulator, on its own thread.
+	 */
+	class SensorThread {
+	public:
+		SensorThread(const char* path, const Descriptor::SensorDescriptor& sensor)
+			: farm { sampler, { 100, 1000, 10 } }, stop { false } {
+			added = farm.add(path, sensor);
+			thread = std::thread([this] {
+				while (!stop)
+					farm.run_once(5);
+			});
+		}
+
+		~SensorThread() {
+			stop = true;
+			thread.join();
+		}
+
+		ModeSampler sampler;
+		Linux::SensorFarm farm;
+		std::atomic<bool> stop;
+		std::thread thread;
+		int added;
+	};
+}
+
+TEST_CASE("Host emulators consume handshakes", "[linux] [host_emulator]") {
+	Linux::HostEmulator host;
+	REQUIRE(host.slave_path() == nullptr);
+	REQUIRE(host.open() == 0);
+	REQUIRE(host.slave_path() != nullptr);
+
+	SensorThread sensor { host.slave_path(), LegoSensors::ULTRASONIC };
+	REQUIRE(sensor.added == 0);
+	REQUIRE(host.handshake(2000) == 0);
+	REQUIRE(host.type() == 30);
+	REQUIRE(host.modes() == 7);
+	REQUIRE(host.speed() == 57600);
+	REQUIRE(host.info_messages() == 34);
+	REQUIRE(host.sensor().complete);
+	REQUIRE(std::string(host.sensor().details[0].name)
+			== LegoSensors::ULTRASONIC.mode_table[0].name);
+
+	SECTION("keepalives keep the sensor streaming") {
+		const Linux::HostSchedule schedule { 20, 0, 0, 1 };
+		REQUIRE(host.run(300, schedule) == 0);
+		const Linux::HostStats& stats { host.stats() };
+		REQUIRE(stats.nacks >= 10);
+		REQUIRE(stats.nack_rtt.count >= 10);
+		REQUIRE(stats.nack_rtt.min <= stats.nack_rtt.mean());
+		REQUIRE(stats.nack_rtt.mean() <= stats.nack_rtt.max);
+		REQUIRE(stats.data_messages > stats.nacks);
+		REQUIRE(stats.checksum_errors == 0);
+		REQUIRE(stats.data_rate() > 0);
+		// The sampler sends a single byte, whatever the format of the mode
+		REQUIRE(stats.data_malformed == ((host.sensor().modes[0].payload_size > 1)
+				? stats.data_messages : 0));
+	}
+
+	SECTION("mode changes are measured") {
+		const Linux::HostSchedule schedule { 50, 30, 40, 4 };
+		REQUIRE(host.run(300, schedule) == 0);
+		const Linux::HostStats& stats { host.stats() };
+		REQUIRE(stats.selects >= 5);
+		REQUIRE(stats.writes >= 5);
+		REQUIRE(stats.select_rtt.count >= stats.selects - 1);
+		REQUIRE(sensor.farm.machine(0).state() == StateMachine::State::DATA);
+	}
+}
+
+TEST_CASE("Host emulators time out without a sensor",
+		"[linux] [host_emulator]") {
+	Linux::HostEmulator host;
+	REQUIRE(host.open() == 0);
+	REQUIRE(host.handshake(50) == -1);
+	REQUIRE(errno == ETIMEDOUT);
+}
+
+TEST_CASE("Host emulators wait for sensors with negative timeouts",
+		"[linux] [host_emulator]") {
+	Linux::HostEmulator host;
+	REQUIRE(host.open() == 0);
+	SensorThread sensor { host.slave_path(), LegoSensors::COLOR };
+	REQUIRE(sensor.added == 0);
+	REQUIRE(host.handshake(-1) == 0);
+	REQUIRE(host.type() == 29);
+}
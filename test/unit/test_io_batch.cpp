@@ -0,0 +1,158 @@
+/**
+ * \file test_io_batch.cpp
+ *
+ * Tests for the batched I/O of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <linux/io_batch.hpp>
+#include "catch.hpp"
+#include <array>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	constexpr Linux::IoBackend BACKENDS[] { Linux::IoBackend::URING,
+			Linux::IoBackend::SYSCALLS };
+
+	/**
+	 * Raw, non-blocking pseudo-terminal.
+	 */
+	struct Pty {
+		int master;
+		int slave;
+
+		Pty() {
+			master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+			grantpt(master);
+			unlockpt(master);
+			slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+			struct termios tio;
+			tcgetattr(slave, &tio);
+			cfmakeraw(&tio);
+			tcsetattr(slave, TCSANOW, &tio);
+		}
+
+		~Pty() {
+			close(slave);
+			close(master);
+		}
+	};
+}
+
+TEST_CASE("I/O batches read and write many descriptors",
+		"[linux] [io_batch]") {
+	for (const Linux::IoBackend preferred : BACKENDS) {
+		Linux::IoBatch batch { preferred };
+		INFO("backend " << static_cast<int>(batch.backend()));
+		if (preferred == Linux::IoBackend::SYSCALLS)
+			REQUIRE(batch.backend() == Linux::IoBackend::SYSCALLS);
+
+		std::array<Pty, 8> ptys;
+		uint8_t messages[8][3];
+		for (size_t i = 0; i < ptys.size(); i++) {
+			messages[i][0] = 0x40;
+			messages[i][1] = static_cast<uint8_t>(i);
+			messages[i][2] = static_cast<uint8_t>(0xff ^ 0x40 ^ i);
+			batch.write(ptys[i].slave, messages[i], sizeof(messages[i]));
+		}
+		REQUIRE(batch.size() == ptys.size());
+		REQUIRE(batch.submit() == 0);
+		for (size_t i = 0; i < ptys.size(); i++)
+			REQUIRE(batch.result(i) == 3);
+
+		// Queueing after submit() starts a new batch
+		uint8_t received[8][0x10];
+		for (size_t i = 0; i < ptys.size(); i++)
+			batch.read(ptys[i].master, received[i], sizeof(received[i]));
+		REQUIRE(batch.size() == ptys.size());
+		REQUIRE(batch.submit() == 0);
+		for (size_t i = 0; i < ptys.size(); i++) {
+			REQUIRE(batch.result(i) == 3);
+			REQUIRE(memcmp(received[i], messages[i], 3) == 0);
+		}
+		REQUIRE(batch.syscalls() > 0);
+	}
+}
+
+TEST_CASE("I/O batches report errors of single operations",
+		"[linux] [io_batch]") {
+	for (const Linux::IoBackend preferred : BACKENDS) {
+		Linux::IoBatch batch { preferred };
+		// Operations run in no particular order - use separate pipes
+		int empty[2];
+		int other[2];
+		REQUIRE(pipe2(empty, O_NONBLOCK) == 0);
+		REQUIRE(pipe2(other, O_NONBLOCK) == 0);
+
+		uint8_t buf[4] { 1, 2, 3, 4 };
+		batch.read(empty[0], buf, sizeof(buf));
+		batch.write(-1, buf, sizeof(buf));
+		batch.write(other[1], buf, sizeof(buf));
+		REQUIRE(batch.submit() == 0);
+		REQUIRE(batch.result(0) == -EAGAIN);
+		REQUIRE(batch.result(1) == -EBADF);
+		REQUIRE(batch.result(2) == 4);
+
+		batch.submit(); // Submitting an empty batch does nothing
+		for (const int fd : { empty[0], empty[1], other[0], other[1] })
+			close(fd);
+	}
+}
+
+TEST_CASE("I/O batches larger than a submission are split",
+		"[linux] [io_batch]") {
+	for (const Linux::IoBackend preferred : BACKENDS) {
+		Linux::IoBatch batch { preferred };
+		const int null { open("/dev/null", O_WRONLY | O_CLOEXEC) };
+		REQUIRE(null >= 0);
+
+		const uint8_t message[5] { };
+		const size_t count { (2 * Linux::IO_BATCH_ENTRIES) + 7 };
+		for (size_t i = 0; i < count; i++)
+			batch.write(null, message, i % sizeof(message));
+		REQUIRE(batch.submit() == 0);
+		for (size_t i = 0; i < count; i++)
+			REQUIRE(batch.result(i) == static_cast<ssize_t>(i % sizeof(message)));
+
+		if (batch.backend() == Linux::IoBackend::URING)
+			REQUIRE(batch.syscalls() < 10);
+		else
+			REQUIRE(batch.syscalls() == count);
+		close(null);
+	}
+}
+
+TEST_CASE("I/O batches fall back when the io_uring fails",
+		"[linux] [io_batch]") {
+	// The io_uring takes the lowest free descriptor, which is replaced by
+	// /dev/null once set up - every io_uring_enter() then fails
+	const int lowest { dup(0) };
+	REQUIRE(lowest >= 0);
+	close(lowest);
+	Linux::IoBatch batch { Linux::IoBackend::URING };
+	if (batch.backend() != Linux::IoBackend::URING)
+		return;
+	const int null { open("/dev/null", O_WRONLY | O_CLOEXEC) };
+	REQUIRE(null >= 0);
+	REQUIRE(dup2(null, lowest) == lowest);
+
+	const uint8_t message[3] { 0x40, 0x00, 0xbf };
+	batch.write(null, message, sizeof(message));
+	REQUIRE(batch.submit() == -1);
+	REQUIRE(batch.backend() == Linux::IoBackend::SYSCALLS);
+
+	batch.write(null, message, sizeof(message));
+	REQUIRE(batch.submit() == 0);
+	REQUIRE(batch.result(0) == 3);
+	close(null);
+}
@@ -0,0 +1,31 @@
+/**
+ * \file test_lego_sensors.cpp
+ *
+ * Tests for the descriptions of LEGO sensors in EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <lego_sensors.hpp>
+#include "catch.hpp"
+
+TEST_CASE("LEGO sensor descriptions are valid", "[lego_sensors]") {
+	using namespace EV3UartGenerator;
+
+	// Sizes of the reference bitstreams
+	REQUIRE(Descriptor::handshake_size(LegoSensors::COLOR) == 311);
+	REQUIRE(Descriptor::handshake_size(LegoSensors::ULTRASONIC) == 384);
+	REQUIRE(Descriptor::handshake_size(LegoSensors::GYRO) == 354);
+	REQUIRE(Descriptor::handshake_size(LegoSensors::GYRO)
+			<= Descriptor::HANDSHAKE_MAX);
+}
+
+TEST_CASE("LEGO sensor descriptions are found by name", "[lego_sensors]") {
+	using namespace EV3UartGenerator;
+	REQUIRE(LegoSensors::find("color") == &LegoSensors::COLOR);
+	REQUIRE(LegoSensors::find("ultrasonic") == &LegoSensors::ULTRASONIC);
+	REQUIRE(LegoSensors::find("gyro") == &LegoSensors::GYRO);
+	REQUIRE(LegoSensors::find("touch") == nullptr);
+}
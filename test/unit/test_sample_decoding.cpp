@@ -0,0 +1,246 @@
+/**
+ * \file test_sample_decoding.cpp
+ *
+ * Tests for the bulk sample decoding portion of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <sample_decoding.hpp>
+#include <framing.hpp>
+#include "catch.hpp"
+#include <array>
+#include <string>
+#include <vector>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	using Kernel16 = int8_t (*)(const Decoding::Frame*, size_t,
+			const Registry::ModeInfo&, int16_t*, size_t);
+	using Kernel32 = int8_t (*)(const Decoding::Frame*, size_t,
+			const Registry::ModeInfo&, int32_t*, size_t);
+	using KernelF = int8_t (*)(const Decoding::Frame*, size_t,
+			const Registry::ModeInfo&, float*, size_t);
+
+	struct Kernel {
+		const char* name;
+		Kernel16 decode16;
+		Kernel32 decode32;
+		KernelF decode_f;
+	};
+
+	const Kernel kernels[] {
+		{ "scalar", SampleDecoding::decode_columns_scalar<int16_t>,
+			SampleDecoding::decode_columns_scalar<int32_t>,
+			SampleDecoding::decode_columns_scalar<float> },
+#if defined(__SSE2__)
+		{ "sse2", SampleDecoding::decode_columns_sse2<int16_t>,
+			SampleDecoding::decode_columns_sse2<int32_t>,
+			SampleDecoding::decode_columns_sse2<float> },
+#endif
+#if defined(EV3UARTGENERATOR_SAMPLES_NEON)
+		{ "neon", SampleDecoding::decode_columns_neon<int16_t>,
+			SampleDecoding::decode_columns_neon<int32_t>,
+			SampleDecoding::decode_columns_neon<float> },
+#endif
+		{ "dispatch", SampleDecoding::decode_columns<int16_t>,
+			SampleDecoding::decode_columns<int32_t>,
+			SampleDecoding::decode_columns<float> },
+	};
+
+	/**
+	 * DATA messages framed from known samples, all in the same mode.
+	 */
+	struct Batch {
+		std::vector<uint8_t> stream;
+		std::vector<Decoding::Frame> frames;
+		std::vector<double> expected; ///< Sample e of message m at [e * count + m]
+		Registry::ModeInfo info;
+	};
+
+	/**
+	 * Frames \c count messages of \c elems samples.
+	 *
+	 * @param make returns sample e of message m
+	 */
+	template <typename Sample, typename Make>
+	void frame_batch(Batch& batch, Magics::INFO_DTYPE data_type,
+			uint8_t elems, size_t count, Make make) {
+		batch.stream.assign(count * Framing::BUFFER_MIN, 0x00);
+		batch.frames.clear();
+		batch.expected.assign(elems * count, 0.0);
+		batch.info = Registry::ModeInfo { elems, data_type, sizeof(Sample),
+			static_cast<uint8_t>(elems * sizeof(Sample)) };
+		for (size_t m = 0; m < count; m++) {
+			Sample samples[Framing::PAYLOAD_SENSOR_TO_EV3_MAX];
+			for (uint8_t e = 0; e < elems; e++) {
+				samples[e] = static_cast<Sample>(make(m, e));
+				batch.expected[(e * count) + m] = samples[e];
+			}
+			uint8_t* const dest { batch.stream.data()
+				+ (m * Framing::BUFFER_MIN) };
+			const int8_t size { Framing::frame_data_samples(dest, 3, samples,
+					elems, data_type) };
+			REQUIRE(size > 0);
+			batch.frames.push_back(Decoding::Frame { dest,
+				static_cast<uint8_t>(size) });
+		}
+	}
+
+	/**
+	 * Integer samples covering the extremes of a data type.
+	 */
+	int64_t sample(size_t m, uint8_t e, int64_t min, int64_t max) {
+		switch ((m + e) % 5) {
+		case 0:
+			return min;
+		case 1:
+			return max;
+		case 2:
+			return -1;
+		default:
+			return (((static_cast<int64_t>(m) * 0x9d) + (e * 0x3b)) % max)
+					- ((m & 0x01) ? (max / 2) : 0);
+		}
+	}
+
+	/**
+	 * Decodes a batch into an array with rows longer than the batch, and
+	 * compares the decoded samples, and the untouched ends of the rows,
+	 * with the expected ones.
+	 */
+	template <typename T>
+	void check(const Batch& batch, int8_t (*decode)(const Decoding::Frame*,
+			size_t, const Registry::ModeInfo&, T*, size_t)) {
+		const size_t count { batch.frames.size() };
+		const size_t stride { count + 3 };
+		const T guard { static_cast<T>(0x55) };
+		std::vector<T> expected(batch.info.elems * stride, guard);
+		for (uint8_t e = 0; e < batch.info.elems; e++) {
+			for (size_t m = 0; m < count; m++)
+				expected[(e * stride) + m] = static_cast<T>(
+						batch.expected[(e * count) + m]);
+		}
+
+		std::vector<T> columns(batch.info.elems * stride, guard);
+		REQUIRE(decode(batch.frames.data(), count, batch.info, columns.data(),
+				stride) == batch.info.elems);
+		REQUIRE(columns == expected);
+	}
+}
+
+TEST_CASE("Samples are decoded into per-element columns",
+		"[sample_decoding]") {
+	Batch batch;
+	for (const Kernel& kernel : kernels) {
+		INFO("kernel " << kernel.name);
+		for (size_t count : { 0, 1, 3, 4, 5, 8, 63, 64 }) {
+			INFO(count << " messages");
+			for (uint8_t elems : { 1, 2, 3, 4, 5, 7, 8 }) {
+				INFO(static_cast<int>(elems) << " elements");
+
+				frame_batch<int8_t>(batch, Magics::INFO_DTYPE::S8, elems,
+						count, [](size_t m, uint8_t e) {
+							return sample(m, e, INT8_MIN, INT8_MAX);
+						});
+				check(batch, kernel.decode16);
+				check(batch, kernel.decode32);
+				check(batch, kernel.decode_f);
+
+				frame_batch<int16_t>(batch, Magics::INFO_DTYPE::S16, elems,
+						count, [](size_t m, uint8_t e) {
+							return sample(m, e, INT16_MIN, INT16_MAX);
+						});
+				check(batch, kernel.decode16);
+				check(batch, kernel.decode32);
+				check(batch, kernel.decode_f);
+
+				frame_batch<int32_t>(batch, Magics::INFO_DTYPE::S32, elems,
+						count, [](size_t m, uint8_t e) {
+							return sample(m, e, INT32_MIN, INT32_MAX);
+						});
+				check(batch, kernel.decode32);
+				check(batch, kernel.decode_f);
+
+				frame_batch<float>(batch, Magics::INFO_DTYPE::F32, elems,
+						count, [](size_t m, uint8_t e) {
+							return (m * 0.5) - (e * 1.25);
+						});
+				check(batch, kernel.decode_f);
+			}
+		}
+	}
+}
+
+TEST_CASE("All elements of the largest formats are decoded",
+		"[sample_decoding]") {
+	Batch batch;
+	for (const Kernel& kernel : kernels) {
+		INFO("kernel " << kernel.name);
+		frame_batch<int8_t>(batch, Magics::INFO_DTYPE::S8,
+				Framing::PAYLOAD_SENSOR_TO_EV3_MAX, 9, [](size_t m, uint8_t e) {
+					return sample(m, e, INT8_MIN, INT8_MAX);
+				});
+		check(batch, kernel.decode16);
+		frame_batch<int16_t>(batch, Magics::INFO_DTYPE::S16,
+				Framing::PAYLOAD_SENSOR_TO_EV3_MAX / 2, 9,
+				[](size_t m, uint8_t e) {
+					return sample(m, e, INT16_MIN, INT16_MAX);
+				});
+		check(batch, kernel.decode32);
+	}
+}
+
+TEST_CASE("Batches which can not be decoded are rejected",
+		"[sample_decoding]") {
+	Batch batch;
+	for (const Kernel& kernel : kernels) {
+		INFO("kernel " << kernel.name);
+		std::array<int16_t, 0x10> narrow { };
+		std::array<int32_t, 0x10> wide { };
+
+		frame_batch<int32_t>(batch, Magics::INFO_DTYPE::S32, 2, 5,
+				[](size_t m, uint8_t) {
+					return m;
+				});
+		REQUIRE(kernel.decode16(batch.frames.data(), 5, batch.info,
+				narrow.data(), 5) == -1);
+
+		frame_batch<float>(batch, Magics::INFO_DTYPE::F32, 2, 5,
+				[](size_t m, uint8_t) {
+					return m;
+				});
+		REQUIRE(kernel.decode32(batch.frames.data(), 5, batch.info,
+				wide.data(), 5) == -1);
+
+		// Mode without INFO FORMAT
+		REQUIRE(kernel.decode32(batch.frames.data(), 5,
+				Registry::ModeInfo { }, wide.data(), 5) == -1);
+
+		// Last payload too short for the format
+		frame_batch<int16_t>(batch, Magics::INFO_DTYPE::S16, 3, 5,
+				[](size_t m, uint8_t) {
+					return m;
+				});
+		const int16_t sample { 7 };
+		batch.frames[4].size = static_cast<uint8_t>(Framing::frame_data_samples(
+				batch.stream.data() + (4 * Framing::BUFFER_MIN), 3, &sample, 1,
+				Magics::INFO_DTYPE::S16));
+		REQUIRE(kernel.decode32(batch.frames.data(), 5, batch.info,
+				wide.data(), 5) == -1);
+		REQUIRE(wide == (std::array<int32_t, 0x10> { }));
+	}
+}
+
+TEST_CASE("The kernel of the target is used", "[sample_decoding]") {
+#if defined(EV3UARTGENERATOR_SCALAR_SAMPLES)
+	REQUIRE(std::string(SampleDecoding::kernel()) == "scalar");
+#elif defined(__SSE2__)
+	REQUIRE(std::string(SampleDecoding::kernel()) == "sse2");
+#elif defined(EV3UARTGENERATOR_SAMPLES_NEON)
+	REQUIRE(std::string(SampleDecoding::kernel()) == "neon");
+#endif
+}
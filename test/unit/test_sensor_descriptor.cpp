@@ -0,0 +1,143 @@
+/**
+ * \file test_sensor_descriptor.cpp
+ *
+ * Tests for the sensor description portion of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <sensor_descriptor.hpp>
+#include "catch.hpp"
+#include <array>
+#include <algorithm>
+
+namespace {
+	using namespace EV3UartGenerator;
+	using Magics::INFO_DTYPE;
+	using Magics::INFO_SPAN;
+
+	constexpr Descriptor::SpanDescriptor NO_SPAN { false, 0, 0 };
+	const Descriptor::ModeDescriptor modes[] {
+		{ "COL-REFLECT", { true, 0, 100 }, NO_SPAN, { true, 0, 100 }, "pct",
+				1, INFO_DTYPE::S8, 3, 0 },
+		{ "COL-COLOR", { true, 0, 8 }, { true, 0, 100 }, NO_SPAN, "col",
+				1, INFO_DTYPE::S8, 2, 0 },
+		{ "RGB-RAW", { true, 0, 1020.188 }, NO_SPAN, { true, 0, 1020.188 },
+				nullptr, 3, INFO_DTYPE::S16, 4, 0 },
+	};
+}
+
+TEST_CASE("Handshakes are framed from sensor descriptions",
+		"[descriptor] [frame_handshake()]") {
+	using namespace EV3UartGenerator;
+	const Descriptor::SensorDescriptor sensor { 0x1d, 3, 2, 57600, modes };
+	std::array<uint8_t, 0x100> expected { };
+	uint8_t* dest { expected.data() };
+
+	dest += Framing::frame_cmd_type_message(dest, 0x1d);
+	dest += Framing::frame_cmd_modes_message(dest, 2, 1);
+	dest += Framing::frame_cmd_speed_message(dest, 57600);
+	dest += Framing::frame_info_message_name(dest, 2, "RGB-RAW");
+	dest += Framing::frame_info_message_span(dest, 2, INFO_SPAN::RAW, 0,
+			1020.188);
+	dest += Framing::frame_info_message_span(dest, 2, INFO_SPAN::SI, 0,
+			1020.188);
+	dest += Framing::frame_info_message_format(dest, 2, 3, INFO_DTYPE::S16,
+			4, 0);
+	dest += Framing::frame_info_message_name(dest, 1, "COL-COLOR");
+	dest += Framing::frame_info_message_span(dest, 1, INFO_SPAN::RAW, 0, 8);
+	dest += Framing::frame_info_message_span(dest, 1, INFO_SPAN::PCT, 0, 100);
+	dest += Framing::frame_info_message_symbol(dest, 1, "col");
+	dest += Framing::frame_info_message_format(dest, 1, 1, INFO_DTYPE::S8,
+			2, 0);
+	dest += Framing::frame_info_message_name(dest, 0, "COL-REFLECT");
+	dest += Framing::frame_info_message_span(dest, 0, INFO_SPAN::RAW, 0, 100);
+	dest += Framing::frame_info_message_span(dest, 0, INFO_SPAN::SI, 0, 100);
+	dest += Framing::frame_info_message_symbol(dest, 0, "pct");
+	dest += Framing::frame_info_message_format(dest, 0, 1, INFO_DTYPE::S8,
+			3, 0);
+	dest += Framing::frame_sys_message(dest, Magics::SYS::ACK);
+	const int16_t expected_size { static_cast<int16_t>(dest - expected.data()) };
+
+	SECTION("handshake size is computed exactly") {
+		REQUIRE(Descriptor::handshake_size(sensor) == expected_size);
+	}
+
+	SECTION("handshake is framed into an exactly sized buffer") {
+		std::array<uint8_t, 0x100> buffer { };
+		buffer.fill(0xa5);
+		REQUIRE(Descriptor::frame_handshake(buffer.data(), expected_size,
+				sensor) == expected_size);
+		REQUIRE(std::equal(buffer.data(), buffer.data() + expected_size,
+				expected.data()));
+		REQUIRE(buffer[expected_size] == 0xa5);
+	}
+
+	SECTION("nothing is written to buffers that are too small") {
+		std::array<uint8_t, 0x100> buffer { };
+		buffer.fill(0xa5);
+		REQUIRE(Descriptor::frame_handshake(buffer.data(), expected_size - 1,
+				sensor) == -1);
+		REQUIRE(std::all_of(buffer.begin(), buffer.end(),
+				[](uint8_t b) { return b == 0xa5; }));
+	}
+}
+
+TEST_CASE("Invalid sensor descriptions are rejected",
+		"[descriptor] [handshake_size()]") {
+	using namespace EV3UartGenerator;
+	std::array<uint8_t, 0x400> buffer { };
+
+	SECTION("invalid mode counts") {
+		const Descriptor::SensorDescriptor no_modes { 0x1d, 0, 0, 57600, modes };
+		const Descriptor::SensorDescriptor too_many_visible { 0x1d, 2, 3, 57600,
+				modes };
+		const Descriptor::SensorDescriptor no_table { 0x1d, 1, 1, 57600,
+				nullptr };
+		REQUIRE(Descriptor::handshake_size(no_modes) == -1);
+		REQUIRE(Descriptor::handshake_size(too_many_visible) == -1);
+		REQUIRE(Descriptor::handshake_size(no_table) == -1);
+		REQUIRE(Descriptor::frame_handshake(buffer.data(), buffer.size(),
+				no_modes) == -1);
+	}
+
+	SECTION("invalid names and symbols") {
+		Descriptor::ModeDescriptor mode { modes[0] };
+		const Descriptor::SensorDescriptor sensor { 0x1d, 1, 1, 57600, &mode };
+		REQUIRE(Descriptor::handshake_size(sensor) > 0);
+
+		mode.name = "";
+		REQUIRE(Descriptor::handshake_size(sensor) == -1);
+		mode.name = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456";
+		REQUIRE(Descriptor::handshake_size(sensor) == -1);
+		mode.name = nullptr;
+		REQUIRE(Descriptor::handshake_size(sensor) == -1);
+
+		mode.name = "A";
+		mode.symbol = "ABCDEFGHI";
+		REQUIRE(Descriptor::handshake_size(sensor) == -1);
+		mode.symbol = nullptr;
+		REQUIRE(Descriptor::handshake_size(sensor) > 0);
+	}
+}
+
+TEST_CASE("DATA messages are framed according to the format of a mode",
+		"[descriptor] [frame_mode_data()]") {
+	using namespace EV3UartGenerator;
+	const Descriptor::SensorDescriptor sensor { 0x1d, 3, 2, 57600, modes };
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	std::array<uint8_t, Framing::BUFFER_MIN> expected { };
+
+	const int16_t rgb[] { 0x0100, 0x0200, 0x0300 };
+	const int8_t size { Framing::frame_data_samples(expected.data(), 2, rgb, 3,
+			INFO_DTYPE::S16) };
+	REQUIRE(Descriptor::frame_mode_data(buffer.data(), sensor, 2, rgb) == size);
+	REQUIRE(buffer == expected);
+
+	const int8_t reflect[] { 42 };
+	REQUIRE(Descriptor::frame_mode_data(buffer.data(), sensor, 0, reflect) == 3);
+	REQUIRE(Descriptor::frame_mode_data(buffer.data(), sensor, 2, reflect) == -1);
+	REQUIRE(Descriptor::frame_mode_data(buffer.data(), sensor, 3, rgb) == -1);
+}
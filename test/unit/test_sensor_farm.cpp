@@ -0,0 +1,274 @@
+/**
+ * \file test_sensor_farm.cpp
+ *
+ * Tests for the Linux sensor farm of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <linux/sensor_farm.hpp>
+#include <lego_sensors.hpp>
+#include "catch.hpp"
+#include <array>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	constexpr size_t PORTS { 0x10 };
+
+	/**
+	 * Pseudo-terminal, with the master side standing in for an EV3.
+	 */
+	struct Ev3Side {
+		int master;
+
+		Ev3Side() {
+			master = posix_openpt(O_RDWR | O_NOCTTY);
+			grantpt(master);
+			unlockpt(master);
+		}
+
+		~Ev3Side() {
+			if (master >= 0)
+				close(master);
+		}
+
+		std::vector<uint8_t> read_available() {
+			std::vector<uint8_t> bytes;
+			uint8_t buf[0x200];
+			struct pollfd pfd { master, POLLIN, 0 };
+			while (poll(&pfd, 1, 0) > 0) {
+				const ssize_t got { read(master, buf, sizeof(buf)) };
+				if (got <= 0)
+					break;
+				bytes.insert(bytes.end(), buf, buf + got);
+			}
+			return bytes;
+		}
+	};
+
+	class ConstantSampler : public Linux::Sampler {
+	public:
+		uint8_t sample(size_t port, uint8_t, uint8_t* payload) override {
+			payload[0] = static_cast<uint8_t>(port);
+			return 1;
+		}
+	};
+
+	void run_for(Linux::SensorFarm& farm, int ms) {
+		for (int i = 0; i < ms; i++)
+			farm.run_once(1);
+	}
+}
+
+TEST_CASE("Sensor farms drive many ports from one loop",
+		"[linux] [sensor_farm]") {
+	const StateMachine::Timing timing { 50, 1000, 5 };
+	ConstantSampler sampler;
+	Linux::SensorFarm farm { sampler, timing };
+	std::array<Ev3Side, PORTS> ev3s;
+	for (Ev3Side& ev3 : ev3s)
+		REQUIRE(farm.add(ptsname(ev3.master), LegoSensors::COLOR) >= 0);
+	REQUIRE(farm.size() == PORTS);
+	REQUIRE(farm.active() == PORTS);
+
+	std::array<uint8_t, Descriptor::HANDSHAKE_MAX> handshake { };
+	const int16_t size { Descriptor::frame_handshake(handshake.data(),
+			handshake.size(), LegoSensors::COLOR) };
+	run_for(farm, 5);
+	for (size_t i = 0; i < PORTS; i++) {
+		REQUIRE(farm.machine(i).state() == StateMachine::State::WAIT_ACK);
+		REQUIRE(ev3s[i].read_available() == std::vector<uint8_t>(
+				handshake.begin(), handshake.begin() + size));
+	}
+
+	// Acknowledge every other port - the rest keep repeating the handshake
+	uint8_t ack[1];
+	Framing::frame_sys_message(ack, Magics::SYS::ACK);
+	for (size_t i = 0; i < PORTS; i += 2)
+		REQUIRE(write(ev3s[i].master, ack, sizeof(ack)) == 1);
+	run_for(farm, 60);
+
+	uint8_t expected[Framing::BUFFER_MIN];
+	for (size_t i = 0; i < PORTS; i++) {
+		const std::vector<uint8_t> bytes { ev3s[i].read_available() };
+		REQUIRE(bytes.size() > 0);
+		if (i % 2) {
+			REQUIRE(farm.machine(i).state() == StateMachine::State::WAIT_ACK);
+			REQUIRE(farm.stats(i).handshakes >= 2);
+			continue;
+		}
+		REQUIRE(farm.machine(i).state() == StateMachine::State::DATA);
+		REQUIRE(farm.stats(i).handshakes == 1);
+		const uint8_t payload { static_cast<uint8_t>(i) };
+		const int8_t len { Framing::frame_data_message(expected, 0, &payload,
+				1) };
+		REQUIRE(bytes.size() >= static_cast<size_t>(len));
+		REQUIRE(std::vector<uint8_t>(bytes.end() - len, bytes.end())
+				== std::vector<uint8_t>(expected, expected + len));
+	}
+}
+
+TEST_CASE("Sensor farms close ports that hang up", "[linux] [sensor_farm]") {
+	ConstantSampler sampler;
+	Linux::SensorFarm farm { sampler };
+	Ev3Side first, second;
+	REQUIRE(farm.add(ptsname(first.master), LegoSensors::GYRO) == 0);
+	REQUIRE(farm.add(ptsname(second.master), LegoSensors::ULTRASONIC) == 1);
+	run_for(farm, 2);
+
+	close(first.master);
+	first.master = -1;
+	run_for(farm, 2);
+	REQUIRE(farm.active() == 1);
+	REQUIRE(farm.stats(1).handshakes == 1);
+}
+
+TEST_CASE("Sensor farms reject invalid sensor descriptions",
+		"[linux] [sensor_farm]") {
+	ConstantSampler sampler;
+	Linux::SensorFarm farm { sampler };
+	Ev3Side ev3;
+	const Descriptor::SensorDescriptor invalid { 0x1d, 0, 0, 57600, nullptr };
+	REQUIRE(farm.add(ptsname(ev3.master), invalid) == -1);
+	REQUIRE(farm.size() == 0);
+}
+
+TEST_CASE("Sensor farms batch the I/O of their ports",
+		"[linux] [sensor_farm]") {
+	const StateMachine::Timing timing { 50, 1000, 5 };
+	ConstantSampler sampler;
+	Linux::SensorFarm farm { sampler, timing };
+	farm.batch_io();
+	std::array<Ev3Side, 4> ev3s;
+	for (Ev3Side& ev3 : ev3s)
+		REQUIRE(farm.add(ptsname(ev3.master), LegoSensors::COLOR) >= 0);
+
+	std::array<uint8_t, Descriptor::HANDSHAKE_MAX> handshake { };
+	const int16_t size { Descriptor::frame_handshake(handshake.data(),
+			handshake.size(), LegoSensors::COLOR) };
+	run_for(farm, 5);
+	uint8_t ack[1];
+	Framing::frame_sys_message(ack, Magics::SYS::ACK);
+	for (size_t i = 0; i < ev3s.size(); i++) {
+		REQUIRE(ev3s[i].read_available() == std::vector<uint8_t>(
+				handshake.begin(), handshake.begin() + size));
+		REQUIRE(write(ev3s[i].master, ack, sizeof(ack)) == 1);
+	}
+	run_for(farm, 60);
+
+	uint8_t expected[Framing::BUFFER_MIN];
+	for (size_t i = 0; i < ev3s.size(); i++) {
+		REQUIRE(farm.machine(i).state() == StateMachine::State::DATA);
+		REQUIRE(farm.stats(i).bytes_received == 1);
+		REQUIRE(farm.stats(i).bytes_dropped == 0);
+		const std::vector<uint8_t> bytes { ev3s[i].read_available() };
+		const uint8_t payload { static_cast<uint8_t>(i) };
+		const int8_t len { Framing::frame_data_message(expected, 0, &payload,
+				1) };
+		REQUIRE(bytes.size() >= static_cast<size_t>(len));
+		REQUIRE(std::vector<uint8_t>(bytes.end() - len, bytes.end())
+				== std::vector<uint8_t>(expected, expected + len));
+	}
+}
+
+TEST_CASE("Sensor farms drop whole messages when ttys are full",
+		"[linux] [sensor_farm]") {
+	const StateMachine::Timing timing { 50, 1000, 1 };
+	ConstantSampler sampler;
+	Linux::SensorFarm farm { sampler, timing };
+	SECTION("with direct writes") {
+	}
+	SECTION("with batched I/O") {
+		farm.batch_io();
+	}
+	Ev3Side ev3;
+	REQUIRE(farm.add(ptsname(ev3.master), LegoSensors::COLOR) == 0);
+	run_for(farm, 5);
+	uint8_t ack[1];
+	Framing::frame_sys_message(ack, Magics::SYS::ACK);
+	REQUIRE(write(ev3.master, ack, sizeof(ack)) == 1);
+	run_for(farm, 5);
+	REQUIRE(farm.machine(0).state() == StateMachine::State::DATA);
+	ev3.read_available();
+
+	// Stopped output makes every write fail, until the queue is full
+	const int slave { open(ptsname(ev3.master), O_RDWR | O_NOCTTY) };
+	REQUIRE(slave >= 0);
+	REQUIRE(tcflow(slave, TCOOFF) == 0);
+	run_for(farm, 400);
+	REQUIRE(tcflow(slave, TCOON) == 0);
+	close(slave);
+	run_for(farm, 5);
+
+	uint8_t expected[Framing::BUFFER_MIN];
+	const uint8_t payload { 0 };
+	const int8_t len { Framing::frame_data_message(expected, 0, &payload, 1) };
+	REQUIRE(farm.stats(0).bytes_dropped > 0);
+	REQUIRE(farm.stats(0).bytes_dropped % len == 0);
+	const std::vector<uint8_t> bytes { ev3.read_available() };
+	REQUIRE(bytes.size() > Linux::FARM_OUTPUT_MAX / 2);
+	REQUIRE(bytes.size() % len == 0);
+	for (size_t i = 0; i < bytes.size(); i += len)
+		REQUIRE(std::vector<uint8_t>(bytes.begin() + i, bytes.begin() + i + len)
+				== std::vector<uint8_t>(expected, expected + len));
+}
+
+TEST_CASE("Sensor farms switch baudrates without waiting for full ttys",
+		"[linux] [sensor_farm]") {
+	const StateMachine::Timing timing { 50, 200, 1 };
+	ConstantSampler sampler;
+	Linux::SensorFarm farm { sampler, timing };
+	std::array<Ev3Side, 2> ev3s;
+	for (Ev3Side& ev3 : ev3s)
+		REQUIRE(farm.add(ptsname(ev3.master), LegoSensors::COLOR) >= 0);
+	run_for(farm, 5);
+	uint8_t ack[1];
+	uint8_t nack[1];
+	Framing::frame_sys_message(ack, Magics::SYS::ACK);
+	Framing::frame_sys_message(nack, Magics::SYS::NACK);
+	for (Ev3Side& ev3 : ev3s)
+		REQUIRE(write(ev3.master, ack, sizeof(ack)) == 1);
+	run_for(farm, 5);
+	for (size_t i = 0; i < ev3s.size(); i++) {
+		REQUIRE(farm.machine(i).state() == StateMachine::State::DATA);
+		ev3s[i].read_available();
+	}
+
+	// The first EV3 stops reading, and its keepalive expires: the switch
+	// back to the handshake baudrate waits for a tty which stays full,
+	// while the second port carries on
+	const int slave { open(ptsname(ev3s[0].master), O_RDWR | O_NOCTTY) };
+	REQUIRE(slave >= 0);
+	REQUIRE(tcflow(slave, TCOOFF) == 0);
+	for (int i = 0; i < 20; i++) {
+		REQUIRE(write(ev3s[1].master, nack, sizeof(nack)) == 1);
+		run_for(farm, 20);
+		REQUIRE(ev3s[1].read_available().size() > 0);
+	}
+	REQUIRE(farm.machine(0).state() == StateMachine::State::WAIT_ACK);
+	REQUIRE(farm.machine(1).state() == StateMachine::State::DATA);
+	REQUIRE(farm.stats(0).bytes_dropped > 0);
+	struct termios tio;
+	REQUIRE(tcgetattr(slave, &tio) == 0);
+	REQUIRE(cfgetospeed(&tio) == B57600);
+
+	// Once the tty has room again, the switch completes
+	REQUIRE(tcflow(slave, TCOON) == 0);
+	for (int i = 0; i < 10; i++) {
+		ev3s[0].read_available();
+		run_for(farm, 10);
+	}
+	REQUIRE(tcgetattr(slave, &tio) == 0);
+	REQUIRE(cfgetospeed(&tio) == B2400);
+	REQUIRE(farm.machine(0).state() == StateMachine::State::WAIT_ACK);
+	close(slave);
+}
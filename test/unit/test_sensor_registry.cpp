@@ -0,0 +1,203 @@
+/**
+ * \file test_sensor_registry.cpp
+ *
+ * Tests for the host side sensor registry of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <sensor_registry.hpp>
+#include <lego_sensors.hpp>
+#include <sensor_descriptor.hpp>
+#include <framing.hpp>
+#include "catch.hpp"
+#include <array>
+#include <string>
+#include <vector>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	/**
+	 * Feeds the handshake of a sensor to a port of a registry.
+	 *
+	 * @return return value of SensorRegistry::receive() for the last message
+	 */
+	int8_t receive_handshake(Registry::SensorRegistry& registry, size_t port,
+			const Descriptor::SensorDescriptor& sensor) {
+		std::vector<uint8_t> stream(Descriptor::HANDSHAKE_MAX);
+		const int16_t size { Descriptor::frame_handshake(stream.data(),
+				stream.size(), sensor) };
+		REQUIRE(size > 0);
+
+		Decoding::FrameDecoder decoder;
+		Decoding::Frame frame;
+		int8_t result { -1 };
+		decoder.feed(stream.data(), size);
+		while (decoder.next(frame)) {
+			result = registry.receive(port, frame);
+			if (!frame.is(Magics::SYS::ACK))
+				REQUIRE(result == 0);
+		}
+		return result;
+	}
+}
+
+TEST_CASE("Handshakes are parsed into mode tables", "[sensor_registry]") {
+	std::array<Registry::SensorInfo, 3> table;
+	Registry::SensorRegistry registry { table.data(), table.size() };
+	REQUIRE(registry.size() == 3);
+
+	REQUIRE(receive_handshake(registry, 0, LegoSensors::COLOR) == 1);
+	REQUIRE(receive_handshake(registry, 2, LegoSensors::GYRO) == 1);
+
+	const Registry::SensorInfo& color { registry.sensor(0) };
+	REQUIRE(color.complete);
+	REQUIRE(color.type == LegoSensors::COLOR.type);
+	REQUIRE(color.mode_count == LegoSensors::COLOR.modes);
+	REQUIRE(color.modes_visible == LegoSensors::COLOR.modes_visible);
+	REQUIRE(color.speed == LegoSensors::COLOR.speed);
+	for (uint8_t mode = 0; mode < color.mode_count; mode++) {
+		const Descriptor::ModeDescriptor& expected {
+			LegoSensors::COLOR.mode_table[mode] };
+		const Registry::ModeInfo& info { color.modes[mode] };
+		REQUIRE(info.elems == expected.elems);
+		REQUIRE(info.data_type == expected.data_type);
+		REQUIRE(info.payload_size == info.elems * info.sample_size);
+		REQUIRE(std::string(color.details[mode].name) == expected.name);
+		REQUIRE(color.details[mode].raw.upper == expected.raw.upper);
+		REQUIRE(color.details[mode].width == expected.width);
+	}
+	REQUIRE(std::string(color.details[2].symbol) == "col");
+	REQUIRE(std::string(color.details[5].symbol) == "");
+
+	REQUIRE_FALSE(registry.sensor(1).complete);
+	REQUIRE(registry.sensor(2).type == LegoSensors::GYRO.type);
+
+	registry.reset(0);
+	REQUIRE_FALSE(registry.sensor(0).complete);
+	REQUIRE(registry.sensor(0).modes[0].sample_size == 0);
+}
+
+TEST_CASE("Parsed handshakes frame to the original handshake",
+		"[sensor_registry]") {
+	for (const char* name : { "color", "ultrasonic", "gyro" }) {
+		const Descriptor::SensorDescriptor& sensor { *LegoSensors::find(name) };
+		Registry::SensorInfo info;
+		Registry::SensorRegistry registry { &info, 1 };
+		REQUIRE(receive_handshake(registry, 0, sensor) == 1);
+
+		Descriptor::ModeDescriptor modes[Descriptor::MODES_MAX];
+		const Descriptor::SensorDescriptor parsed { info.descriptor(modes) };
+		std::array<uint8_t, Descriptor::HANDSHAKE_MAX> original { };
+		std::array<uint8_t, Descriptor::HANDSHAKE_MAX> reframed { };
+		const int16_t size { Descriptor::frame_handshake(original.data(),
+				original.size(), sensor) };
+		REQUIRE(Descriptor::frame_handshake(reframed.data(), reframed.size(),
+				parsed) == size);
+		REQUIRE(original == reframed);
+	}
+}
+
+TEST_CASE("Incomplete handshakes are rejected", "[sensor_registry]") {
+	Registry::SensorInfo info;
+	Registry::SensorRegistry registry { &info, 1 };
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	uint8_t* const dest { buffer.data() };
+	const auto receive = [&](int8_t size) {
+		return registry.receive(0, Decoding::Frame { dest,
+			static_cast<uint8_t>(size) });
+	};
+
+	REQUIRE(receive(Framing::frame_cmd_type_message(dest, 0x1d)) == 0);
+	REQUIRE(receive(Framing::frame_cmd_modes_message(dest, 1, 1)) == 0);
+	REQUIRE(receive(Framing::frame_cmd_speed_message(dest, 57600)) == 0);
+	REQUIRE(receive(Framing::frame_info_message_format(dest, 1, 2,
+			Magics::INFO_DTYPE::S16, 4, 0)) == 0);
+	// No INFO FORMAT for mode 0
+	REQUIRE(receive(Framing::frame_sys_message(dest, Magics::SYS::ACK)) == -1);
+	REQUIRE_FALSE(info.complete);
+
+	REQUIRE(receive(Framing::frame_info_message_format(dest, 0, 1,
+			Magics::INFO_DTYPE::S8, 3, 0)) == 0);
+	REQUIRE(receive(Framing::frame_sys_message(dest, Magics::SYS::ACK)) == 1);
+	REQUIRE(info.complete);
+
+	SECTION("Formats too large for a DATA message") {
+		REQUIRE(receive(Framing::frame_info_message_format(dest, 0, 9,
+				Magics::INFO_DTYPE::S32, 3, 0)) == -1);
+		REQUIRE(info.modes[0].elems == 1);
+	}
+
+	SECTION("CMD TYPE starts over") {
+		REQUIRE(receive(Framing::frame_cmd_type_message(dest, 0x1e)) == 0);
+		REQUIRE(info.type == 0x1e);
+		REQUIRE_FALSE(info.complete);
+		REQUIRE(info.modes[1].sample_size == 0);
+	}
+}
+
+TEST_CASE("DATA messages are decoded with a table lookup",
+		"[sensor_registry]") {
+	Registry::SensorInfo info;
+	Registry::SensorRegistry registry { &info, 1 };
+	REQUIRE(receive_handshake(registry, 0, LegoSensors::COLOR) == 1);
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	uint8_t* const dest { buffer.data() };
+	const auto frame = [&](int8_t size) {
+		return Decoding::Frame { dest, static_cast<uint8_t>(size) };
+	};
+	int32_t samples[Framing::PAYLOAD_SENSOR_TO_EV3_MAX];
+	float floats[Framing::PAYLOAD_SENSOR_TO_EV3_MAX];
+
+	// RGB-RAW, 3 x S16
+	const int16_t rgb[] { 1020, -1, 7 };
+	const int8_t size { Framing::frame_data_samples(dest, 4, rgb, 3,
+			Magics::INFO_DTYPE::S16) };
+	REQUIRE(registry.lookup(0, frame(size)) == &info.modes[4]);
+	REQUIRE(registry.decode(0, frame(size), samples) == 3);
+	REQUIRE(samples[0] == 1020);
+	REQUIRE(samples[1] == -1);
+	REQUIRE(samples[2] == 7);
+	REQUIRE(registry.decode(0, frame(size), floats) == 3);
+	REQUIRE(floats[1] == -1.0f);
+
+	// COL-REFLECT, 1 x S8
+	const int8_t reflect[] { -100 };
+	REQUIRE(registry.decode(0, frame(Framing::frame_data_samples(dest, 0,
+			reflect, 1, Magics::INFO_DTYPE::S8)), samples) == 1);
+	REQUIRE(samples[0] == -100);
+
+	// Too short for RGB-RAW
+	REQUIRE(registry.decode(0, frame(Framing::frame_data_samples(dest, 4, rgb,
+			1, Magics::INFO_DTYPE::S16)), samples) == -1);
+
+	// Modes without a format
+	REQUIRE(registry.decode(0, frame(Framing::frame_data_samples(dest, 7,
+			reflect, 1, Magics::INFO_DTYPE::S8)), samples) == -1);
+}
+
+TEST_CASE("F32 DATA messages are only decoded as floats",
+		"[sensor_registry]") {
+	Registry::SensorInfo info;
+	Registry::SensorRegistry registry { &info, 1 };
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+	uint8_t* const dest { buffer.data() };
+	const Decoding::Frame frame { dest, static_cast<uint8_t>(
+			Framing::frame_info_message_format(dest, 2, 2,
+					Magics::INFO_DTYPE::F32, 4, 2)) };
+	REQUIRE(registry.receive(0, frame) == 0);
+
+	const float values[] { 1.5f, -2.25f };
+	const Decoding::Frame data { dest, static_cast<uint8_t>(
+			Framing::frame_data_samples(dest, 2, values, 2,
+					Magics::INFO_DTYPE::F32)) };
+	int32_t samples[Framing::PAYLOAD_SENSOR_TO_EV3_MAX];
+	float floats[Framing::PAYLOAD_SENSOR_TO_EV3_MAX];
+	REQUIRE(registry.decode(0, data, samples) == -1);
+	REQUIRE(registry.decode(0, data, floats) == 2);
+	REQUIRE(floats[0] == 1.5f);
+	REQUIRE(floats[1] == -2.25f);
+}
@@ -0,0 +1,201 @@
+/**
+ * \file test_sensor_state_machine.cpp
+ *
+ * Tests for the sensor side protocol state machine of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <sensor_state_machine.hpp>
+#include "catch.hpp"
+#include <array>
+#include <vector>
+
+namespace {
+	using namespace EV3UartGenerator;
+	using Magics::INFO_DTYPE;
+
+	constexpr Descriptor::SpanDescriptor NO_SPAN { false, 0, 0 };
+	const Descriptor::ModeDescriptor modes[] {
+		{ "COL-REFLECT", { true, 0, 100 }, NO_SPAN, { true, 0, 100 }, "pct",
+				1, INFO_DTYPE::S8, 3, 0 },
+		{ "RGB-RAW", { true, 0, 1020.1875 }, NO_SPAN, { true, 0, 1020.1875 },
+				nullptr, 3, INFO_DTYPE::S16, 4, 0 },
+	};
+	const Descriptor::SensorDescriptor sensor { 0x1d, 2, 2, 57600, modes };
+
+	/**
+	 * Records everything the state machine does.
+	 */
+	class RecordingIo : public StateMachine::SensorIo {
+	public:
+		void write(const uint8_t* buf, size_t len) override {
+			writes.emplace_back(buf, buf + len);
+		}
+
+		void set_baud(uint32_t baud) override {
+			bauds.push_back(baud);
+		}
+
+		uint8_t sample(uint8_t mode, uint8_t* payload) override {
+			payload[0] = mode;
+			payload[1] = 0x55;
+			return 2;
+		}
+
+		void selected(uint8_t mode) override {
+			selections.push_back(mode);
+		}
+
+		void written(const uint8_t* data, uint8_t len) override {
+			received.assign(data, data + len);
+		}
+
+		std::vector<uint8_t> data_message(uint8_t mode) {
+			const uint8_t payload[] { mode, 0x55 };
+			std::array<uint8_t, Framing::BUFFER_MIN> message { };
+			const int8_t size { Framing::frame_data_message(message.data(),
+					mode, payload, sizeof(payload)) };
+			return std::vector<uint8_t>(message.begin(),
+					message.begin() + size);
+		}
+
+		std::vector<std::vector<uint8_t>> writes;
+		std::vector<uint32_t> bauds;
+		std::vector<uint8_t> selections;
+		std::vector<uint8_t> received;
+	};
+
+	std::vector<uint8_t> sys(Magics::SYS type) {
+		uint8_t message[1];
+		Framing::frame_sys_message(message, type);
+		return std::vector<uint8_t>(message, message + 1);
+	}
+
+	std::vector<uint8_t> select(uint8_t mode) {
+		std::array<uint8_t, Framing::BUFFER_MIN> message { };
+		const int8_t size { Framing::frame_cmd_select_message(message.data(),
+				mode) };
+		return std::vector<uint8_t>(message.begin(), message.begin() + size);
+	}
+}
+
+TEST_CASE("Handshake is sent and repeated until acknowledged",
+		"[state_machine]") {
+	using StateMachine::State;
+	std::array<uint8_t, 0x200> handshake { };
+	const int16_t size { Descriptor::frame_handshake(handshake.data(),
+			handshake.size(), sensor) };
+	REQUIRE(size > 0);
+	RecordingIo io;
+	StateMachine::SensorStateMachine machine { io, sensor, handshake.data(),
+			static_cast<size_t>(size) };
+
+	REQUIRE(machine.state() == State::IDLE);
+	machine.begin(1000);
+	REQUIRE(io.bauds == std::vector<uint32_t> { StateMachine::HANDSHAKE_BAUD });
+	REQUIRE(machine.next_deadline() == 1000);
+
+	machine.poll(1000);
+	REQUIRE(machine.state() == State::WAIT_ACK);
+	REQUIRE(io.writes.size() == 1);
+	REQUIRE(io.writes[0] == std::vector<uint8_t>(handshake.begin(),
+			handshake.begin() + size));
+
+	// Not yet due
+	machine.poll(1000 + StateMachine::DEFAULT_TIMING.handshake_retry - 1);
+	REQUIRE(io.writes.size() == 1);
+	machine.poll(1000 + StateMachine::DEFAULT_TIMING.handshake_retry);
+	REQUIRE(io.writes.size() == 2);
+	REQUIRE(io.writes[1] == io.writes[0]);
+
+	// Anything other than ACK is ignored
+	const auto nack = sys(Magics::SYS::NACK);
+	machine.receive(nack.data(), nack.size(), 1600);
+	REQUIRE(machine.state() == State::WAIT_ACK);
+
+	const auto ack = sys(Magics::SYS::ACK);
+	machine.receive(ack.data(), ack.size(), 1600);
+	REQUIRE(machine.state() == State::DATA);
+	REQUIRE(io.bauds.back() == 57600);
+}
+
+TEST_CASE("DATA messages are streamed, and keepalives are answered",
+		"[state_machine]") {
+	using StateMachine::State;
+	const uint8_t handshake[] { 0x04 };
+	const StateMachine::Timing timing { 100, 300, 10 };
+	RecordingIo io;
+	StateMachine::SensorStateMachine machine { io, sensor, handshake,
+			sizeof(handshake), timing };
+	machine.begin(0);
+	machine.poll(0);
+	const auto ack = sys(Magics::SYS::ACK);
+	machine.receive(ack.data(), ack.size(), 5);
+	io.writes.clear();
+
+	SECTION("DATA messages are sent at the configured interval") {
+		machine.poll(5);
+		REQUIRE(io.writes.size() == 1);
+		REQUIRE(io.writes[0] == io.data_message(0));
+		REQUIRE(machine.next_deadline() == 15);
+		machine.poll(14);
+		REQUIRE(io.writes.size() == 1);
+		machine.poll(15);
+		REQUIRE(io.writes.size() == 2);
+		// After a stall, the stream resumes without a burst
+		machine.poll(100);
+		machine.poll(101);
+		REQUIRE(io.writes.size() == 3);
+		REQUIRE(machine.next_deadline() == 110);
+	}
+
+	SECTION("NACK is answered with a DATA message immediately") {
+		const auto nack = sys(Magics::SYS::NACK);
+		machine.receive(nack.data(), nack.size(), 200);
+		REQUIRE(io.writes.size() == 1);
+		REQUIRE(io.writes[0] == io.data_message(0));
+		// And pushes back the keepalive timeout
+		machine.poll(304);
+		REQUIRE(machine.state() == State::DATA);
+	}
+
+	SECTION("Missing keepalives restart the handshake") {
+		machine.poll(305);
+		REQUIRE(machine.state() == State::WAIT_ACK);
+		REQUIRE(io.bauds.back() == StateMachine::HANDSHAKE_BAUD);
+		REQUIRE(io.writes.back() == std::vector<uint8_t> { 0x04 });
+		REQUIRE(machine.next_deadline() == 405);
+	}
+
+	SECTION("SELECT changes the mode of DATA messages") {
+		const auto message = select(1);
+		machine.receive(message.data(), message.size(), 7);
+		REQUIRE(machine.mode() == 1);
+		REQUIRE(io.selections == std::vector<uint8_t> { 1 });
+		REQUIRE(io.writes.size() == 1);
+		REQUIRE(io.writes[0] == io.data_message(1));
+		REQUIRE(machine.next_deadline() == 17);
+	}
+
+	SECTION("SELECT of a mode the sensor does not have is ignored") {
+		const auto message = select(2);
+		machine.receive(message.data(), message.size(), 7);
+		REQUIRE(machine.mode() == 0);
+		REQUIRE(io.selections.empty());
+		REQUIRE(io.writes.empty());
+	}
+
+	SECTION("WRITE is passed on to the sensor") {
+		std::array<uint8_t, Framing::BUFFER_MIN> message { };
+		const uint8_t data[] { 0x01, 0x02, 0x03 };
+		const int8_t size { Framing::frame_cmd_write_message(message.data(),
+				data, sizeof(data)) };
+		// Bytes can arrive one by one
+		for (int8_t i = 0; i < size; i++)
+			machine.receive(&message[i], 1, 7);
+		REQUIRE(io.received == std::vector<uint8_t> { 0x01, 0x02, 0x03, 0x00 });
+	}
+}
@@ -0,0 +1,102 @@
+/**
+ * \file test_simple_endian.cpp
+ *
+ * Tests for the endianess conversion functions of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <simple_endian.hpp>
+#include "catch.hpp"
+#include <array>
+#include <cstring>
+
+using namespace EV3UartGenerator;
+
+static_assert(SimpleEndian::from_le16(SimpleEndian::to_le16(0x1234)) == 0x1234,
+		"16-bit conversions are usable in constant expressions");
+static_assert(SimpleEndian::from_le32(SimpleEndian::to_le32(0x12345678))
+		== 0x12345678, "32-bit conversions are usable in constant expressions");
+// The <endian.h> names survive the C library defining them as macros
+static_assert((SimpleEndian::htole32)(0x12345678)
+		== SimpleEndian::to_le32(0x12345678), "htole32 is still usable");
+
+TEST_CASE("Integers are converted to and from little-endian bytes",
+		"[endian] [store_le16()] [store_le32()] [load_le16()] [load_le32()]") {
+	std::array<uint8_t, 5> bytes { };
+
+	SimpleEndian::store_le16(bytes.data() + 1, 0x0102);
+	REQUIRE(bytes == (std::array<uint8_t, 5> { 0x00, 0x02, 0x01, 0x00, 0x00 }));
+	REQUIRE(SimpleEndian::load_le16(bytes.data() + 1) == 0x0102);
+
+	SimpleEndian::store_le32(bytes.data() + 1, 0x01020304);
+	REQUIRE(bytes == (std::array<uint8_t, 5> { 0x00, 0x04, 0x03, 0x02, 0x01 }));
+	REQUIRE(SimpleEndian::load_le32(bytes.data() + 1) == 0x01020304);
+
+	// Speed of the LEGO sensors, as in doc/reference_bitstreams
+	SimpleEndian::store_le32(bytes.data(), 57600);
+	REQUIRE(bytes[0] == 0x00);
+	REQUIRE(bytes[1] == 0xe1);
+	REQUIRE(bytes[2] == 0x00);
+	REQUIRE(bytes[3] == 0x00);
+}
+
+TEST_CASE("Floats are converted to and from little-endian bytes",
+		"[endian] [store_le_f32()] [load_le_f32()]") {
+	std::array<uint8_t, 4> bytes { };
+
+	SimpleEndian::store_le_f32(bytes.data(), 1020.0f);
+	REQUIRE(bytes == (std::array<uint8_t, 4> { 0x00, 0x00, 0x7f, 0x44 }));
+	REQUIRE(SimpleEndian::load_le_f32(bytes.data()) == 1020.0f);
+
+	SimpleEndian::store_le_f32(bytes.data(), -1.0f);
+	REQUIRE(bytes == (std::array<uint8_t, 4> { 0x00, 0x00, 0x80, 0xbf }));
+	REQUIRE(SimpleEndian::load_le_f32(bytes.data()) == -1.0f);
+}
+
+TEST_CASE("Arrays are converted to and from little-endian bytes",
+		"[endian] [store_le()] [load_le()]") {
+	std::array<uint8_t, 0x20> bytes { };
+
+	SECTION("16-bit samples") {
+		const int16_t samples[] { 0x0102, -2, 0x7fff };
+		int16_t loaded[3] { };
+		SimpleEndian::store_le(bytes.data(), samples, 3);
+		for (uint8_t i = 0; i < 3; i++)
+			REQUIRE(SimpleEndian::load_le16(bytes.data() + (i * 2))
+					== static_cast<uint16_t>(samples[i]));
+		SimpleEndian::load_le(loaded, bytes.data(), 3);
+		REQUIRE(std::memcmp(loaded, samples, sizeof(samples)) == 0);
+	}
+
+	SECTION("32-bit samples") {
+		const int32_t samples[] { 0x01020304, -2 };
+		int32_t loaded[2] { };
+		SimpleEndian::store_le(bytes.data(), samples, 2);
+		REQUIRE(SimpleEndian::load_le32(bytes.data()) == 0x01020304);
+		REQUIRE(SimpleEndian::load_le32(bytes.data() + 4) == 0xfffffffe);
+		SimpleEndian::load_le(loaded, bytes.data(), 2);
+		REQUIRE(std::memcmp(loaded, samples, sizeof(samples)) == 0);
+	}
+
+	SECTION("Float samples") {
+		const float samples[] { 1020.0f, -1.0f, 0.5f };
+		float loaded[3] { };
+		SimpleEndian::store_le(bytes.data(), samples, 3);
+		for (uint8_t i = 0; i < 3; i++)
+			REQUIRE(SimpleEndian::load_le_f32(bytes.data() + (i * 4))
+					== samples[i]);
+		SimpleEndian::load_le(loaded, bytes.data(), 3);
+		REQUIRE(std::memcmp(loaded, samples, sizeof(samples)) == 0);
+	}
+
+	SECTION("8-bit samples are copied") {
+		const int8_t samples[] { -1, 2, 3 };
+		SimpleEndian::store_le(bytes.data(), samples, 3);
+		REQUIRE(bytes[0] == 0xff);
+		REQUIRE(bytes[1] == 0x02);
+		REQUIRE(bytes[2] == 0x03);
+	}
+}
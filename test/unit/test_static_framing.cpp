@@ -0,0 +1,157 @@
+/**
+ * \file test_static_framing.cpp
+ *
+ * Tests for the compile time framing portion of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <static_framing.hpp>
+#include "catch.hpp"
+#include <array>
+#include <numeric>
+#include <cstring>
+#include <cmath>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	template <size_t N>
+	bool matches(const StaticFraming::Message<N>& msg, const uint8_t* ref,
+			int8_t ref_len) {
+		return (ref_len == static_cast<int8_t>(N)) &&
+				std::equal(msg.bytes, msg.bytes + N, ref);
+	}
+
+	constexpr auto color_sensor = StaticFraming::handshake(
+			StaticFraming::cmd_type(0x1d),
+			StaticFraming::cmd_modes(0x05, 0x02),
+			StaticFraming::cmd_speed(57600),
+			StaticFraming::info_name(5, "COL-CAL"),
+			StaticFraming::info_span(5, Magics::INFO_SPAN::RAW, 0, 65535),
+			StaticFraming::info_span(5, Magics::INFO_SPAN::SI, 0, 65535),
+			StaticFraming::info_format(5, 4, Magics::INFO_DTYPE::S16, 5, 0),
+			StaticFraming::info_name(2, "COL-COLOR"),
+			StaticFraming::info_symbol(2, "col"),
+			StaticFraming::info_format(2, 1, Magics::INFO_DTYPE::S8, 2, 0),
+			StaticFraming::sys(Magics::SYS::ACK));
+
+	static_assert(color_sensor.size() == (3 + 4 + 6 + 11 + 11 + 11 + 7
+			+ 19 + 11 + 7 + 1), "Handshake size is computed at compile time");
+	static_assert(color_sensor[0] == 0x40, "CMD TYPE is framed at compile time");
+	static_assert(color_sensor[2] == 0xa2, "Checksums are computed at compile time");
+	static_assert(StaticFraming::float_bits(1.0f) == 0x3f800000, "");
+	static_assert(StaticFraming::float_bits(-2.5f) == 0xc0200000, "");
+}
+
+TEST_CASE("Compile time messages match run time messages",
+		"[static_frame]") {
+	using namespace EV3UartGenerator;
+	std::array<uint8_t, Framing::BUFFER_MIN> buffer { };
+
+	SECTION("SYS messages") {
+		int8_t s = Framing::frame_sys_message(buffer.data(), Magics::SYS::ACK);
+		REQUIRE(matches(StaticFraming::sys(Magics::SYS::ACK), buffer.data(), s));
+	}
+
+	SECTION("CMD messages") {
+		for (uint16_t type = 0; type < 0x100; type++) {
+			int8_t s = Framing::frame_cmd_type_message(buffer.data(), type);
+			REQUIRE(matches(StaticFraming::cmd_type(type), buffer.data(), s));
+		}
+		for (uint8_t modes = 0; modes < 0x10; modes++) {
+			int8_t s = Framing::frame_cmd_modes_message(buffer.data(), modes,
+					0x0f - modes);
+			REQUIRE(matches(StaticFraming::cmd_modes(modes, 0x0f - modes),
+					buffer.data(), s));
+		}
+		int8_t s = Framing::frame_cmd_speed_message(buffer.data(), 0xdeadbeef);
+		REQUIRE(matches(StaticFraming::cmd_speed(0xdeadbeef), buffer.data(), s));
+	}
+
+	SECTION("INFO messages") {
+		int8_t s = Framing::frame_info_message_name(buffer.data(), 1, "A");
+		REQUIRE(matches(StaticFraming::info_name(1, "A"), buffer.data(), s));
+		s = Framing::frame_info_message_name(buffer.data(), 9, "COL-AMBIENT");
+		REQUIRE(matches(StaticFraming::info_name(9, "COL-AMBIENT"),
+				buffer.data(), s));
+		s = Framing::frame_info_message_name(buffer.data(), 7,
+				"ABCDEFGHIJKLMNOPQRSTUVWXYZ012345");
+		REQUIRE(matches(StaticFraming::info_name(7,
+				"ABCDEFGHIJKLMNOPQRSTUVWXYZ012345"), buffer.data(), s));
+
+		s = Framing::frame_info_message_symbol(buffer.data(), 3, "pct");
+		REQUIRE(matches(StaticFraming::info_symbol(3, "pct"),
+				buffer.data(), s));
+		s = Framing::frame_info_message_symbol(buffer.data(), 3, "ABCDEFGH");
+		REQUIRE(matches(StaticFraming::info_symbol(3, "ABCDEFGH"),
+				buffer.data(), s));
+
+		s = Framing::frame_info_message_format(buffer.data(), 4, 3,
+				Magics::INFO_DTYPE::S16, 4, 0);
+		REQUIRE(matches(StaticFraming::info_format(4, 3,
+				Magics::INFO_DTYPE::S16, 4, 0), buffer.data(), s));
+	}
+
+	SECTION("SPAN messages, including float conversion") {
+		const float values[] { 0.0f, 1.0f, -1.0f, 100.0f, 1020.188f,
+			65535.0f, -32768.0f, 1e-3f, 1e-40f, M_PI, -M_E,
+			__FLT_MAX__, __FLT_MIN__ };
+		for (float lower : values) {
+			for (float upper : values) {
+				int8_t s = Framing::frame_info_message_span(buffer.data(), 6,
+						Magics::INFO_SPAN::PCT, lower, upper);
+				REQUIRE(matches(StaticFraming::info_span(6,
+						Magics::INFO_SPAN::PCT, lower, upper), buffer.data(), s));
+			}
+		}
+	}
+}
+
+TEST_CASE("Compile time handshakes concatenate messages in order",
+		"[static_frame] [handshake()]") {
+	using namespace EV3UartGenerator;
+	std::array<uint8_t, 0x80> buffer { };
+	uint8_t* dest { buffer.data() };
+
+	dest += Framing::frame_cmd_type_message(dest, 0x1d);
+	dest += Framing::frame_cmd_modes_message(dest, 0x05, 0x02);
+	dest += Framing::frame_cmd_speed_message(dest, 57600);
+	dest += Framing::frame_info_message_name(dest, 5, "COL-CAL");
+	dest += Framing::frame_info_message_span(dest, 5,
+			Magics::INFO_SPAN::RAW, 0, 65535);
+	dest += Framing::frame_info_message_span(dest, 5,
+			Magics::INFO_SPAN::SI, 0, 65535);
+	dest += Framing::frame_info_message_format(dest, 5, 4,
+			Magics::INFO_DTYPE::S16, 5, 0);
+	dest += Framing::frame_info_message_name(dest, 2, "COL-COLOR");
+	dest += Framing::frame_info_message_symbol(dest, 2, "col");
+	dest += Framing::frame_info_message_format(dest, 2, 1,
+			Magics::INFO_DTYPE::S8, 2, 0);
+	dest += Framing::frame_sys_message(dest, Magics::SYS::ACK);
+
+	REQUIRE(static_cast<size_t>(dest - buffer.data()) == color_sensor.size());
+	REQUIRE(std::equal(color_sensor.begin(), color_sensor.end(),
+			buffer.data()));
+}
+
+TEST_CASE("Compile time checksum() and insert_padding() match run time "
+		"versions", "[static_frame]") {
+	using namespace EV3UartGenerator;
+	std::array<uint8_t, 0xff> buffer { };
+	std::iota(buffer.begin(), buffer.end(), 0);
+	for (uint16_t i = 0; i < 0x100; i++)
+		REQUIRE(StaticFraming::checksum(buffer.data(), i)
+				== Framing::checksum(buffer.data(), i));
+
+	for (uint8_t i = Framing::PAYLOAD_MIN;
+			i <= Framing::PAYLOAD_SENSOR_TO_EV3_MAX; i++) {
+		buffer.fill(0xff);
+		REQUIRE(StaticFraming::insert_padding(buffer.data(), i)
+				== Framing::insert_padding(buffer.data() + 0x80, i));
+		REQUIRE(std::equal(buffer.data(), buffer.data() + 0x20,
+				buffer.data() + 0x80));
+	}
+}
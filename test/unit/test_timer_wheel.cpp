@@ -0,0 +1,211 @@
+/**
+ * \file test_timer_wheel.cpp
+ *
+ * Tests for the Linux timer wheel of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <linux/timer_wheel.hpp>
+#include "catch.hpp"
+#include <memory>
+#include <random>
+#include <vector>
+#include <poll.h>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	/**
+	 * Timer recording its expirations into a shared log.
+	 */
+	struct LogTimer final : public Linux::Timer {
+		std::vector<const LogTimer*>* log { nullptr };
+		uint32_t expired_at { 0 };
+		uint32_t expirations { 0 };
+
+		void expire(uint32_t now) override {
+			expired_at = now;
+			expirations++;
+			if (log != nullptr)
+				log->push_back(this);
+		}
+	};
+
+	/**
+	 * Timer rescheduling itself at a fixed period.
+	 */
+	struct PeriodicTimer final : public Linux::Timer {
+		explicit PeriodicTimer(Linux::TimerWheel& wheel, uint32_t period)
+			: wheel(wheel), period { period } {
+		}
+
+		void expire(uint32_t) override {
+			expirations++;
+			wheel.schedule(*this, deadline() + period);
+		}
+
+		Linux::TimerWheel& wheel;
+		const uint32_t period;
+		uint32_t expirations { 0 };
+	};
+}
+
+TEST_CASE("Timers expire at their deadlines", "[linux] [timer_wheel]") {
+	for (const uint32_t start : { 0u, 0x3fu, 0xfffff000u }) {
+		INFO("start " << start);
+		Linux::TimerWheel wheel { start };
+		std::vector<const LogTimer*> log;
+		LogTimer timers[5];
+		const uint32_t delays[] { 0, 1, 63, 64, 5000 };
+		for (size_t i = 0; i < 5; i++) {
+			timers[i].log = &log;
+			wheel.schedule(timers[i], start + delays[i]);
+		}
+		REQUIRE(wheel.size() == 5);
+		REQUIRE(wheel.timeout(start) == 0);
+
+		REQUIRE(wheel.advance(start) == 1);
+		REQUIRE(wheel.timeout(start) == 1);
+		REQUIRE(wheel.advance(start + 62) == 1);
+		REQUIRE(wheel.advance(start + 64) == 2);
+		REQUIRE(wheel.advance(start + 4999) == 0);
+		REQUIRE(wheel.size() == 1);
+		REQUIRE(timers[4].pending());
+		REQUIRE(wheel.advance(start + 6000) == 1);
+		REQUIRE(timers[4].expired_at == start + 6000);
+		REQUIRE_FALSE(timers[4].pending());
+		REQUIRE(wheel.timeout(start + 6000) == -1);
+
+		REQUIRE(log.size() == 5);
+		for (size_t i = 0; i < 5; i++)
+			REQUIRE(log[i] == &timers[i]);
+	}
+}
+
+TEST_CASE("Timers are cancelled and rescheduled", "[linux] [timer_wheel]") {
+	Linux::TimerWheel wheel { 1000 };
+	LogTimer a;
+	LogTimer b;
+	wheel.schedule(a, 1100);
+	wheel.schedule(b, 1200);
+
+	wheel.cancel(a);
+	REQUIRE_FALSE(a.pending());
+	REQUIRE(wheel.size() == 1);
+	wheel.cancel(a); // Cancelling twice is harmless
+
+	wheel.schedule(b, 100000); // Moved further away, to another level
+	REQUIRE(wheel.size() == 1);
+	REQUIRE(wheel.advance(50000) == 0);
+	wheel.schedule(b, 50010); // And back down
+	REQUIRE(wheel.advance(50010) == 1);
+	REQUIRE(b.expired_at == 50010);
+	REQUIRE(a.expirations == 0);
+	REQUIRE(wheel.size() == 0);
+}
+
+TEST_CASE("Timers reschedule themselves when they expire",
+		"[linux] [timer_wheel]") {
+	Linux::TimerWheel wheel { 0 };
+	PeriodicTimer data { wheel, 10 };
+	PeriodicTimer slow { wheel, 1000 };
+	wheel.schedule(data, 10);
+	wheel.schedule(slow, 1000);
+
+	// One call to advance() expires a periodic timer as often as it is due
+	REQUIRE(wheel.advance(95) == 9);
+	for (uint32_t now = 96; now < 10000; now += 7)
+		wheel.advance(now);
+	wheel.advance(10000);
+	REQUIRE(data.expirations == 1000);
+	REQUIRE(slow.expirations == 10);
+	REQUIRE(data.deadline() == 10010);
+	REQUIRE(wheel.size() == 2);
+}
+
+TEST_CASE("Timers beyond the range of the wheel expire on time",
+		"[linux] [timer_wheel]") {
+	Linux::TimerWheel wheel { 0 };
+	LogTimer far;
+	const uint32_t deadline { (3 * Linux::TIMER_RANGE) + 12345 };
+	wheel.schedule(far, deadline);
+
+	uint32_t now { 0 };
+	while (now < (deadline - 1)) {
+		const int32_t timeout { wheel.timeout(now) };
+		REQUIRE(timeout > 0);
+		now = ((now + timeout) < (deadline - 1)) ? (now + timeout)
+				: (deadline - 1);
+		REQUIRE(wheel.advance(now) == 0);
+	}
+	REQUIRE(wheel.timeout(now) == 1);
+	REQUIRE(wheel.advance(deadline) == 1);
+	REQUIRE(far.expired_at == deadline);
+}
+
+TEST_CASE("Timer wheels expire random timers in order",
+		"[linux] [timer_wheel]") {
+	std::mt19937 random { 0x5eed };
+	std::uniform_int_distribution<uint32_t> delays[] {
+		std::uniform_int_distribution<uint32_t> { 0, 100 },
+		std::uniform_int_distribution<uint32_t> { 0, 100000 },
+		std::uniform_int_distribution<uint32_t> { 0, 2 * Linux::TIMER_RANGE },
+	};
+	std::uniform_int_distribution<uint32_t> steps { 0, 20000 };
+
+	uint32_t now { 0xffff0000u }; // Wraps around during the test
+	Linux::TimerWheel wheel { now };
+	std::vector<const LogTimer*> log;
+	std::vector<std::unique_ptr<LogTimer>> timers;
+	for (size_t i = 0; i < 3000; i++) {
+		timers.emplace_back(new LogTimer());
+		timers.back()->log = &log;
+		wheel.schedule(*timers.back(), now + delays[i % 3](random));
+	}
+
+	for (bool first = true; wheel.size() > 0; first = false) {
+		const uint32_t previous { now };
+		now += steps(random);
+		log.clear();
+		wheel.advance(now);
+		for (size_t i = 0; i < log.size(); i++) {
+			const int32_t late { static_cast<int32_t>(now - log[i]->deadline()) };
+			const int32_t after_previous { static_cast<int32_t>(
+					log[i]->deadline() - previous) };
+			REQUIRE(late >= 0);
+			REQUIRE(after_previous > (first ? -1 : 0));
+			if (i > 0)
+				REQUIRE(static_cast<int32_t>(log[i]->deadline()
+						- log[i - 1]->deadline()) >= 0);
+		}
+		// Every pending timer is still in the future
+		const int32_t timeout { wheel.timeout(now) };
+		REQUIRE(timeout != 0);
+	}
+	for (const std::unique_ptr<LogTimer>& timer : timers)
+		REQUIRE(timer->expirations == 1);
+}
+
+TEST_CASE("Timer wheels arm their timerfd", "[linux] [timer_wheel]") {
+	Linux::TimerWheel wheel { 0 };
+	REQUIRE(wheel.arm(0) == -1);
+	REQUIRE(wheel.open() == 0);
+	REQUIRE(wheel.fd() >= 0);
+
+	struct pollfd pfd { wheel.fd(), POLLIN, 0 };
+	REQUIRE(wheel.arm(0) == 0); // Nothing pending, disarmed
+	REQUIRE(poll(&pfd, 1, 20) == 0);
+
+	LogTimer timer;
+	wheel.schedule(timer, 5);
+	REQUIRE(wheel.arm(0) == 0);
+	REQUIRE(poll(&pfd, 1, 1000) == 1);
+
+	// Re-arming clears the expiration
+	wheel.cancel(timer);
+	REQUIRE(wheel.arm(5) == 0);
+	REQUIRE(poll(&pfd, 1, 0) == 0);
+}
@@ -0,0 +1,149 @@
+/**
+ * \file test_transport.cpp
+ *
+ * Tests for the Linux serial transport of EV3UartGenerator.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for details
+ */
+
+#include <linux/transport.hpp>
+#include <framing.hpp>
+#include "catch.hpp"
+#include <array>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+	/**
+	 * Pseudo-terminal pair, standing in for a tty wired to an EV3.
+	 */
+	struct PtyPair {
+		int master;
+		int slave;
+
+		PtyPair() {
+			master = posix_openpt(O_RDWR | O_NOCTTY);
+			grantpt(master);
+			unlockpt(master);
+			slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+		}
+
+		~PtyPair() {
+			close(master);
+		}
+
+		std::vector<uint8_t> read_master(size_t len) {
+			std::vector<uint8_t> bytes;
+			uint8_t buf[0x100];
+			while (bytes.size() < len) {
+				const ssize_t got { read(master, buf, sizeof(buf)) };
+				if (got <= 0)
+					break;
+				bytes.insert(bytes.end(), buf, buf + got);
+			}
+			return bytes;
+		}
+	};
+}
+
+TEST_CASE("Transports place ttys in raw mode", "[linux] [transport]") {
+	using namespace EV3UartGenerator;
+	PtyPair pty;
+	REQUIRE(pty.slave >= 0);
+
+	Linux::Transport transport;
+	REQUIRE(transport.adopt(pty.slave) == 0);
+	REQUIRE(transport.baud() == Linux::HANDSHAKE_BAUD);
+
+	struct termios tio;
+	REQUIRE(tcgetattr(transport.fd(), &tio) == 0);
+	REQUIRE((tio.c_lflag & (ICANON | ECHO)) == 0);
+	REQUIRE(cfgetospeed(&tio) == B2400);
+
+	SECTION("standard baudrates are applied") {
+		REQUIRE(transport.set_baud(57600) == 0);
+		REQUIRE(tcgetattr(transport.fd(), &tio) == 0);
+		REQUIRE(cfgetospeed(&tio) == B57600);
+		REQUIRE(transport.baud() == 57600);
+	}
+
+	SECTION("unsupported baudrates are rejected") {
+		REQUIRE(transport.set_baud(12345) == -1);
+		REQUIRE(errno == EINVAL);
+		REQUIRE(transport.baud() == Linux::HANDSHAKE_BAUD);
+	}
+
+	SECTION("buffers are written whole") {
+		std::array<uint8_t, 0x200> buf { };
+		for (size_t i = 0; i < buf.size(); i++)
+			buf[i] = static_cast<uint8_t>(i);
+		REQUIRE(transport.write(buf.data(), buf.size()) == 0x200);
+		const std::vector<uint8_t> got { pty.read_master(buf.size()) };
+		REQUIRE(std::equal(buf.begin(), buf.end(), got.begin()));
+	}
+}
+
+TEST_CASE("Transports run the handshake and switch baudrates",
+		"[linux] [transport]") {
+	using namespace EV3UartGenerator;
+	PtyPair pty;
+	Linux::Transport transport;
+	REQUIRE(transport.adopt(pty.slave) == 0);
+
+	std::array<uint8_t, Framing::BUFFER_MIN> type { };
+	std::array<uint8_t, Framing::BUFFER_MIN> speed { };
+	std::array<uint8_t, Framing::BUFFER_MIN> ack { };
+	struct iovec iov[] {
+		{ type.data(), static_cast<size_t>(
+				Framing::frame_cmd_type_message(type.data(), 0x1d)) },
+		{ speed.data(), static_cast<size_t>(
+				Framing::frame_cmd_speed_message(speed.data(), 57600)) },
+		{ ack.data(), static_cast<size_t>(
+				Framing::frame_sys_message(ack.data(), Magics::SYS::ACK)) },
+	};
+	const size_t total { iov[0].iov_len + iov[1].iov_len + iov[2].iov_len };
+
+	SECTION("the baudrate is switched after the EV3 acknowledges") {
+		// NACK is ignored, only ACK completes the handshake
+		const uint8_t reply[] { static_cast<uint8_t>(Magics::SYS::NACK),
+			static_cast<uint8_t>(Magics::SYS::ACK) };
+		REQUIRE(write(pty.master, reply, sizeof(reply)) == sizeof(reply));
+
+		REQUIRE(transport.handshake(iov, 3, 57600, 1000) == 0);
+		REQUIRE(transport.baud() == 57600);
+
+		const std::vector<uint8_t> got { pty.read_master(total) };
+		REQUIRE(got.size() == total);
+		REQUIRE(std::equal(type.data(), type.data() + iov[0].iov_len,
+				got.begin()));
+		REQUIRE(got.back() == static_cast<uint8_t>(Magics::SYS::ACK));
+	}
+
+	SECTION("negative timeouts wait for the acknowledgement") {
+		ssize_t replied { 0 };
+		std::thread ev3 { [&pty, &replied] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			const uint8_t reply { static_cast<uint8_t>(Magics::SYS::ACK) };
+			replied = write(pty.master, &reply, sizeof(reply));
+		} };
+		const int result { transport.handshake(iov, 3, 57600, -1) };
+		ev3.join();
+		REQUIRE(replied == 1);
+		REQUIRE(result == 0);
+		REQUIRE(transport.baud() == 57600);
+	}
+
+	SECTION("the handshake times out without acknowledgement") {
+		REQUIRE(transport.handshake(iov, 3, 57600, 50) == -1);
+		REQUIRE(errno == ETIMEDOUT);
+		REQUIRE(transport.baud() == Linux::HANDSHAKE_BAUD);
+	}
+}
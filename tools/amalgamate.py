@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+amalgamate.py
+
+Concatenates the framing side of the library - Checksum, Framing,
+FrameWriter, FrameBuffer, GatherFraming and Descriptor, with their
+definitions - into a single self-contained, header-only header.
+
+Usage: amalgamate.py [-o OUTPUT]
+
+Library headers are inlined recursively, in include order, each one once.
+System headers are kept as includes, each one once. The result defines
+EV3UARTGENERATOR_HEADER_ONLY, so the *_impl.hpp definitions are inlined
+as well, and nothing has to be compiled or linked besides the user's own
+sources.
+
+Copyright Shenghao Yang, 2018
+
+See LICENSE for more details
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+ROOTS = ("sensor_descriptor.hpp", "frame_buffer.hpp", "gather_framing.hpp")
+INCLUDE = re.compile(r'^\s*#include\s*<([^>]+)>')
+
+PROLOGUE = """\
+/**
+ * \\file EV3UartGenerator_amalgamated.hpp
+ *
+ * Single header, header-only amalgamation of the EV3UartGenerator framing
+ * functions, generated by tools/amalgamate.py from: {roots}
+ *
+ * Do not edit - regenerate instead.
+ *
+ * \\copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#ifndef EV3UARTGENERATOR_AMALGAMATED_HPP_
+#define EV3UARTGENERATOR_AMALGAMATED_HPP_
+
+#if defined(EV3UARTGENERATOR_HEADER_ONLY) && !EV3UARTGENERATOR_HEADER_ONLY
+#error "The amalgamated header is always header-only"
+#endif
+#undef EV3UARTGENERATOR_HEADER_ONLY
+#define EV3UARTGENERATOR_HEADER_ONLY 1
+"""
+
+EPILOGUE = """
+#endif /* EV3UARTGENERATOR_AMALGAMATED_HPP_ */
+"""
+
+
+class Amalgamation:
+    def __init__(self):
+        self.seen = set()
+        self.lines = []
+
+    def add(self, name):
+        if name in self.seen:
+            return
+        self.seen.add(name)
+        path = os.path.join(ROOT, name)
+        if not os.path.isfile(path):
+            self.lines.append("#include <%s>\n" % name)
+            return
+
+        self.lines.append("\n/* ---- %s ---- */\n\n" % name)
+        with open(path) as source:
+            for line in source:
+                match = INCLUDE.match(line)
+                if match:
+                    self.add(match.group(1))
+                else:
+                    self.lines.append(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("-o", "--output", help="output file (default stdout)")
+    args = parser.parse_args()
+
+    amalgamation = Amalgamation()
+    for root in ROOTS:
+        amalgamation.add(root)
+
+    text = (PROLOGUE.format(roots=", ".join(ROOTS))
+            + "".join(amalgamation.lines) + EPILOGUE)
+    if args.output:
+        with open(args.output, "w") as output:
+            output.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
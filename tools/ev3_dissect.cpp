@@ -0,0 +1,360 @@
+/**
+ * \file ev3_dissect.cpp
+ *
+ * Dissects captures of UART protocol communications into annotated
+ * messages.
+ *
+ * Usage: <tt>ev3_dissect [--format=text|json|msc] [--from-ev3]
+ * [--label=NAME] [CAPTURE]</tt>
+ *
+ * Reads the raw bytes of \c CAPTURE (or standard input), splits them into
+ * messages with \ref Decoding, interprets every message with \ref
+ * Dissection, and prints one record per message:
+ * - \c text (default): offset, message and any issues found, one line each
+ * - \c json: one JSON object per line (JSON Lines)
+ * - \c msc: an mscgen sequence chart, like the ones under
+ *   \c doc/reference_bitstreams/
+ *
+ * Bytes that do not belong to any message, including messages with bad
+ * checksums, are reported as discarded, and so are incomplete messages at
+ * the end of the capture. The capture is read in fixed size chunks, so
+ * captures of any size are dissected in constant memory.
+ *
+ * \c --from-ev3 marks the capture as sent by the EV3 rather than by the
+ * sensor, and \c --label names the sensor, in mscgen charts.
+ *
+ * Exits with 1 if anything was discarded or any issue was found.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <dissector.hpp>
+#include <decoding.hpp>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	constexpr size_t CHUNK_SIZE { 0x10000 };
+
+	const char* const ISSUES[] { "LENGTH", "PADDING", "VALUE", "NO_FORMAT" };
+
+	void append(std::string& text, const char* format, ...) {
+		char part[0x40];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(part, sizeof(part), format, args);
+		va_end(args);
+		text += part;
+	}
+
+	/**
+	 * @return message as in the mscgen charts, e.g.
+	 * "INFO MODE 4 SPAN-RAW 0 to 1020.188"
+	 */
+	std::string label(const Dissection::Message& message) {
+		const char* const kind { message.kind };
+		std::string text;
+		if (strncmp(kind, "INFO ", 5) == 0)
+			append(text, "INFO MODE %u %s", message.mode, kind + 5);
+		else
+			text = kind;
+
+		if (message.has(Dissection::Issue::LENGTH)) {
+			// Contents could not be read
+		} else if (strcmp(kind, "CMD TYPE") == 0) {
+			append(text, " 0x%02x", message.value);
+		} else if (strcmp(kind, "CMD MODES") == 0) {
+			append(text, " 0x%02x 0x%02x", message.value, message.views);
+		} else if (strcmp(kind, "CMD SPEED") == 0) {
+			append(text, " %u baud", message.value);
+		} else if (strcmp(kind, "CMD SELECT") == 0) {
+			append(text, " MODE %u", message.mode);
+		} else if (strcmp(kind, "CMD WRITE") == 0) {
+			for (uint8_t i = 0; i < message.frame.payload_size(); i++)
+				append(text, " 0x%02x", message.frame.payload()[i]);
+		} else if ((strcmp(kind, "INFO NAME") == 0)
+				|| (strcmp(kind, "INFO SYMBOL") == 0)) {
+			text += std::string(" ") + message.text;
+		} else if (strncmp(kind, "INFO SPAN", 9) == 0) {
+			append(text, " %.7g to %.7g", message.lower, message.upper);
+		} else if (strcmp(kind, "INFO FORMAT") == 0) {
+			append(text, " %u ELEMS %s WIDTH %u DECIMALS %u", message.elems,
+					Dissection::data_type_name(message.data_type),
+					message.width, message.decimals);
+		} else if (strcmp(kind, "DATA") == 0) {
+			append(text, " MODE %u", message.mode);
+			for (uint8_t i = 0; i < message.elems; i++) {
+				if (message.data_type == Magics::INFO_DTYPE::F32)
+					append(text, " %.7g", message.float_sample(i));
+				else
+					append(text, " %d", message.integer_sample(i));
+			}
+		}
+		return text;
+	}
+
+	/**
+	 * @return issues found in a message, e.g. " LENGTH PADDING"
+	 */
+	std::string issues(const Dissection::Message& message) {
+		std::string text;
+		for (uint8_t i = 0; i < (sizeof(ISSUES) / sizeof(ISSUES[0])); i++) {
+			if (message.issues & (0x01 << i))
+				text += std::string(" ") + ISSUES[i];
+		}
+		return text;
+	}
+
+	/**
+	 * @return string as a quoted JSON string
+	 */
+	std::string quote(const char* text) {
+		std::string quoted { "\"" };
+		for (; *text != '\0'; text++) {
+			const unsigned char c { static_cast<unsigned char>(*text) };
+			char escape[8];
+			if ((c == '"') || (c == '\\')) {
+				quoted += '\\';
+				quoted += c;
+			} else if ((c < 0x20) || (c >= 0x7f)) {
+				snprintf(escape, sizeof(escape), "\\u%04x", c);
+				quoted += escape;
+			} else {
+				quoted += c;
+			}
+		}
+		return quoted + "\"";
+	}
+
+	/**
+	 * @return contents of a message as JSON members, e.g.
+	 * ", \"mode\": 4, \"lower\": 0, \"upper\": 1020.188"
+	 */
+	std::string members(const Dissection::Message& message) {
+		const char* const kind { message.kind };
+		std::string text;
+		if ((strncmp(kind, "INFO", 4) == 0) || (strcmp(kind, "DATA") == 0)
+				|| (strcmp(kind, "CMD SELECT") == 0))
+			append(text, ", \"mode\": %u", message.mode);
+
+		if (message.has(Dissection::Issue::LENGTH)) {
+			// Contents could not be read
+		} else if ((strcmp(kind, "CMD TYPE") == 0)
+				|| (strcmp(kind, "CMD SPEED") == 0)) {
+			append(text, ", \"value\": %u", message.value);
+		} else if (strcmp(kind, "CMD MODES") == 0) {
+			append(text, ", \"value\": %u, \"views\": %u", message.value,
+					message.views);
+		} else if ((strcmp(kind, "INFO NAME") == 0)
+				|| (strcmp(kind, "INFO SYMBOL") == 0)) {
+			text += ", \"text\": " + quote(message.text);
+		} else if (strncmp(kind, "INFO SPAN", 9) == 0) {
+			append(text, ", \"lower\": %.7g, \"upper\": %.7g", message.lower,
+					message.upper);
+		} else if (strcmp(kind, "INFO FORMAT") == 0) {
+			append(text, ", \"elems\": %u, \"data_type\": \"%s\", "
+					"\"width\": %u, \"decimals\": %u", message.elems,
+					Dissection::data_type_name(message.data_type),
+					message.width, message.decimals);
+		} else if ((strcmp(kind, "DATA") == 0)
+				&& !message.has(Dissection::Issue::NO_FORMAT)) {
+			text += ", \"samples\": [";
+			for (uint8_t i = 0; i < message.elems; i++) {
+				if (message.data_type == Magics::INFO_DTYPE::F32)
+					append(text, "%s%.7g", i ? ", " : "", message.float_sample(i));
+				else
+					append(text, "%s%d", i ? ", " : "", message.integer_sample(i));
+			}
+			text += "]";
+		}
+		return text;
+	}
+
+	/**
+	 * Output format.
+	 */
+	class Printer {
+	public:
+		virtual ~Printer() = default;
+		virtual void message(uint64_t offset, const Dissection::Message& message) = 0;
+		virtual void discarded(uint64_t offset, uint64_t count, uint32_t checksum_errors) = 0;
+		virtual void finish() {
+		}
+	};
+
+	class TextPrinter : public Printer {
+	public:
+		void message(uint64_t offset, const Dissection::Message& message) override {
+			const std::string flags { issues(message) };
+			printf("%08llx  %s%s%s\n", static_cast<unsigned long long>(offset),
+					label(message).c_str(), flags.empty() ? "" : "  !",
+					flags.c_str());
+		}
+
+		void discarded(uint64_t offset, uint64_t count,
+				uint32_t checksum_errors) override {
+			printf("%08llx  discarded %llu bytes, %u bad checksums\n",
+					static_cast<unsigned long long>(offset),
+					static_cast<unsigned long long>(count), checksum_errors);
+		}
+	};
+
+	class JsonPrinter : public Printer {
+	public:
+		void message(uint64_t offset, const Dissection::Message& message) override {
+			const Decoding::Frame& frame { message.frame };
+			std::string bytes;
+			for (uint8_t i = 0; i < frame.size; i++) {
+				char hex[3];
+				snprintf(hex, sizeof(hex), "%02x", frame.data[i]);
+				bytes += hex;
+			}
+			printf("{\"offset\": %llu, \"kind\": \"%s\", \"bytes\": \"%s\"%s, "
+					"\"issues\": [", static_cast<unsigned long long>(offset),
+					message.kind, bytes.c_str(), members(message).c_str());
+			const char* separator { "" };
+			for (uint8_t i = 0; i < (sizeof(ISSUES) / sizeof(ISSUES[0])); i++) {
+				if (message.issues & (0x01 << i)) {
+					printf("%s\"%s\"", separator, ISSUES[i]);
+					separator = ", ";
+				}
+			}
+			printf("]}\n");
+		}
+
+		void discarded(uint64_t offset, uint64_t count,
+				uint32_t checksum_errors) override {
+			printf("{\"offset\": %llu, \"discarded\": %llu, "
+					"\"checksum_errors\": %u}\n",
+					static_cast<unsigned long long>(offset),
+					static_cast<unsigned long long>(count), checksum_errors);
+		}
+	};
+
+	class MscPrinter : public Printer {
+	public:
+		MscPrinter(const char* name, bool from_ev3)
+			: arc { from_ev3 ? "ev3->sensor" : "sensor->ev3" } {
+			printf("msc {\n    wordwraparcs = \"1\";\n\n"
+					"    sensor [label = %s], ev3 [label = \"EV3\"];\n",
+					quote(name).c_str());
+		}
+
+		void message(uint64_t, const Dissection::Message& message) override {
+			if (strcmp(message.kind, "INFO NAME") == 0)
+				printf("\n"); // Every mode starts with its name
+			std::string text { label(message) };
+			const std::string flags { issues(message) };
+			if (!flags.empty())
+				text += " (" + flags.substr(1) + ")";
+			printf("    %s [label = %s];\n", arc, quote(text.c_str()).c_str());
+		}
+
+		void discarded(uint64_t, uint64_t count,
+				uint32_t checksum_errors) override {
+			printf("    --- [label = \"discarded %llu bytes, %u bad checksums\"];\n",
+					static_cast<unsigned long long>(count), checksum_errors);
+		}
+
+		void finish() override {
+			printf("}\n");
+		}
+
+	private:
+		const char* const arc;
+	};
+}
+
+int main(int argc, char** argv) {
+	const char* format { "text" };
+	const char* name { "Sensor" };
+	const char* path { nullptr };
+	bool from_ev3 { false };
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--format=", 9) == 0)
+			format = argv[i] + 9;
+		else if (strncmp(argv[i], "--label=", 8) == 0)
+			name = argv[i] + 8;
+		else if (strcmp(argv[i], "--from-ev3") == 0)
+			from_ev3 = true;
+		else if ((argv[i][0] != '-') && (path == nullptr))
+			path = argv[i];
+		else
+			format = nullptr;
+	}
+
+	const std::string output { format ? format : "" };
+	if ((output != "text") && (output != "json") && (output != "msc")) {
+		fprintf(stderr, "usage: %s [--format=text|json|msc] [--from-ev3] "
+				"[--label=NAME] [CAPTURE]\n", argv[0]);
+		return 1;
+	}
+
+	FILE* const capture { path ? fopen(path, "rb") : stdin };
+	if (capture == nullptr) {
+		perror(path);
+		return 1;
+	}
+	std::unique_ptr<Printer> printer;
+	if (output == "text")
+		printer.reset(new TextPrinter);
+	else if (output == "json")
+		printer.reset(new JsonPrinter);
+	else
+		printer.reset(new MscPrinter(name, from_ev3));
+
+	static uint8_t chunk[CHUNK_SIZE];
+	Decoding::FrameDecoder decoder;
+	Decoding::Frame frame;
+	Dissection::Dissector dissector;
+	Dissection::Message message;
+	uint64_t read { 0 }; ///< Bytes read from the capture
+	uint64_t decoded { 0 }; ///< Bytes of all messages returned by the decoder
+	uint64_t discarded { 0 }; ///< Bytes discarded, as reported so far
+	uint32_t checksum_errors { 0 }; ///< Bad checksums, as reported so far
+	bool clean { true };
+
+	const auto report_discarded = [&](uint64_t now, uint32_t errors_now) {
+		if (now == discarded)
+			return;
+		printer->discarded(decoded + discarded, now - discarded,
+				errors_now - checksum_errors);
+		discarded = now;
+		checksum_errors = errors_now;
+		clean = false;
+	};
+
+	size_t len;
+	while ((len = fread(chunk, 1, sizeof(chunk), capture)) > 0) {
+		read += len;
+		decoder.feed(chunk, len);
+		while (decoder.next(frame)) {
+			// Bytes discarded so far all precede this message
+			report_discarded(decoder.discarded(), decoder.checksum_errors());
+			dissector.dissect(frame, message);
+			printer->message(decoded + discarded, message);
+			decoded += frame.size;
+			clean = clean && (message.issues == 0);
+		}
+	}
+	if (ferror(capture)) {
+		perror(path ? path : "stdin");
+		return 1;
+	}
+	report_discarded(decoder.discarded(), decoder.checksum_errors());
+	// Whatever is left is an incomplete message at the end of the capture
+	report_discarded(read - decoded, checksum_errors);
+	printer->finish();
+
+	if (path)
+		fclose(capture);
+	return clean ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/**
+ * \file ev3_host.cpp
+ *
+ * EV3 emulator on a pseudo-terminal, for end-to-end testing and load
+ * generation against sensors built on this library.
+ *
+ * Usage: <tt>ev3_host [--duration=MS] [--nack=MS] [--select=MS]
+ * [--write=MS] [--write-len=N] [--timeout=MS]</tt>
+ *
+ * Prints the path of the slave side of the pseudo-terminal on the first line
+ * of output - start the sensor under test on that path. Then waits for the
+ * handshake of the sensor, runs the schedule, and prints the handshake and
+ * measurements as JSON.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/host_emulator.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	bool option(const char* arg, const char* name, long& value) {
+		const size_t len { strlen(name) };
+		if (strncmp(arg, name, len) != 0)
+			return false;
+		value = strtol(arg + len, nullptr, 10);
+		return true;
+	}
+
+	void print_latency(const char* name, const Linux::LatencyStats& stats) {
+		printf("  \"%s\": { \"count\": %llu, \"min_us\": %llu, "
+				"\"mean_us\": %llu, \"max_us\": %llu },\n", name,
+				static_cast<unsigned long long>(stats.count),
+				static_cast<unsigned long long>(stats.min),
+				static_cast<unsigned long long>(stats.mean()),
+				static_cast<unsigned long long>(stats.max));
+	}
+}
+
+int main(int argc, char** argv) {
+	Linux::HostSchedule schedule { Linux::DEFAULT_SCHEDULE };
+	long duration { 5000 };
+	long timeout { 30000 };
+
+	for (int i = 1; i < argc; i++) {
+		long value;
+		if (option(argv[i], "--duration=", value))
+			duration = value;
+		else if (option(argv[i], "--timeout=", value))
+			timeout = value;
+		else if (option(argv[i], "--nack=", value))
+			schedule.nack_interval = static_cast<uint16_t>(value);
+		else if (option(argv[i], "--select=", value))
+			schedule.select_interval = static_cast<uint16_t>(value);
+		else if (option(argv[i], "--write=", value))
+			schedule.write_interval = static_cast<uint16_t>(value);
+		else if (option(argv[i], "--write-len=", value))
+			schedule.write_len = static_cast<uint8_t>(value);
+		else {
+			fprintf(stderr, "usage: %s [--duration=MS] [--nack=MS] "
+					"[--select=MS] [--write=MS] [--write-len=N] "
+					"[--timeout=MS]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Linux::HostEmulator host;
+	if (host.open() < 0) {
+		perror("open");
+		return 1;
+	}
+	printf("%s\n", host.slave_path());
+	fflush(stdout);
+
+	if (host.handshake(static_cast<int>(timeout)) < 0) {
+		perror("handshake");
+		return 1;
+	}
+	if (host.run(static_cast<int>(duration), schedule) < 0) {
+		perror("run");
+		return 1;
+	}
+
+	const Linux::HostStats& stats { host.stats() };
+	printf("{\n");
+	printf("  \"type\": %u, \"modes\": %u, \"speed\": %u, \"info_messages\": %u,\n",
+			host.type(), host.modes(), host.speed(), host.info_messages());
+	printf("  \"elapsed_us\": %llu, \"data_messages\": %llu, "
+			"\"data_bytes\": %llu, \"data_malformed\": %llu, "
+			"\"data_per_second\": %.1f,\n",
+			static_cast<unsigned long long>(stats.elapsed),
+			static_cast<unsigned long long>(stats.data_messages),
+			static_cast<unsigned long long>(stats.data_bytes),
+			static_cast<unsigned long long>(stats.data_malformed),
+			stats.data_rate());
+	printf("  \"nacks\": %llu, \"selects\": %llu, \"writes\": %llu,\n",
+			static_cast<unsigned long long>(stats.nacks),
+			static_cast<unsigned long long>(stats.selects),
+			static_cast<unsigned long long>(stats.writes));
+	print_latency("nack_rtt", stats.nack_rtt);
+	print_latency("select_rtt", stats.select_rtt);
+	printf("  \"discarded\": %llu, \"checksum_errors\": %llu\n}\n",
+			static_cast<unsigned long long>(stats.discarded),
+			static_cast<unsigned long long>(stats.checksum_errors));
+	return 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * \file sensor_farm.cpp
+ *
+ * Daemon emulating LEGO sensors on any number of ttys at once.
+ *
+ * Usage: <tt>sensor_farm [--interval=MS] [--batch] [SENSOR:]TTY...</tt>
+ *
+ * \c SENSOR is one of \c color (default), \c ultrasonic or \c gyro. Readings
+ * are a ramp, which increments with every \c DATA message. With \c --batch,
+ * the reads and writes of all ports are batched (see \ref IoBatch), with
+ * \c io_uring if available.
+ *
+ * Prints the counters of every port on \c SIGINT / \c SIGTERM, and exits.
+ *
+ * \copyright Shenghao Yang, 2018
+ *
+ * See LICENSE for more details
+ */
+
+#include <linux/sensor_farm.hpp>
+#include <lego_sensors.hpp>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+	using namespace EV3UartGenerator;
+
+	constexpr uint8_t DTYPE_SIZES[] { 1, 2, 4, 4 }; ///< Sizes of S8, S16, S32 and F32
+
+	volatile std::sig_atomic_t stop { 0 };
+
+	void on_signal(int) {
+		stop = 1;
+	}
+
+	/**
+	 * Ramp of readings, in the data format of the selected mode.
+	 */
+	class RampSampler : public Linux::Sampler {
+	public:
+		uint8_t sample(size_t port, uint8_t mode, uint8_t* payload) override {
+			const Descriptor::ModeDescriptor& desc {
+				sensors[port]->mode_table[mode] };
+			const uint8_t size { DTYPE_SIZES[static_cast<uint8_t>(desc.data_type)] };
+			const uint8_t len { static_cast<uint8_t>(desc.elems * size) };
+			const uint8_t value { counters[port]++ };
+			memset(payload, 0, len);
+			for (uint8_t elem = 0; elem < desc.elems; elem++)
+				payload[elem * size] = value;
+			return len;
+		}
+
+		std::vector<const Descriptor::SensorDescriptor*> sensors;
+		std::vector<uint8_t> counters;
+	};
+}
+
+int main(int argc, char** argv) {
+	StateMachine::Timing timing { StateMachine::DEFAULT_TIMING };
+	RampSampler sampler;
+	std::vector<std::string> paths;
+	bool batch { false };
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--interval=", 11) == 0) {
+			timing.data_interval = static_cast<uint16_t>(atoi(argv[i] + 11));
+			continue;
+		}
+		if (strcmp(argv[i], "--batch") == 0) {
+			batch = true;
+			continue;
+		}
+		std::string arg { argv[i] };
+		const size_t colon { arg.find(':') };
+		const std::string name { (colon == std::string::npos) ? "color"
+				: arg.substr(0, colon) };
+		const Descriptor::SensorDescriptor* sensor {
+			LegoSensors::find(name.c_str()) };
+		if (sensor == nullptr) {
+			fprintf(stderr, "unknown sensor: %s\n", name.c_str());
+			return 1;
+		}
+		sampler.sensors.push_back(sensor);
+		sampler.counters.push_back(0);
+		paths.push_back((colon == std::string::npos) ? arg
+				: arg.substr(colon + 1));
+	}
+	if (paths.empty()) {
+		fprintf(stderr, "usage: %s [--interval=MS] [--batch] [SENSOR:]TTY...\n",
+				argv[0]);
+		return 1;
+	}
+
+	Linux::SensorFarm farm { sampler, timing };
+	if (batch) {
+		const bool uring { farm.batch_io() == Linux::IoBackend::URING };
+		fprintf(stderr, "batching I/O with %s\n",
+				uring ? "io_uring" : "plain system calls");
+	}
+	for (size_t i = 0; i < paths.size(); i++) {
+		if (farm.add(paths[i].c_str(), *sampler.sensors[i]) < 0) {
+			perror(paths[i].c_str());
+			return 1;
+		}
+	}
+
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+	while (!stop && (farm.active() > 0)) {
+		if (farm.run_once(-1) < 0) {
+			perror("epoll_wait");
+			return 1;
+		}
+	}
+
+	for (size_t i = 0; i < farm.size(); i++) {
+		const Linux::PortStats& stats { farm.stats(i) };
+		printf("%s: handshakes %u, received %llu, sent %llu, dropped %llu\n",
+				paths[i].c_str(), stats.handshakes,
+				static_cast<unsigned long long>(stats.bytes_received),
+				static_cast<unsigned long long>(stats.bytes_sent),
+				static_cast<unsigned long long>(stats.bytes_dropped));
+	}
+	return 0;
+}